@@ -61,7 +61,7 @@
 // -----------------------------------------------------------------------------
 namespace Global
 {
-string error = error;
+thread_local string error;
 
 #ifdef GIT_DESCRIPTION
 string sc_rev = GIT_DESCRIPTION;
@@ -243,8 +243,8 @@ public:
 
 		// Last 10 log lines
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = Log::history();
-		for (auto a = log.size() - 10; a < log.size(); a++)
+		auto log = Log::history();
+		for (auto a = log.size() > 10 ? log.size() - 10 : 0; a < log.size(); a++)
 			trace_ += log[a].message + "\n";
 
 		// Add stack trace text area
@@ -630,8 +630,9 @@ bool Archive::save(string_view filename)
 		{
 			// No filename is given, but the archive has a filename, so overwrite it (and make a backup)
 
-			// Create backup
-			if (backup_archives && wxFileName::FileExists(filename_) && save_backup)
+			// Create backup (unless only appending changes to the file, which
+			// leaves the existing data intact until the save is complete)
+			if (backup_archives && wxFileName::FileExists(filename_) && save_backup && !canAppendSave(filename_))
 			{
 				// Copy current file contents to new backup file
 				auto bakfile = filename_ + ".bak";
@@ -1283,44 +1284,10 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 		dir = dir_root_.get();
 	StrUtil::upperIP(options.match_name); // Force case-insensitive
 
-	// Begin search
-
 	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
-	{
-		auto entry = dir->entryAt(a);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!StrUtil::matches(check_name, options.match_name))
-				continue;
-		}
-
-		// Check namespace
-		if (!options.match_namespace.empty())
-		{
-			if (!StrUtil::equalCI(detectNamespace(entry), options.match_namespace))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		return entry;
-	}
+	for (auto entry : searchCandidates(dir, options))
+		if (entryMatches(entry, options))
+			return entry;
 
 	// Search subdirectories (if needed)
 	if (options.search_subdirs)
@@ -1353,44 +1320,11 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 		dir = dir_root_.get();
 	StrUtil::upperIP(options.match_name); // Force case-insensitive
 
-	// Begin search
-
 	// Search entries (bottom-up)
-	for (int a = dir->numEntries() - 1; a >= 0; a--)
-	{
-		auto entry = dir->entryAt(a);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!StrUtil::matches(check_name, options.match_name))
-				continue;
-		}
-
-		// Check namespace
-		if (!options.match_namespace.empty())
-		{
-			if (!StrUtil::equalCI(detectNamespace(entry), options.match_namespace))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		return entry;
-	}
+	auto candidates = searchCandidates(dir, options);
+	for (auto i = candidates.rbegin(); i != candidates.rend(); ++i)
+		if (entryMatches(*i, options))
+			return *i;
 
 	// Search subdirectories (if needed) (bottom-up)
 	if (options.search_subdirs)
@@ -1423,44 +1357,10 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 	vector<ArchiveEntry*> ret;
 	StrUtil::upperIP(options.match_name); // Force case-insensitive
 
-	// Begin search
-
 	// Search entries
-	for (unsigned a = 0; a < dir->numEntries(); a++)
-	{
-		auto entry = dir->entryAt(a);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			// Cut extension if ignoring
-			auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
-			if (!StrUtil::matches(check_name, options.match_name))
-				continue;
-		}
-
-		// Check namespace
-		if (!options.match_namespace.empty())
-		{
-			if (!StrUtil::equalCI(detectNamespace(entry), options.match_namespace))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		ret.push_back(entry);
-	}
+	for (auto entry : searchCandidates(dir, options))
+		if (entryMatches(entry, options))
+			ret.push_back(entry);
 
 	// Search subdirectories (if needed)
 	if (options.search_subdirs)
@@ -1516,6 +1416,69 @@ vector<ArchiveEntry*> Archive::findModifiedEntries(ArchiveDir* dir)
 	return ret;
 }
 
+// -----------------------------------------------------------------------------
+// Returns entries in [dir] (not including subdirs) that could match the search
+// criteria in [options], in directory order. Candidates are narrowed down
+// using the directory's type and name indices, and each still needs checking
+// with entryMatches.
+// In an archive with directories, every entry within a directory is in the
+// same namespace, so the namespace is only checked once here
+// -----------------------------------------------------------------------------
+vector<ArchiveEntry*> Archive::searchCandidates(ArchiveDir* dir, const SearchOptions& options)
+{
+	vector<ArchiveEntry*> candidates;
+	dir->searchCandidates(candidates, options.match_type, options.match_name);
+
+	// Check namespace
+	if (!options.match_namespace.empty() && !isTreeless() && !candidates.empty())
+	{
+		if (!StrUtil::equalCI(detectNamespace(candidates[0]), options.match_namespace))
+			candidates.clear();
+	}
+
+	return candidates;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [entry] matches the search criteria in [options].
+// A name pattern without a leading wildcard must match from the start of the
+// entry name
+// -----------------------------------------------------------------------------
+bool Archive::entryMatches(ArchiveEntry* entry, const SearchOptions& options)
+{
+	// Check type
+	if (options.match_type)
+	{
+		if (entry->type() == EntryType::unknownType())
+		{
+			if (!options.match_type->isThisType(*entry))
+				return false;
+		}
+		else if (options.match_type != entry->type())
+			return false;
+	}
+
+	// Check name
+	if (!options.match_name.empty())
+	{
+		// Cut extension if ignoring
+		auto check_name = options.ignore_ext ? entry->upperNameNoExt() : entry->upperName();
+		auto prefix     = string_view{ options.match_name }.substr(0, options.match_name.find_first_of("*?"));
+		if (!StrUtil::startsWith(check_name, prefix) || !StrUtil::matches(check_name, options.match_name))
+			return false;
+	}
+
+	// Check namespace (already done per directory by searchCandidates unless
+	// the archive is treeless)
+	if (!options.match_namespace.empty() && isTreeless())
+	{
+		if (!StrUtil::equalCI(detectNamespace(entry), options.match_namespace))
+			return false;
+	}
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Blocks or unblocks signals for archive/entry modifications
 // -----------------------------------------------------------------------------
@@ -80,6 +80,7 @@ public:
 	virtual bool write(MemChunk& mc, bool update = true) = 0;     // Write to MemChunk
 	virtual bool write(string_view filename, bool update = true); // Write to File
 	virtual bool save(string_view filename = "");                 // Save archive
+	virtual bool canAppendSave(string_view filename) { return false; }
 
 	// Misc
 	virtual bool     loadEntryData(ArchiveEntry* entry) = 0;
@@ -180,6 +181,10 @@ protected:
 	bool                   on_disk_; // Specifies whether the archive exists on disk (as opposed to being newly created)
 	bool                   read_only_; // If true, the archive cannot be modified
 
+	// Search helpers
+	vector<ArchiveEntry*> searchCandidates(ArchiveDir* dir, const SearchOptions& options);
+	bool                  entryMatches(ArchiveEntry* entry, const SearchOptions& options);
+
 private:
 	bool                   modified_;
 	shared_ptr<ArchiveDir> dir_root_;
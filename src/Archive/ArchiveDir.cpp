@@ -39,6 +39,37 @@
 #include <filesystem>
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Removes [entry] from the bucket for [key] in [index], removing the bucket
+// itself if it ends up empty
+// -----------------------------------------------------------------------------
+template<typename Index, typename Key> void removeFromIndex(Index& index, const Key& key, ArchiveEntry* entry)
+{
+	auto i = index.find(key);
+	if (i == index.end())
+		return;
+
+	auto& bucket = i->second;
+	for (unsigned a = 0; a < bucket.size(); a++)
+		if (bucket[a] == entry)
+		{
+			bucket[a] = bucket.back();
+			bucket.pop_back();
+			break;
+		}
+
+	if (bucket.empty())
+		index.erase(i);
+}
+} // namespace
+
 
 // -----------------------------------------------------------------------------
 //
@@ -110,8 +141,14 @@ int ArchiveDir::entryIndex(ArchiveEntry* entry, size_t startfrom) const
 	if (!entry)
 		return -1;
 
-	// Search for it
+	// Entry positions are kept up to date, so this should always be correct
 	const size_t size = entries_.size();
+	if (entry->index_guess_ < size && entries_[entry->index_guess_].get() == entry)
+		return entry->index_guess_ >= startfrom ? (int)entry->index_guess_ : -1;
+	if (entry->parent_ != this)
+		return -1;
+
+	// Search for it
 	if (entry->index_guess_ < startfrom || entry->index_guess_ >= size)
 	{
 		for (auto a = startfrom; a < size; a++)
@@ -206,16 +243,7 @@ ArchiveEntry* ArchiveDir::entry(string_view name, bool cut_ext) const
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (StrUtil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry.get();
-	}
-
-	// Not found
-	return nullptr;
+	return findEntry(name, cut_ext);
 }
 
 // -----------------------------------------------------------------------------
@@ -228,16 +256,8 @@ shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(string_view name, bool cut_ext)
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (StrUtil::equalCI(cut_ext ? entry->nameNoExt() : entry->name(), name))
-			return entry;
-	}
-
-	// Not found
-	return nullptr;
+	auto entry = findEntry(name, cut_ext);
+	return entry ? entries_[entry->index_guess_] : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -247,9 +267,9 @@ shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(string_view name, bool cut_ext)
 shared_ptr<ArchiveEntry> ArchiveDir::sharedEntry(ArchiveEntry* entry) const
 {
 	// Find entry
-	for (auto& e : entries_)
-		if (entry == e.get())
-			return e;
+	auto index = entryIndex(entry);
+	if (index >= 0)
+		return entries_[index];
 
 	// Not in this ArchiveDir
 	return nullptr;
@@ -289,9 +309,17 @@ bool ArchiveDir::addEntry(shared_ptr<ArchiveEntry> entry, unsigned index)
 
 	// Check index
 	if (index >= entries_.size())
+	{
 		entries_.push_back(entry); // 'Invalid' index, add to end of list
+		entry->index_guess_ = entries_.size() - 1;
+	}
 	else
+	{
 		entries_.insert(entries_.begin() + index, entry); // Add it at index
+		updateEntryPositions(index);
+	}
+	indexEntryName(entry.get());
+	indexEntryType(entry.get());
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -311,10 +339,13 @@ bool ArchiveDir::removeEntry(unsigned index)
 		return false;
 
 	// De-parent entry
+	unindexEntryName(entries_[index].get(), entries_[index]->upperName());
+	unindexEntryType(entries_[index].get(), entries_[index]->type());
 	entries_[index]->parent_ = nullptr;
 
 	// Remove it from the entry list
 	entries_.erase(entries_.begin() + index);
+	updateEntryPositions(index);
 
 	return true;
 }
@@ -331,6 +362,8 @@ bool ArchiveDir::swapEntries(unsigned index1, unsigned index2)
 
 	// Swap entries
 	entries_[index1].swap(entries_[index2]);
+	entries_[index1]->index_guess_ = index1;
+	entries_[index2]->index_guess_ = index2;
 
 	return true;
 }
@@ -435,6 +468,9 @@ void ArchiveDir::clear()
 {
 	entries_.clear();
 	subdirs_.clear();
+	name_index_.clear();
+	name_noext_index_.clear();
+	type_index_.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -498,32 +534,188 @@ bool ArchiveDir::exportTo(string_view path)
 // -----------------------------------------------------------------------------
 void ArchiveDir::ensureUniqueName(ArchiveEntry* entry)
 {
-	unsigned      index     = 0;
-	unsigned      number    = 0;
-	const auto    n_entries = entries_.size();
+	unsigned      number = 0;
 	StrUtil::Path fn(entry->name());
 	auto          name = fn.fileName();
-	while (index < n_entries)
+	while (true)
+	{
+		// Check for any other entry with the name
+		auto i     = name_index_.find(StrUtil::upper(name));
+		bool taken = false;
+		if (i != name_index_.end())
+			for (auto other : i->second)
+				if (other != entry)
+				{
+					taken = true;
+					break;
+				}
+
+		if (!taken)
+			break;
+
+		fn.setFileName(fmt::format("{}{}", entry->nameNoExt(), ++number));
+		name = fn.fileName();
+	}
+
+	if (number > 0)
+		entry->rename(name);
+}
+
+// -----------------------------------------------------------------------------
+// Updates the position (index guess) of each entry from index [from] onwards,
+// after entries were added or removed
+// -----------------------------------------------------------------------------
+void ArchiveDir::updateEntryPositions(unsigned from) const
+{
+	for (auto a = from; a < entries_.size(); a++)
+		entries_[a]->index_guess_ = a;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the first entry matching [name] (case-insensitive) in this
+// directory, ignoring entry extensions if [cut_ext] is true
+// -----------------------------------------------------------------------------
+ArchiveEntry* ArchiveDir::findEntry(string_view name, bool cut_ext) const
+{
+	auto& index = cut_ext ? name_noext_index_ : name_index_;
+	auto  i     = index.find(StrUtil::upper(name));
+	if (i == index.end())
+		return nullptr;
+
+	// Get the first matching entry (by position) if there are multiple
+	ArchiveEntry* first = nullptr;
+	for (auto entry : i->second)
+		if (!first || entry->index_guess_ < first->index_guess_)
+			first = entry;
+
+	return first;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] to the name lookup indices
+// -----------------------------------------------------------------------------
+void ArchiveDir::indexEntryName(ArchiveEntry* entry)
+{
+	name_index_[entry->upperName()].push_back(entry);
+	name_noext_index_[string{ entry->upperNameNoExt() }].push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] from the name lookup indices, where it was indexed as
+// [upper_name]
+// -----------------------------------------------------------------------------
+void ArchiveDir::unindexEntryName(ArchiveEntry* entry, const string& upper_name)
+{
+	removeFromIndex(name_index_, upper_name, entry);
+	removeFromIndex(name_noext_index_, upper_name.substr(0, upper_name.find('.')), entry);
+}
+
+// -----------------------------------------------------------------------------
+// Called when [entry] is renamed from [old_upper_name], updates the name
+// lookup indices if it is in this directory
+// -----------------------------------------------------------------------------
+void ArchiveDir::entryRenamed(ArchiveEntry* entry, const string& old_upper_name)
+{
+	if (entry->index_guess_ >= entries_.size() || entries_[entry->index_guess_].get() != entry)
+		return;
+
+	unindexEntryName(entry, old_upper_name);
+	indexEntryName(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] to the type lookup index
+// -----------------------------------------------------------------------------
+void ArchiveDir::indexEntryType(ArchiveEntry* entry)
+{
+	type_index_[entry->type()].push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] from the type lookup index, where it was indexed as [type]
+// -----------------------------------------------------------------------------
+void ArchiveDir::unindexEntryType(ArchiveEntry* entry, EntryType* type)
+{
+	removeFromIndex(type_index_, type, entry);
+}
+
+// -----------------------------------------------------------------------------
+// Called when [entry]'s type is changed from [old_type], updates the type
+// lookup index if it is in this directory
+// -----------------------------------------------------------------------------
+void ArchiveDir::entryTypeChanged(ArchiveEntry* entry, EntryType* old_type)
+{
+	if (entry->index_guess_ >= entries_.size() || entries_[entry->index_guess_].get() != entry)
+		return;
+
+	unindexEntryType(entry, old_type);
+	indexEntryType(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Adds entries in this directory that could match [type] and [match_name] (an
+// upper case wildcard pattern) to [list], in directory order.
+// Candidates come from whichever of the type index or the name index (by the
+// pattern's prefix before any wildcard) gives fewer entries, so they still need
+// to be fully checked against the search.
+// Entries of unknown type are always candidates when searching by type, since
+// they may still be detected as [type]
+// -----------------------------------------------------------------------------
+void ArchiveDir::searchCandidates(vector<ArchiveEntry*>& list, EntryType* type, string_view match_name) const
+{
+	// Get entries whose name begins with the pattern prefix
+	auto                  prefix = match_name.substr(0, match_name.find_first_of("*?"));
+	vector<ArchiveEntry*> name_matches;
+	if (!prefix.empty())
+	{
+		for (auto i = name_index_.lower_bound(string{ prefix });
+			 i != name_index_.end() && StrUtil::startsWith(i->first, prefix);
+			 ++i)
+			name_matches.insert(name_matches.end(), i->second.begin(), i->second.end());
+	}
+
+	// Get the type index buckets to check
+	const vector<ArchiveEntry*>* type_buckets[2] = { nullptr, nullptr };
+	size_t                       type_count      = 0;
+	if (type)
 	{
-		if (entries_[index].get() == entry)
+		auto unknown = EntryType::unknownType();
+		auto i       = type_index_.find(type);
+		if (i != type_index_.end())
 		{
-			index++;
-			continue;
+			type_buckets[0] = &i->second;
+			type_count += i->second.size();
 		}
-
-		if (StrUtil::equalCI(entries_[index]->name(), name))
+		if (type != unknown && (i = type_index_.find(unknown)) != type_index_.end())
 		{
-			fn.setFileName(fmt::format("{}{}", entry->nameNoExt(), ++number));
-			name  = fn.fileName();
-			index = 0;
-			continue;
+			type_buckets[1] = &i->second;
+			type_count += i->second.size();
 		}
+	}
 
-		index++;
+	// Neither index narrows the search, all entries are candidates
+	if (prefix.empty() && !type)
+	{
+		for (auto& entry : entries_)
+			list.push_back(entry.get());
+		return;
 	}
 
-	if (number > 0)
-		entry->rename(name);
+	// Add candidates from the smaller set
+	auto start = list.size();
+	if (type && (prefix.empty() || type_count < name_matches.size()))
+	{
+		for (auto bucket : type_buckets)
+			if (bucket)
+				list.insert(list.end(), bucket->begin(), bucket->end());
+	}
+	else
+		list.insert(list.end(), name_matches.begin(), name_matches.end());
+
+	// Sort into directory order
+	std::sort(list.begin() + start, list.end(), [](ArchiveEntry* left, ArchiveEntry* right) {
+		return left->index_guess_ < right->index_guess_;
+	});
 }
 
 
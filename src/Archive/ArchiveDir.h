@@ -1,10 +1,12 @@
 #pragma once
 
 #include "ArchiveEntry.h"
+#include <unordered_map>
 
 class ArchiveDir
 {
 	friend class Archive;
+	friend class ArchiveEntry;
 
 public:
 	ArchiveDir(string_view name, const shared_ptr<ArchiveDir>& parent = nullptr, Archive* archive = nullptr);
@@ -76,5 +78,22 @@ private:
 	vector<shared_ptr<ArchiveDir>>   subdirs_;
 	bool                             allow_duplicate_names_ = true;
 
-	void ensureUniqueName(ArchiveEntry* entry);
+	// Entry lookup by upper case name (with and without extension) and by type.
+	// Names are kept sorted so they can also be searched by prefix
+	typedef std::map<string, vector<ArchiveEntry*>>              NameIndex;
+	typedef std::unordered_map<EntryType*, vector<ArchiveEntry*>> TypeIndex;
+	NameIndex name_index_;
+	NameIndex name_noext_index_;
+	TypeIndex type_index_;
+
+	void          ensureUniqueName(ArchiveEntry* entry);
+	void          updateEntryPositions(unsigned from = 0) const;
+	ArchiveEntry* findEntry(string_view name, bool cut_ext) const;
+	void          indexEntryName(ArchiveEntry* entry);
+	void          unindexEntryName(ArchiveEntry* entry, const string& upper_name);
+	void          entryRenamed(ArchiveEntry* entry, const string& old_upper_name);
+	void          indexEntryType(ArchiveEntry* entry);
+	void          unindexEntryType(ArchiveEntry* entry, EntryType* type);
+	void          entryTypeChanged(ArchiveEntry* entry, EntryType* old_type);
+	void          searchCandidates(vector<ArchiveEntry*>& list, EntryType* type, string_view match_name) const;
 };
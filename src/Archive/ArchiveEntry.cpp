@@ -161,8 +161,10 @@ string ArchiveEntry::path(bool include_name) const
 // -----------------------------------------------------------------------------
 const uint8_t* ArchiveEntry::rawData(bool allow_load)
 {
-	// Return entry data
-	return data(allow_load).data();
+	// Return entry data (via the const MemChunk accessor, so mapped data isn't
+	// copied)
+	const auto& mc = data(allow_load);
+	return mc.data();
 }
 
 // -----------------------------------------------------------------------------
@@ -225,8 +227,27 @@ int ArchiveEntry::index()
 // -----------------------------------------------------------------------------
 void ArchiveEntry::setName(string_view name)
 {
-	name_       = name;
-	upper_name_ = StrUtil::upper(name);
+	auto old_upper_name = std::move(upper_name_);
+	name_               = name;
+	upper_name_         = StrUtil::upper(name);
+
+	// Update the parent dir's name lookup
+	if (parent_)
+		parent_->entryRenamed(this, old_upper_name);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the entry's type to [type], with detection reliability [r]
+// -----------------------------------------------------------------------------
+void ArchiveEntry::setType(EntryType* type, int r)
+{
+	auto old_type = type_;
+	type_         = type;
+	reliability_  = r;
+
+	// Update the parent dir's type lookup
+	if (parent_ && old_type != type)
+		parent_->entryTypeChanged(this, old_type);
 }
 
 // -----------------------------------------------------------------------------
@@ -325,9 +346,9 @@ void ArchiveEntry::formatName(const ArchiveFormat& format)
 		if (auto pos = name_.find('.'); pos != string::npos)
 			StrUtil::truncateIP(name_, pos);
 
-	// Update upper name
+	// Update upper name (and the parent dir's name lookup)
 	if (changed)
-		upper_name_ = StrUtil::upper(name_);
+		setName(string{ name_ });
 }
 
 // -----------------------------------------------------------------------------
@@ -61,11 +61,7 @@ public:
 	// Modifiers (won't change entry state, except setState of course :P)
 	void setName(string_view name);
 	void setLoaded(bool loaded = true) { data_loaded_ = loaded; }
-	void setType(EntryType* type, int r = 0)
-	{
-		type_        = type;
-		reliability_ = r;
-	}
+	void setType(EntryType* type, int r = 0);
 	void setState(State state, bool silent = false);
 	void setEncryption(Encryption enc) { encrypted_ = enc; }
 	void unloadData();
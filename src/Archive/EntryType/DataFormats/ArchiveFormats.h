@@ -3,7 +3,11 @@
 class WadDataFormat : public EntryDataFormat
 {
 public:
-	WadDataFormat() : EntryDataFormat("archive_wad") {}
+	WadDataFormat() : EntryDataFormat("archive_wad")
+	{
+		addSignature("IWAD");
+		addSignature("PWAD");
+	}
 	~WadDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return WadArchive::isWadArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -12,7 +16,10 @@ public:
 class ZipDataFormat : public EntryDataFormat
 {
 public:
-	ZipDataFormat() : EntryDataFormat("archive_zip") {}
+	ZipDataFormat() : EntryDataFormat("archive_zip")
+	{
+		addSignature("PK\x03\x04");
+	}
 	~ZipDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return ZipArchive::isZipArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -48,7 +55,10 @@ public:
 class PakDataFormat : public EntryDataFormat
 {
 public:
-	PakDataFormat() : EntryDataFormat("archive_pak") {}
+	PakDataFormat() : EntryDataFormat("archive_pak")
+	{
+		addSignature("PACK");
+	}
 	~PakDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return PakArchive::isPakArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -66,7 +76,11 @@ public:
 class Wad2DataFormat : public EntryDataFormat
 {
 public:
-	Wad2DataFormat() : EntryDataFormat("archive_wad2") {}
+	Wad2DataFormat() : EntryDataFormat("archive_wad2")
+	{
+		addSignature("WAD2");
+		addSignature("WAD3");
+	}
 	~Wad2DataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return Wad2Archive::isWad2Archive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -93,7 +107,10 @@ public:
 class RffDataFormat : public EntryDataFormat
 {
 public:
-	RffDataFormat() : EntryDataFormat("archive_rff") {}
+	RffDataFormat() : EntryDataFormat("archive_rff")
+	{
+		addSignature("RFF\x1a");
+	}
 	~RffDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return RffArchive::isRffArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -102,7 +119,10 @@ public:
 class GobDataFormat : public EntryDataFormat
 {
 public:
-	GobDataFormat() : EntryDataFormat("archive_gob") {}
+	GobDataFormat() : EntryDataFormat("archive_gob")
+	{
+		addSignature("GOB\n");
+	}
 	~GobDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return GobArchive::isGobArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -111,7 +131,10 @@ public:
 class LfdDataFormat : public EntryDataFormat
 {
 public:
-	LfdDataFormat() : EntryDataFormat("archive_lfd") {}
+	LfdDataFormat() : EntryDataFormat("archive_lfd")
+	{
+		addSignature("RMAP");
+	}
 	~LfdDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return LfdArchive::isLfdArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -147,7 +170,10 @@ public:
 class GZipDataFormat : public EntryDataFormat
 {
 public:
-	GZipDataFormat() : EntryDataFormat("archive_gzip") {}
+	GZipDataFormat() : EntryDataFormat("archive_gzip")
+	{
+		addSignature("\x1f\x8b\x08");
+	}
 	~GZipDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return GZipArchive::isGZipArchive(mc) ? MATCH_TRUE : MATCH_FALSE; }
@@ -156,7 +182,10 @@ public:
 class BZip2DataFormat : public EntryDataFormat
 {
 public:
-	BZip2DataFormat() : EntryDataFormat("archive_bz2") {}
+	BZip2DataFormat() : EntryDataFormat("archive_bz2")
+	{
+		addSignature("BZh");
+	}
 	~BZip2DataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override { return BZip2Archive::isBZip2Archive(mc) ? MATCH_TRUE : MATCH_FALSE; }
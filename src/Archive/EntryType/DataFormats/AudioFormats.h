@@ -6,7 +6,10 @@
 class MUSDataFormat : public EntryDataFormat
 {
 public:
-	MUSDataFormat() : EntryDataFormat("midi_mus") {}
+	MUSDataFormat() : EntryDataFormat("midi_mus")
+	{
+		addSignature("MUS\x1a");
+	}
 	~MUSDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -26,7 +29,10 @@ public:
 class MIDIDataFormat : public EntryDataFormat
 {
 public:
-	MIDIDataFormat() : EntryDataFormat("midi_smf") {}
+	MIDIDataFormat() : EntryDataFormat("midi_smf")
+	{
+		addSignature("MThd");
+	}
 	~MIDIDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -600,7 +606,10 @@ public:
 class OggDataFormat : public EntryDataFormat
 {
 public:
-	OggDataFormat() : EntryDataFormat("snd_ogg") {}
+	OggDataFormat() : EntryDataFormat("snd_ogg")
+	{
+		addSignature("OggS");
+	}
 	~OggDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -625,7 +634,10 @@ public:
 class FLACDataFormat : public EntryDataFormat
 {
 public:
-	FLACDataFormat() : EntryDataFormat("snd_flac") {}
+	FLACDataFormat() : EntryDataFormat("snd_flac")
+	{
+		addSignature("fLaC");
+	}
 	~FLACDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
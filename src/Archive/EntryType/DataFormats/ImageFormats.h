@@ -5,7 +5,10 @@
 class PNGDataFormat : public EntryDataFormat
 {
 public:
-	PNGDataFormat() : EntryDataFormat("img_png") {}
+	PNGDataFormat() : EntryDataFormat("img_png")
+	{
+		addSignature("\x89PNG\r\n\x1a\n");
+	}
 	~PNGDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -26,7 +29,10 @@ public:
 class BMPDataFormat : public EntryDataFormat
 {
 public:
-	BMPDataFormat() : EntryDataFormat("img_bmp"){};
+	BMPDataFormat() : EntryDataFormat("img_bmp")
+	{
+		addSignature("BM");
+	}
 	~BMPDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -58,7 +64,11 @@ public:
 class GIFDataFormat : public EntryDataFormat
 {
 public:
-	GIFDataFormat() : EntryDataFormat("img_gif"){};
+	GIFDataFormat() : EntryDataFormat("img_gif")
+	{
+		addSignature("GIF87a");
+		addSignature("GIF89a");
+	}
 	~GIFDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -244,7 +254,10 @@ public:
 class JPEGDataFormat : public EntryDataFormat
 {
 public:
-	JPEGDataFormat() : EntryDataFormat("img_jpeg"){};
+	JPEGDataFormat() : EntryDataFormat("img_jpeg")
+	{
+		addSignature("\xff\xd8\xff");
+	}
 	~JPEGDataFormat() = default;
 
 	int isThisFormat(MemChunk& mc) override
@@ -96,13 +96,30 @@ int EntryDataFormat::isThisFormat(MemChunk& mc)
 	return MATCH_TRUE;
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [data] of [size] bytes begins with any of this format's
+// signatures, or if the format has no signatures defined
+// -----------------------------------------------------------------------------
+bool EntryDataFormat::matchesSignature(const uint8_t* data, unsigned size) const
+{
+	if (signatures_.empty())
+		return true;
+
+	for (const auto& sig : signatures_)
+		if (size >= sig.size() && memcmp(data, sig.data(), sig.size()) == 0)
+			return true;
+
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 // Copies data format properties to [target]
 // -----------------------------------------------------------------------------
 void EntryDataFormat::copyToFormat(EntryDataFormat& target) const
 {
-	target.patterns_ = patterns_;
-	target.size_min_ = size_min_;
+	target.patterns_   = patterns_;
+	target.size_min_   = size_min_;
+	target.signatures_ = signatures_;
 }
 
 
@@ -13,7 +13,9 @@ public:
 	EntryDataFormat(string_view id) : id_{ id } {}
 	virtual ~EntryDataFormat() = default;
 
-	const string& id() const { return id_; }
+	const string&         id() const { return id_; }
+	const vector<string>& signatures() const { return signatures_; }
+	bool                  matchesSignature(const uint8_t* data, unsigned size) const;
 
 	virtual int isThisFormat(MemChunk& mc);
 	void        copyToFormat(EntryDataFormat& target) const;
@@ -24,8 +26,12 @@ public:
 	static EntryDataFormat* anyFormat();
 	static EntryDataFormat* textFormat();
 
+protected:
+	void addSignature(string_view signature) { signatures_.emplace_back(signature); }
+
 private:
-	string id_;
+	string         id_;
+	vector<string> signatures_; // Data must begin with one of these to match the format (if any are defined)
 
 	// Struct to specify an inclusive range for a byte (min <= valid <= max)
 	// If max == min, only 1 valid value
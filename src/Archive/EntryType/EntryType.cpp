@@ -33,12 +33,17 @@
 #include "EntryType.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/Formats/WadArchive.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Console/Console.h"
+#include "General/UI.h"
 #include "MainEditor/MainEditor.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include <filesystem>
+#include <random>
+#include <unordered_map>
 
 
 // -----------------------------------------------------------------------------
@@ -46,6 +51,8 @@
 // Variables
 //
 // -----------------------------------------------------------------------------
+CVAR(Int, archive_detect_threads, 0, CVar::Flag::Save) // Number of threads to use for type detection (0 = auto)
+
 namespace
 {
 vector<unique_ptr<EntryType>> entry_types;      // The big list of all entry types
@@ -56,6 +63,18 @@ EntryType* etype_unknown = nullptr; // The default, 'unknown' entry type
 EntryType* etype_folder  = nullptr; // Folder entry type
 EntryType* etype_marker  = nullptr; // Marker entry type
 EntryType* etype_map     = nullptr; // Map marker type
+
+// Detectable types that could match data beginning with each possible byte
+// value, in the same order as entry_types (see updateDetectionIndex)
+vector<EntryType*> detect_candidates[256];
+vector<EntryType*> detect_all; // All detectable types
+bool               detect_use_index = true;
+
+// Detectable types without signatures that can only match entries of an exact
+// size, with a particular extension or within a particular section
+std::unordered_map<unsigned, vector<EntryType*>> detect_size_candidates;
+std::unordered_map<string, vector<EntryType*>>   detect_ext_candidates;
+std::unordered_map<string, vector<EntryType*>>   detect_section_candidates;
 } // namespace
 
 
@@ -180,27 +199,6 @@ int EntryType::isThisType(ArchiveEntry& entry)
 			return EntryDataFormat::MATCH_FALSE;
 	}
 
-	// Check for data format match if needed
-	int r = EntryDataFormat::MATCH_TRUE;
-	if (format_ == EntryDataFormat::textFormat())
-	{
-		// Hack for identifying ACS script sources despite DB2 apparently appending
-		// two null bytes to them, which make the memchr test fail.
-		size_t end = entry.size() - 1;
-		if (end > 3)
-			end -= 2;
-		// Text is a special case, as other data formats can sometimes be detected as 'text',
-		// we'll only check for it if text data is specified in the entry type
-		if (entry.size() > 0 && memchr(entry.rawData(), 0, end) != nullptr)
-			return EntryDataFormat::MATCH_FALSE;
-	}
-	else if (format_ != EntryDataFormat::anyFormat() && entry.size() > 0)
-	{
-		r = format_->isThisFormat(entry.data());
-		if (r == EntryDataFormat::MATCH_FALSE)
-			return EntryDataFormat::MATCH_FALSE;
-	}
-
 	// Check for size multiple match if needed
 	if (!size_multiple_.empty())
 	{
@@ -278,6 +276,30 @@ int EntryType::isThisType(ArchiveEntry& entry)
 		}
 	}
 
+	// Data formats only read entry data, so don't copy it if it's mapped
+	MemChunk::ReadOnlyScope read_only;
+
+	// Check for data format match if needed (done after the cheaper checks above)
+	int r = EntryDataFormat::MATCH_TRUE;
+	if (format_ == EntryDataFormat::textFormat())
+	{
+		// Hack for identifying ACS script sources despite DB2 apparently appending
+		// two null bytes to them, which make the memchr test fail.
+		size_t end = entry.size() - 1;
+		if (end > 3)
+			end -= 2;
+		// Text is a special case, as other data formats can sometimes be detected as 'text',
+		// we'll only check for it if text data is specified in the entry type
+		if (entry.size() > 0 && memchr(entry.rawData(), 0, end) != nullptr)
+			return EntryDataFormat::MATCH_FALSE;
+	}
+	else if (format_ != EntryDataFormat::anyFormat() && entry.size() > 0)
+	{
+		r = format_->isThisFormat(entry.data());
+		if (r == EntryDataFormat::MATCH_FALSE)
+			return EntryDataFormat::MATCH_FALSE;
+	}
+
 	// Check for entry section match if needed
 	if (!section_.empty())
 	{
@@ -462,6 +484,8 @@ bool EntryType::readEntryTypeDefinition(MemChunk& mc, string_view source)
 		entry_types.push_back(std::move(ntype));
 	}
 
+	updateDetectionIndex();
+
 	return true;
 }
 
@@ -584,39 +608,232 @@ bool EntryType::detectEntryType(ArchiveEntry& entry)
 	if (entry.type() == etype_folder || entry.type() == etype_map)
 		return false;
 
-	// If the entry's size is zero, set it to marker type
+	// Detect and set type
+	int  reliability = 0;
+	auto type        = detectType(entry, reliability);
+	entry.setType(type, reliability);
+
+	// Return t/f depending on if a matching type was found
+	return type != etype_unknown;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the most reliable matching type for [entry] (with its match result
+// in [reliability]), or etype_unknown if no types match.
+// Does not modify [entry] in any way, so this can be called for different
+// entries concurrently as long as their data is already loaded
+// -----------------------------------------------------------------------------
+EntryType* EntryType::detectType(ArchiveEntry& entry, int& reliability)
+{
+	// If the entry's size is zero, it's a marker
 	if (entry.size() == 0)
 	{
-		entry.setType(etype_marker);
-		return true;
+		reliability = 0;
+		return etype_marker;
 	}
 
-	// Reset entry type
-	entry.setType(etype_unknown);
+	// Detection only reads entry data, so don't copy it if it's mapped
+	MemChunk::ReadOnlyScope read_only;
+
+	// Get the types that could possibly match the entry data (all detectable
+	// types if the data couldn't be loaded)
+	auto data       = entry.rawData();
+	bool use_index  = detect_use_index && data;
+	auto candidates = use_index ? &detect_candidates[data[0]] : &detect_all;
 
-	// Go through all registered types
-	size_t entry_types_size = entry_types.size();
-	for (size_t a = 0; a < entry_types_size; a++)
+	// Add any types that can only match the entry's size, extension or section,
+	// keeping candidates in entry_types order
+	vector<EntryType*> keyed;
+	if (use_index)
+	{
+		auto add_keyed = [&keyed](const auto& index, const auto& key) {
+			auto i = index.find(key);
+			if (i != index.end())
+				keyed.insert(keyed.end(), i->second.begin(), i->second.end());
+		};
+
+		add_keyed(detect_size_candidates, entry.size());
+		auto ext_sep = entry.upperName().find('.');
+		if (ext_sep != string::npos)
+			add_keyed(detect_ext_candidates, entry.upperName().substr(ext_sep + 1));
+		if (!detect_section_candidates.empty() && entry.parent())
+			add_keyed(detect_section_candidates, StrUtil::lower(entry.parent()->detectNamespace(&entry)));
+
+		if (!keyed.empty())
+		{
+			keyed.insert(keyed.end(), candidates->begin(), candidates->end());
+			std::sort(keyed.begin(), keyed.end(), [](EntryType* left, EntryType* right) {
+				return left->index_ < right->index_;
+			});
+			candidates = &keyed;
+		}
+	}
+
+	// Go through candidate types
+	auto type             = etype_unknown;
+	int  type_reliability = 0;
+	reliability           = 0;
+	for (auto candidate : *candidates)
 	{
 		// If the current type is more 'reliable' than this one, skip it
-		if (entry.typeReliability() >= entry_types[a]->reliability())
+		if (type_reliability >= candidate->reliability())
+			continue;
+
+		// Check the data begins with the format signature (if any) first
+		if (use_index && !candidate->format_->matchesSignature(data, entry.size()))
 			continue;
 
 		// Check for possible type match
-		int r = entry_types[a]->isThisType(entry);
+		int r = candidate->isThisType(entry);
 		if (r > 0)
 		{
-			// Type matches, set it
-			entry.setType(entry_types[a].get(), r);
+			// Type matches, use it
+			type             = candidate;
+			reliability      = r;
+			type_reliability = type->reliability() * r / 255;
 
 			// No need to continue if the identification is 100% reliable
-			if (entry.typeReliability() >= 255)
-				return true;
+			if (type_reliability >= 255)
+				break;
 		}
 	}
 
-	// Return t/f depending on if a matching type was found
-	return entry.type() != etype_unknown;
+	return type;
+}
+
+// -----------------------------------------------------------------------------
+// Detects the types of all [entries], split across a number of worker threads
+// (see the archive_detect_threads cvar).
+// All entries must already have their data loaded, since loading entry data
+// from the parent archive can't be done concurrently. Detected types are
+// applied in order once all detection is finished, so results are identical
+// to calling detectEntryType on each entry in turn.
+// The splash window progress bar is updated from [progress_start] to
+// [progress_end] while detection is running
+// -----------------------------------------------------------------------------
+void EntryType::detectEntryTypes(const vector<ArchiveEntry*>& entries, float progress_start, float progress_end)
+{
+	struct DetectResult
+	{
+		EntryType* type        = nullptr;
+		int        reliability = 0;
+	};
+
+	// Make sure entry data is loaded first (on this thread)
+	vector<DetectResult> results(entries.size());
+	for (auto entry : entries)
+		if (entry->size() > 0 && !entry->isLoaded())
+			entry->data();
+
+	// Detect types (in parallel)
+	ThreadPool::runParallel(
+		entries.size(),
+		[&](size_t index) {
+			auto entry = entries[index];
+			if (entry->type() == etype_folder || entry->type() == etype_map)
+				return;
+
+			// Entries whose data failed to load are detected afterwards, since
+			// detection would attempt to load the data again
+			if (entry->size() > 0 && !entry->isLoaded())
+				return;
+
+			results[index].type = detectType(*entry, results[index].reliability);
+		},
+		ThreadPool::numThreads(archive_detect_threads),
+		[&](size_t num_done) {
+			UI::setSplashProgress(
+				progress_start + (progress_end - progress_start) * ((float)num_done / (float)entries.size()));
+		});
+
+	// Apply results in order
+	for (size_t a = 0; a < entries.size(); a++)
+	{
+		if (results[a].type)
+			entries[a]->setType(results[a].type, results[a].reliability);
+		else if (entries[a]->size() > 0 && !entries[a]->isLoaded())
+			detectEntryType(*entries[a]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the lists of candidate types for each possible first byte of entry
+// data. Types whose data format has signatures are only included in the lists
+// for the first bytes of those signatures. Types without signatures that
+// require an exact size, an extension or a section are instead indexed by
+// those (in that order of preference), and all other detectable types are
+// included in every list. This means detectType can skip most types without
+// calling their (comparatively expensive) isThisType functions
+// -----------------------------------------------------------------------------
+void EntryType::updateDetectionIndex()
+{
+	detect_all.clear();
+	for (auto& list : detect_candidates)
+		list.clear();
+	detect_size_candidates.clear();
+	detect_ext_candidates.clear();
+	detect_section_candidates.clear();
+
+	for (const auto& type : entry_types)
+	{
+		if (!type->detectable_)
+			continue;
+
+		detect_all.push_back(type.get());
+
+		const auto& signatures = type->format_->signatures();
+		if (signatures.empty())
+		{
+			// Exact size(s) required
+			if (!type->match_size_.empty())
+			{
+				for (auto size : type->match_size_)
+				{
+					auto& list = detect_size_candidates[size];
+					if (list.empty() || list.back() != type.get())
+						list.push_back(type.get());
+				}
+				continue;
+			}
+
+			// Extension required (not just a name or extension)
+			if (!type->match_extension_.empty() && !(type->match_ext_or_name_ && !type->match_name_.empty()))
+			{
+				for (const auto& ext : type->match_extension_)
+				{
+					auto& list = detect_ext_candidates[ext];
+					if (list.empty() || list.back() != type.get())
+						list.push_back(type.get());
+				}
+				continue;
+			}
+
+			// Section required
+			if (!type->section_.empty())
+			{
+				for (const auto& section : type->section_)
+				{
+					auto& list = detect_section_candidates[section];
+					if (list.empty() || list.back() != type.get())
+						list.push_back(type.get());
+				}
+				continue;
+			}
+
+			// Could match anything
+			for (auto& list : detect_candidates)
+				list.push_back(type.get());
+			continue;
+		}
+
+		// Add to list for the first byte of each signature
+		for (const auto& sig : signatures)
+		{
+			auto& list = detect_candidates[(uint8_t)sig[0]];
+			if (list.empty() || list.back() != type.get())
+				list.push_back(type.get());
+		}
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -806,3 +1023,88 @@ CONSOLE_COMMAND(size, 0, true)
 	}
 	Log::info("{}: {} bytes", meep->name(), meep->size());
 }
+
+// -----------------------------------------------------------------------------
+// Benchmarks entry type detection over a synthetic wad with [count] entries of
+// assorted data (default 20000), comparing a linear scan of all types with
+// the indexed candidate lists. Reports any differing results
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_detect_types, 0, false)
+{
+	int count = 20000;
+	if (!args.empty())
+		count = StrUtil::asInt(args[0]);
+
+	// Build synthetic wad
+	static const char* names[] = { "DECORATE", "MAPINFO", "TEXTURE1", "PLAYPAL", "DSPISTOL", "D_RUNNIN", "TITLEPIC" };
+	WadArchive         wad;
+	std::mt19937       rng(1234);
+	vector<uint8_t>    data;
+	for (int a = 0; a < count; a++)
+	{
+		unsigned size = 64 + rng() % 8192;
+		data.resize(size);
+		for (auto& b : data)
+			b = rng() & 0xFF;
+
+		switch (a % 8)
+		{
+		case 0: // Random
+			break;
+		case 1: // Text
+		{
+			auto text = fmt::format("// Entry {}\nActor Thing{} : Actor\n{{\n\tHealth 100\n}}\n", a, a);
+			data.assign(text.begin(), text.end());
+			break;
+		}
+		case 2: memcpy(data.data(), "\x89PNG\r\n\x1a\n", 8); break;
+		case 3: memcpy(data.data(), "MUS\x1a", 4); break;
+		case 4: data.resize(4096); break; // Flat size
+		case 5: data.resize(768 * 14); break; // Palette size
+		case 6: memcpy(data.data(), "PWAD", 4); break;
+		default: memcpy(data.data(), "RIFF", 4); break;
+		}
+
+		auto name  = a % 3 == 0 ? fmt::format("E{:06d}", a) : string{ names[a % 7] };
+		auto entry = wad.addNewEntry(name);
+		entry->importMem(data.data(), data.size());
+	}
+
+	// Detect all entries with [use_index] set, returning the time taken
+	vector<EntryType*> types_linear(count);
+	vector<EntryType*> types_indexed(count);
+	auto               detect_all_entries = [&](bool use_index, vector<EntryType*>& types) {
+		detect_use_index = use_index;
+		auto start       = App::runTimer();
+		int  reliability = 0;
+		for (int a = 0; a < count; a++)
+			types[a] = EntryType::detectType(*wad.entryAt(a), reliability);
+		detect_use_index = true;
+		return App::runTimer() - start;
+	};
+	auto time_linear  = detect_all_entries(false, types_linear);
+	auto time_indexed = detect_all_entries(true, types_indexed);
+
+	// Compare
+	int mismatches = 0;
+	for (int a = 0; a < count; a++)
+	{
+		if (types_linear[a] != types_indexed[a])
+		{
+			if (mismatches < 10)
+				Log::console(fmt::format(
+					"Mismatch for entry {}: {} (linear) vs {} (indexed)",
+					a,
+					types_linear[a]->id(),
+					types_indexed[a]->id()));
+			mismatches++;
+		}
+	}
+
+	Log::console(fmt::format(
+		"Detected {} entries: linear {}ms, indexed {}ms, {} mismatches",
+		count,
+		time_linear,
+		time_indexed,
+		mismatches));
+}
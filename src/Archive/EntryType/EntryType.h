@@ -8,6 +8,10 @@ class ArchiveEntry;
 class EntryType
 {
 public:
+	// Limits for batches of entries passed to detectEntryTypes when opening archives
+	static const unsigned DETECT_BATCH_SIZE  = 64 * 1024 * 1024; // Total entry data size
+	static const unsigned DETECT_BATCH_COUNT = 4096;             // Number of entries
+
 	EntryType(string_view id = "Unknown") : id_{ id }, format_{ EntryDataFormat::anyFormat() } {}
 	~EntryType() = default;
 
@@ -36,6 +40,11 @@ public:
 	static bool               readEntryTypeDefinition(MemChunk& mc, string_view source);
 	static bool               loadEntryTypes();
 	static bool               detectEntryType(ArchiveEntry& entry);
+	static EntryType*         detectType(ArchiveEntry& entry, int& reliability);
+	static void               detectEntryTypes(
+					  const vector<ArchiveEntry*>& entries,
+					  float                        progress_start = 0.f,
+					  float                        progress_end   = 1.f);
 	static EntryType*         fromId(string_view id);
 	static EntryType*         unknownType();
 	static EntryType*         folderType();
@@ -45,6 +54,8 @@ public:
 	static vector<string>     allCategories();
 
 private:
+	static void updateDetectionIndex();
+
 	// Type info
 	string  id_;
 	string  name_        = "Unknown";
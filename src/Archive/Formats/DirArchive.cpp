@@ -34,10 +34,26 @@
 #include "Main.h"
 #include "DirArchive.h"
 #include "App.h"
+#include "General/Misc.h"
 #include "General/UI.h"
 #include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
+#include <filesystem>
+#include <fstream>
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, dir_archive_type_cache, true, CVar::Flag::Save)
+namespace
+{
+const string TYPE_CACHE_HEADER = "SLADE dir type cache 1";
+}
 
 
 // -----------------------------------------------------------------------------
@@ -46,6 +62,89 @@
 //
 // -----------------------------------------------------------------------------
 EXTERN_CVAR(Bool, archive_load_data)
+EXTERN_CVAR(Int, archive_detect_threads)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the path to the type cache file for the directory at [dir_path]
+// -----------------------------------------------------------------------------
+string typeCachePath(string_view dir_path)
+{
+	auto crc = Misc::crc(reinterpret_cast<const uint8_t*>(dir_path.data()), dir_path.size());
+	return App::path(fmt::format("dircache/{:08x}.txt", crc), App::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Returns a header line identifying the entry type definitions the cache was
+// built with, so that cached types are discarded if they change
+// -----------------------------------------------------------------------------
+string typeCacheHeader()
+{
+	return fmt::format("{} {} {}", TYPE_CACHE_HEADER, App::version().toString(), EntryType::allTypes().size());
+}
+
+// -----------------------------------------------------------------------------
+// Reads the type cache for the directory at [dir_path] into [cache].
+// Each line is in the form <size>\t<mtime>\t<type id>\t<file path>
+// -----------------------------------------------------------------------------
+void readTypeCache(string_view dir_path, DirTypeCache& cache)
+{
+	cache.clear();
+
+	std::ifstream file(typeCachePath(dir_path));
+	if (!file.is_open())
+		return;
+
+	// Check header
+	string line;
+	if (!std::getline(file, line) || line != typeCacheHeader())
+		return;
+
+	while (std::getline(file, line))
+	{
+		auto tab1 = line.find('\t');
+		auto tab2 = tab1 == string::npos ? string::npos : line.find('\t', tab1 + 1);
+		auto tab3 = tab2 == string::npos ? string::npos : line.find('\t', tab2 + 1);
+		if (tab3 == string::npos)
+			continue;
+
+		DirCachedType cached;
+		cached.size    = StrUtil::asUInt(line.substr(0, tab1));
+		cached.mtime   = std::strtoll(line.substr(tab1 + 1, tab2 - tab1 - 1).c_str(), nullptr, 10);
+		cached.type_id = line.substr(tab2 + 1, tab3 - tab2 - 1);
+		cache[line.substr(tab3 + 1)] = cached;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Writes [cache] to the type cache file for the directory at [dir_path]
+// -----------------------------------------------------------------------------
+void writeTypeCache(string_view dir_path, const DirTypeCache& cache)
+{
+	auto cache_dir = App::path("dircache", App::Dir::User);
+	if (!FileUtil::dirExists(cache_dir) && !FileUtil::createDir(cache_dir))
+		return;
+
+	std::ofstream file(typeCachePath(dir_path));
+	if (!file.is_open())
+	{
+		Log::warning("Unable to write type cache for directory {}", dir_path);
+		return;
+	}
+
+	file << typeCacheHeader() << "\n";
+	for (const auto& [path, cached] : cache)
+		file << cached.size << '\t' << static_cast<long long>(cached.mtime) << '\t' << cached.type_id << '\t' << path
+			 << "\n";
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -86,7 +185,31 @@ bool DirArchive::open(string_view filename)
 	// Stop announcements (don't want to be announcing modification due to entries being added etc)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 
+	// Get file sizes and modification times
+	UI::setSplashProgressMessage("Checking files");
+	auto             num_threads = ThreadPool::numThreads(archive_detect_threads);
+	vector<uint32_t> file_sizes(files.size());
+	vector<time_t>   file_mtimes(files.size());
+	ThreadPool::runParallel(
+		files.size(),
+		[&](size_t index) {
+			std::error_code ec;
+			auto            size = std::filesystem::file_size(files[index], ec);
+			file_sizes[index]    = ec ? 0 : static_cast<uint32_t>(size);
+			file_mtimes[index]   = wxFileModificationTime(files[index]);
+		},
+		num_threads);
+
+	// Read cached entry types (if any)
+	DirTypeCache cached_types;
+	if (dir_archive_type_cache)
+		readTypeCache(filename, cached_types);
+	type_cache_.clear();
+
 	UI::setSplashProgressMessage("Reading files");
+	vector<ArchiveEntry*> batch, detect_batch;
+	vector<string>        batch_paths;
+	size_t                batch_size = 0;
 	for (unsigned a = 0; a < files.size(); a++)
 	{
 		UI::setSplashProgress((float)a / (float)files.size());
@@ -97,11 +220,9 @@ bool DirArchive::open(string_view filename)
 		if (StrUtil::startsWith(name, separator_))
 			name.erase(0, 1);
 
-		// Log::info(3, fn.GetPath(true, wxPATH_UNIX));
-
 		// Create entry
 		auto fn        = StrUtil::Path{ name };
-		auto new_entry = std::make_shared<ArchiveEntry>(fn.fileName());
+		auto new_entry = std::make_shared<ArchiveEntry>(fn.fileName(), file_sizes[a]);
 
 		// Setup entry info
 		new_entry->setLoaded(false);
@@ -112,20 +233,59 @@ bool DirArchive::open(string_view filename)
 		ndir->addEntry(new_entry);
 		ndir->dirEntry()->exProp("filePath") = fmt::format("{}{}", filename, fn.path());
 
-		// Read entry data
-		new_entry->importFile(files[a]);
-		new_entry->setLoaded(true);
+		file_modification_times_[new_entry.get()] = file_mtimes[a];
 
-		file_modification_times_[new_entry.get()] = wxFileModificationTime(files[a]);
+		// Use the cached type if the file hasn't changed since it was detected,
+		// otherwise queue for type detection
+		auto cached = cached_types.find(files[a]);
+		auto detect = cached == cached_types.end() || cached->second.size != file_sizes[a]
+					  || cached->second.mtime != file_mtimes[a];
+		if (detect)
+			detect_batch.push_back(new_entry.get());
+		else
+		{
+			new_entry->setType(EntryType::fromId(cached->second.type_id));
+			type_cache_[files[a]] = cached->second;
+		}
 
-		// Detect entry type
-		EntryType::detectEntryType(*new_entry);
+		// Queue for reading (only needs reading if detecting or keeping data loaded)
+		if (detect || archive_load_data)
+		{
+			batch.push_back(new_entry.get());
+			batch_paths.push_back(files[a]);
+			batch_size += file_sizes[a];
+		}
+
+		// Read and detect the current batch once it is big enough (or all files have been checked)
+		if (batch_size < EntryType::DETECT_BATCH_SIZE && batch.size() < EntryType::DETECT_BATCH_COUNT
+			&& a < files.size() - 1)
+			continue;
+
+		readEntryFiles(batch, batch_paths);
+		EntryType::detectEntryTypes(
+			detect_batch, (float)(a + 1 - batch.size()) / (float)files.size(), (float)(a + 1) / (float)files.size());
+
+		for (auto entry : detect_batch)
+			cacheEntryType(entry, entry->exProp("filePath").stringValue());
 
 		// Unload data if needed
 		if (!archive_load_data)
-			new_entry->unloadData();
+			for (auto entry : batch)
+			{
+				entry->setState(ArchiveEntry::State::Unmodified);
+				entry->unloadData();
+			}
+
+		batch.clear();
+		batch_paths.clear();
+		detect_batch.clear();
+		batch_size = 0;
 	}
 
+	// Save type cache
+	if (dir_archive_type_cache)
+		writeTypeCache(filename, type_cache_);
+
 	// Add empty directories
 	for (const auto& subdir : dirs)
 	{
@@ -599,6 +759,8 @@ void DirArchive::updateChangedEntries(vector<DirEntryChange>& changes)
 {
 	bool was_modified = isModified();
 
+	vector<ArchiveEntry*> read_entries, added_entries;
+	vector<string>        read_paths;
 	for (auto& change : changes)
 	{
 		ignored_file_changes_.erase(change.file_path);
@@ -607,9 +769,9 @@ void DirArchive::updateChangedEntries(vector<DirEntryChange>& changes)
 		if (change.action == DirEntryChange::Action::Updated)
 		{
 			auto entry = entryAtPath(change.entry_path);
-			entry->importFile(change.file_path);
-			EntryType::detectEntryType(*entry);
 			file_modification_times_[entry] = wxFileModificationTime(change.file_path);
+			read_entries.push_back(entry);
+			read_paths.push_back(change.file_path);
 		}
 
 		// Deleted Entries
@@ -659,26 +821,82 @@ void DirArchive::updateChangedEntries(vector<DirEntryChange>& changes)
 			auto ndir = createDir(fn.path());
 			ndir->addEntry(new_entry);
 
-			// Read entry data
-			new_entry->importFile(change.file_path);
-			new_entry->setLoaded(true);
+			file_modification_times_[new_entry.get()] = wxFileModificationTime(change.file_path);
+			read_entries.push_back(new_entry.get());
+			read_paths.push_back(change.file_path);
+			added_entries.push_back(new_entry.get());
+		}
+	}
+
+	// Read and detect new/modified entries
+	readEntryFiles(read_entries, read_paths);
+	EntryType::detectEntryTypes(read_entries);
+	for (unsigned a = 0; a < read_entries.size(); a++)
+		cacheEntryType(read_entries[a], read_paths[a]);
+	for (auto entry : added_entries)
+	{
+		// Set entry not modified
+		entry->setState(ArchiveEntry::State::Unmodified);
 
-			file_modification_times_[new_entry.get()] = FileUtil::fileModifiedTime(change.file_path);
+		// Unload data if needed
+		if (!archive_load_data)
+			entry->unloadData();
+	}
 
-			// Detect entry type
-			EntryType::detectEntryType(*new_entry);
+	// Save type cache
+	if (dir_archive_type_cache && !read_entries.empty())
+		writeTypeCache(filename_, type_cache_);
 
-			// Unload data if needed
-			if (!archive_load_data)
-				new_entry->unloadData();
+	// Preserve old modified state
+	setModified(was_modified);
+}
 
-			// Set entry not modified
-			new_entry->setState(ArchiveEntry::State::Unmodified);
+// -----------------------------------------------------------------------------
+// Reads the files at [paths] into the matching [entries], in parallel
+// -----------------------------------------------------------------------------
+void DirArchive::readEntryFiles(const vector<ArchiveEntry*>& entries, const vector<string>& paths) const
+{
+	// Read files (in parallel)
+	vector<MemChunk> file_data(entries.size());
+	vector<uint8_t>  file_opened(entries.size(), 0);
+	ThreadPool::runParallel(
+		entries.size(),
+		[&](size_t index) {
+			SFile file(paths[index]);
+			if (!file.isOpen())
+				return;
+			file_opened[index] = 1;
+			if (file.size() > 0)
+				file.read(file_data[index], file.size());
+		},
+		ThreadPool::numThreads(archive_detect_threads));
+
+	// Import read data into entries
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		if (file_data[a].hasData())
+			entries[a]->importMemChunk(file_data[a]);
+		else if (file_opened[a])
+		{
+			// Empty file
+			entries[a]->clearData();
+			entries[a]->setLoaded(true);
 		}
+		else
+			Log::warning("Unable to read file {}", paths[a]);
 	}
+}
 
-	// Preserve old modified state
-	setModified(was_modified);
+// -----------------------------------------------------------------------------
+// Records the detected type of [entry] (read from the file at [path]) in the
+// type cache
+// -----------------------------------------------------------------------------
+void DirArchive::cacheEntryType(ArchiveEntry* entry, const string& path)
+{
+	auto& cached   = type_cache_[path];
+	cached.size    = entry->size();
+	cached.mtime   = file_modification_times_[entry];
+	cached.type_id = entry->type()->id();
 }
 
 // -----------------------------------------------------------------------------
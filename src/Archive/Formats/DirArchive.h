@@ -30,6 +30,15 @@ struct DirEntryChange
 
 typedef std::map<string, DirEntryChange> IgnoredFileChanges;
 
+struct DirCachedType
+{
+	uint32_t size  = 0;
+	time_t   mtime = 0;
+	string   type_id;
+};
+
+typedef std::map<string, DirCachedType> DirTypeCache;
+
 class DirArchive : public Archive
 {
 public:
@@ -82,6 +91,10 @@ private:
 	std::map<ArchiveEntry*, time_t> file_modification_times_;
 	vector<string>                  removed_files_;
 	IgnoredFileChanges              ignored_file_changes_;
+	DirTypeCache                    type_cache_;
+
+	void readEntryFiles(const vector<ArchiveEntry*>& entries, const vector<string>& paths) const;
+	void cacheEntryType(ArchiveEntry* entry, const string& path);
 };
 
 class DirArchiveTraverser : public wxDirTraverser
@@ -31,8 +31,11 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "WadArchive.h"
+#include "General/Console/Console.h"
 #include "General/Misc.h"
 #include "General/UI.h"
+#include "Utility/FileUtils.h"
+#include "Utility/MappedFile.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
@@ -44,6 +47,9 @@
 //
 // -----------------------------------------------------------------------------
 CVAR(Bool, iwad_lock, true, CVar::Flag::Save)
+CVAR(Bool, wad_mmap, true, CVar::Flag::Save)        // Map wad files into memory rather than reading lumps from disk
+CVAR(Bool, wad_append_save, true, CVar::Flag::Save) // Only write new/modified lumps when saving over a wad
+CVAR(Int, wad_append_compact, 25, CVar::Flag::Save) // Max % of unused space append-saving can leave in a wad
 
 namespace
 {
@@ -117,6 +123,53 @@ bool isNamespaceEntry(ArchiveEntry* entry)
 {
 	return StrUtil::endsWith(entry->upperName(), "_START") || StrUtil::endsWith(entry->upperName(), "_END");
 }
+
+// -----------------------------------------------------------------------------
+// Writes a wad directory entry for [entry] at [offset] to [out]
+// -----------------------------------------------------------------------------
+bool writeDirEntry(SeekableData& out, ArchiveEntry* entry, uint32_t offset)
+{
+	char     name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint32_t size    = entry->size();
+
+	for (size_t c = 0; c < entry->name().length() && c < 8; c++)
+		name[c] = entry->name()[c];
+
+	return out.write(&offset, 4) && out.write(&size, 4) && out.write(name, 8);
+}
+
+// -----------------------------------------------------------------------------
+// Returns a CRC of the header and directory of the wad file at [filename], or
+// 0 if they can't be read
+// -----------------------------------------------------------------------------
+uint32_t headerCrc(string_view filename)
+{
+	SFile file(filename);
+	if (!file.isOpen())
+		return 0;
+
+	// Read header
+	uint8_t header[12];
+	if (!file.read(header, 12))
+		return 0;
+	uint32_t num_lumps;
+	uint32_t dir_offset;
+	memcpy(&num_lumps, header + 4, 4);
+	memcpy(&dir_offset, header + 8, 4);
+	num_lumps  = wxINT32_SWAP_ON_BE(num_lumps);
+	dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
+
+	// Read directory after it
+	uint64_t dir_size = (uint64_t)num_lumps * 16;
+	if (dir_offset + dir_size > file.size())
+		return 0;
+	vector<uint8_t> data(12 + dir_size);
+	memcpy(data.data(), header, 12);
+	if (!file.seekFromStart(dir_offset) || !file.read(data.data() + 12, dir_size))
+		return 0;
+
+	return Misc::crc(data.data(), data.size());
+}
 } // namespace
 
 
@@ -311,6 +364,47 @@ bool WadArchive::hasFlatHack()
 	return false;
 }
 
+// -----------------------------------------------------------------------------
+// Reads a wad file from disk.
+// If wad_mmap is enabled the file is mapped into memory rather than read, and
+// entry data will point directly into the mapped file until modified
+// -----------------------------------------------------------------------------
+bool WadArchive::open(string_view filename)
+{
+	mapped_file_.reset();
+	setFileInfo(filename);
+
+	// Read the whole file if mapping is disabled (or unsupported for this format)
+	if (!wad_mmap || format_ != "wad")
+		return TreelessArchive::open(filename);
+
+	// Map the file
+	auto mapped = std::make_shared<MappedFile>();
+	if (!mapped->open(string{ filename }))
+	{
+		Log::info(2, "Unable to map file {} into memory, reading it instead", filename);
+		return TreelessArchive::open(filename);
+	}
+
+	// Update filename before opening
+	auto backupname = filename_;
+	filename_       = filename;
+
+	// Load from a view of the whole mapped file
+	MemChunk mc;
+	mc.importMapped(mapped, 0, mapped->size());
+	mapped_file_ = mapped;
+	if (open(mc))
+	{
+		on_disk_ = true;
+		return true;
+	}
+
+	filename_ = backupname;
+	mapped_file_.reset();
+	return false;
+}
+
 // -----------------------------------------------------------------------------
 // Reads wad format data from a MemChunk
 // Returns true if successful, false otherwise
@@ -321,6 +415,12 @@ bool WadArchive::open(MemChunk& mc)
 	if (!mc.hasData())
 		return false;
 
+	// Entry data can only point into the mapped file if that's what we're opening
+	// (compare via the const data pointer, non-const access would copy it)
+	auto& cmc = static_cast<const MemChunk&>(mc);
+	if (mapped_file_ && (!mc.isMapped() || cmc.data() != mapped_file_->data()))
+		mapped_file_.reset();
+
 	// Read wad header
 	uint32_t num_lumps   = 0;
 	uint32_t dir_offset  = 0;
@@ -462,18 +562,25 @@ bool WadArchive::open(MemChunk& mc)
 	updateNamespaces();
 
 	// Detect all entry types
-	MemChunk edata;
+	// Entry data is read in batches and each batch is detected in parallel
+	MemChunk              edata;
+	vector<ArchiveEntry*> batch;
+	size_t                batch_size = 0;
+	auto                  n_entries  = numEntries();
 	UI::setSplashProgressMessage("Detecting entry types");
-	for (size_t a = 0; a < numEntries(); a++)
+	for (size_t a = 0; a < n_entries; a++)
 	{
-		// Update splash window progress
-		UI::setSplashProgress((((float)a / (float)numEntries())));
-
 		// Get entry
 		auto entry = entryAt(a);
 
 		// Read entry data if it isn't zero-sized
-		if (entry->size() > 0)
+		if (entry->size() > 0 && mapped_file_ && entry->encryption() == ArchiveEntry::Encryption::None)
+		{
+			// Just point to the entry data within the mapped file
+			entry->data(false).importMapped(mapped_file_, getEntryOffset(entry), entry->size());
+			entry->setLoaded();
+		}
+		else if (entry->size() > 0)
 		{
 			// Read the entry data
 			mc.exportMemChunk(edata, getEntryOffset(entry), entry->size());
@@ -491,16 +598,29 @@ bool WadArchive::open(MemChunk& mc)
 			}
 			entry->importMemChunk(edata);
 		}
+		batch.push_back(entry);
+		batch_size += entry->size();
 
-		// Detect entry type
-		EntryType::detectEntryType(*entry);
+		// Detect entry types for the current batch once it is big enough
+		if (batch_size < EntryType::DETECT_BATCH_SIZE && batch.size() < EntryType::DETECT_BATCH_COUNT
+			&& a < n_entries - 1)
+			continue;
 
-		// Unload entry data if needed
-		if (!archive_load_data)
-			entry->unloadData();
+		EntryType::detectEntryTypes(
+			batch, (float)(a + 1 - batch.size()) / (float)n_entries, (float)(a + 1) / (float)n_entries);
 
-		// Set entry to unchanged
-		entry->setState(ArchiveEntry::State::Unmodified);
+		for (auto b_entry : batch)
+		{
+			// Unload entry data if needed
+			if (!archive_load_data)
+				b_entry->unloadData();
+
+			// Set entry to unchanged
+			b_entry->setState(ArchiveEntry::State::Unmodified);
+		}
+
+		batch.clear();
+		batch_size = 0;
 	}
 
 	// Identify #included lumps (DECORATE, GLDEFS, etc.)
@@ -532,66 +652,19 @@ bool WadArchive::write(MemChunk& mc, bool update)
 		return false;
 	}
 
-	// Determine directory offset & individual lump offsets
-	uint32_t      dir_offset = 12;
-	ArchiveEntry* entry;
-	for (uint32_t l = 0; l < numEntries(); l++)
-	{
-		entry = entryAt(l);
-		setEntryOffset(entry, dir_offset);
-		dir_offset += entry->size();
-	}
-
 	// Clear/init MemChunk
+	uint32_t size = 12 + numEntries() * 16;
+	for (uint32_t l = 0; l < numEntries(); l++)
+		size += entryAt(l)->size();
 	mc.clear();
 	mc.seek(0, SEEK_SET);
-	if (!mc.reSize(dir_offset + numEntries() * 16))
+	if (!mc.reSize(size))
 	{
 		Global::error = "Failed to allocate sufficient memory";
 		return false;
 	}
 
-	// Setup wad type
-	char wad_type[4] = { 'P', 'W', 'A', 'D' };
-	if (iwad_)
-		wad_type[0] = 'I';
-
-	// Write the header
-	uint32_t num_lumps = numEntries();
-	mc.write(wad_type, 4);
-	mc.write(&num_lumps, 4);
-	mc.write(&dir_offset, 4);
-
-	// Write the lumps
-	for (uint32_t l = 0; l < num_lumps; l++)
-	{
-		entry = entryAt(l);
-		mc.write(entry->rawData(), entry->size());
-	}
-
-	// Write the directory
-	for (uint32_t l = 0; l < num_lumps; l++)
-	{
-		entry        = entryAt(l);
-		char name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-		long offset  = getEntryOffset(entry);
-		long size    = entry->size();
-
-		for (size_t c = 0; c < entry->name().length() && c < 8; c++)
-			name[c] = entry->name()[c];
-
-		mc.write(&offset, 4);
-		mc.write(&size, 4);
-		mc.write(name, 8);
-
-		if (update)
-		{
-			entry->setState(ArchiveEntry::State::Unmodified);
-			entry->exProp("Offset") = (int)offset;
-		}
-	}
-
-	return true;
+	return writeWad(mc, update);
 }
 
 // -----------------------------------------------------------------------------
@@ -607,15 +680,56 @@ bool WadArchive::write(string_view filename, bool update)
 		return false;
 	}
 
+	// Only write new/modified lumps if saving over the wad file
+	if (wad_append_save && update && writeAppend(filename))
+		return true;
+
+	// If overwriting the mapped wad file, all entry data needs to be copied
+	// into memory first (and the file unmapped)
+	wxString wx_filename{ filename.data(), filename.size() };
+	if (mapped_file_ && wxFileName(wx_filename).SameAs(wxFileName(mapped_file_->path())))
+	{
+		for (unsigned l = 0; l < numEntries(); l++)
+		{
+			if (!entryAt(l)->data().detach())
+			{
+				Global::error = "Failed to allocate sufficient memory";
+				return false;
+			}
+		}
+		mapped_file_.reset();
+	}
+
 	// Open file for writing
-	wxFile file;
-	file.Open(wxString{ filename.data(), filename.size() }, wxFile::write);
-	if (!file.IsOpened())
+	SFile file(filename, SFile::Mode::Write);
+	if (!file.isOpen())
 	{
 		Global::error = "Unable to open file for writing";
 		return false;
 	}
 
+	// Write lumps directly to the file
+	if (!writeWad(file, update))
+		return false;
+	file.close();
+
+	// Map the written file so entry data can point into it (entry offsets are
+	// only updated if [update] is true)
+	if (update)
+	{
+		setFileInfo(filename);
+		remapFile(filename);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the wad header, lumps and directory to [out], one lump at a time.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::writeWad(SeekableData& out, bool update)
+{
 	// Determine directory offset & individual lump offsets
 	uint32_t      dir_offset = 12;
 	ArchiveEntry* entry;
@@ -633,47 +747,198 @@ bool WadArchive::write(string_view filename, bool update)
 
 	// Write the header
 	uint32_t num_lumps = numEntries();
-	file.Write(wad_type, 4);
-	file.Write(&num_lumps, 4);
-	file.Write(&dir_offset, 4);
+	bool     ok        = out.write(wad_type, 4) && out.write(&num_lumps, 4) && out.write(&dir_offset, 4);
 
 	// Write the lumps
-	for (uint32_t l = 0; l < num_lumps; l++)
+	for (uint32_t l = 0; ok && l < num_lumps; l++)
 	{
 		entry = entryAt(l);
 		if (entry->size())
-		{
-			file.Write(entry->rawData(), entry->size());
-		}
+			ok = out.write(entry->rawData(), entry->size());
 	}
 
 	// Write the directory
+	for (uint32_t l = 0; ok && l < num_lumps; l++)
+		ok = writeDirEntry(out, entryAt(l), getEntryOffset(entryAt(l)));
+
+	if (!ok)
+	{
+		Global::error = "Unable to write wad data";
+		return false;
+	}
+
+	// Update entry info
+	if (update)
+		for (uint32_t l = 0; l < num_lumps; l++)
+			entryAt(l)->setState(ArchiveEntry::State::Unmodified);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if saving over [filename] would only append new and modified
+// lumps to it (see writeAppend), rather than rewriting the whole file
+// -----------------------------------------------------------------------------
+bool WadArchive::canAppendSave(string_view filename)
+{
+	if (!wad_append_save || (iwad_ && iwad_lock))
+		return false;
+
+	vector<uint8_t> append;
+	uint64_t        append_size;
+	return checkAppend(filename, append, append_size);
+}
+
+// -----------------------------------------------------------------------------
+// Checks if the wad can be append-saved to [filename], which must be the
+// (unchanged) wad file it was opened from or last saved to. [append] is set to
+// 1 for each lump that needs to be written, and [append_size] to their total
+// size. Returns false if the wad can't be append-saved, or if too much of the
+// file would be left unused (see wad_append_compact)
+// -----------------------------------------------------------------------------
+bool WadArchive::checkAppend(string_view filename, vector<uint8_t>& append, uint64_t& append_size)
+{
+	// Check the file is this wad's file, unchanged since it was opened/saved.
+	// The size and modification time (which may only have 1 second precision)
+	// are checked first, then the header and directory
+	if (format_ != "wad" || filename_.empty() || !FileUtil::sameFile(filename, filename_)
+		|| FileUtil::fileSize(filename) != file_size_ || FileUtil::fileModifiedTime(filename) != file_time_
+		|| headerCrc(filename) != file_crc_)
+		return false;
+
+	// Determine which lumps need writing
+	uint32_t num_lumps = numEntries();
+	uint64_t kept_size = 0;
+	append.assign(num_lumps, 0);
+	append_size = 0;
 	for (uint32_t l = 0; l < num_lumps; l++)
 	{
-		entry        = entryAt(l);
-		char name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-		long offset  = getEntryOffset(entry);
-		long size    = entry->size();
+		auto entry = entryAt(l);
+		if (entry->state() == ArchiveEntry::State::Unmodified && entry->exProps().propertyExists("Offset")
+			&& getEntryOffset(entry) >= 12 && getEntryOffset(entry) + (uint64_t)entry->size() <= file_size_)
+			kept_size += entry->size();
+		else
+		{
+			append[l] = 1;
+			append_size += entry->size();
+		}
+	}
 
-		for (size_t c = 0; c < entry->name().length() && c < 8; c++)
-			name[c] = entry->name()[c];
+	// Check the resulting wad isn't too big, or has too much unused space
+	uint64_t dir_size   = num_lumps * 16;
+	uint64_t total_size = file_size_ + append_size + dir_size;
+	uint64_t used_size  = 12 + kept_size + append_size + dir_size;
+	if (total_size > 0xFFFFFFFF)
+		return false;
+	if ((total_size - std::min(used_size, total_size)) * 100 > total_size * wad_append_compact)
+		return false;
 
-		file.Write(&offset, 4);
-		file.Write(&size, 4);
-		file.Write(name, 8);
+	return true;
+}
 
-		if (update)
+// -----------------------------------------------------------------------------
+// 'Append-saves' the wad to [filename] if possible (see checkAppend). New and
+// modified lumps are written to the end of the file followed by a new
+// directory, and the header is updated last to point to it. Unmodified lumps
+// are left where they are.
+// Returns false if the wad can't be append-saved, in which case the whole wad
+// should be rewritten instead
+// -----------------------------------------------------------------------------
+bool WadArchive::writeAppend(string_view filename)
+{
+	// Determine which lumps need writing
+	vector<uint8_t> append;
+	uint64_t        append_size;
+	if (!checkAppend(filename, append, append_size))
+		return false;
+	uint32_t num_lumps = numEntries();
+	uint64_t dir_size  = num_lumps * 16;
+
+	// Open the file
+	SFile file(filename, SFile::Mode::ReadWite);
+	if (!file.isOpen() || !file.seekFromEnd(0))
+		return false;
+
+	// Write new/modified lumps to the end of the file
+	vector<uint32_t> offsets(num_lumps);
+	uint32_t         offset = file_size_;
+	bool             ok     = true;
+	for (uint32_t l = 0; ok && l < num_lumps; l++)
+	{
+		auto entry = entryAt(l);
+		if (!append[l])
 		{
-			entry->setState(ArchiveEntry::State::Unmodified);
-			entry->exProp("Offset") = (int)offset;
+			offsets[l] = getEntryOffset(entry);
+			continue;
 		}
+
+		offsets[l] = offset;
+		if (entry->size())
+			ok = file.write(entry->rawData(), entry->size());
+		offset += entry->size();
 	}
 
-	file.Close();
+	// Write the new directory after them
+	uint32_t dir_offset = offset;
+	for (uint32_t l = 0; ok && l < num_lumps; l++)
+		ok = writeDirEntry(file, entryAt(l), offsets[l]);
+
+	// Update the header to point to the new directory. Until this point the
+	// file is still a valid wad with the old directory
+	ok = ok && file.seekFromStart(4) && file.write(&num_lumps, 4) && file.write(&dir_offset, 4);
+	file.close();
+	if (!ok)
+	{
+		Log::warning("Unable to append-save wad {}, rewriting it instead", filename);
+		return false;
+	}
+
+	// Update entry info
+	for (uint32_t l = 0; l < num_lumps; l++)
+	{
+		setEntryOffset(entryAt(l), offsets[l]);
+		entryAt(l)->setState(ArchiveEntry::State::Unmodified);
+	}
+
+	Log::info(2, "Append-saved wad {}, wrote {} bytes", filename, append_size + dir_size + 8);
+
+	setFileInfo(filename);
+	remapFile(filename);
 
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Records the size, modification time and header/directory CRC of the wad file
+// at [filename], used to check it hasn't been changed elsewhere before
+// append-saving to it
+// -----------------------------------------------------------------------------
+void WadArchive::setFileInfo(string_view filename)
+{
+	file_size_ = FileUtil::fileSize(filename);
+	file_time_ = FileUtil::fileExists(filename) ? FileUtil::fileModifiedTime(filename) : 0;
+	file_crc_  = headerCrc(filename);
+}
+
+// -----------------------------------------------------------------------------
+// Maps the wad file at [filename] (if wad_mmap is enabled) and points loaded,
+// unmodified entry data into it
+// -----------------------------------------------------------------------------
+void WadArchive::remapFile(string_view filename)
+{
+	if (!wad_mmap || format_ != "wad")
+		return;
+
+	auto mapped = std::make_shared<MappedFile>();
+	if (mapped->open(string{ filename }))
+	{
+		mapped_file_ = mapped;
+		mapEntryData();
+	}
+	else
+		mapped_file_.reset();
+}
+
 // -----------------------------------------------------------------------------
 // Loads an entry's data from the wadfile
 // Returns true if successful, false otherwise
@@ -692,6 +957,22 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
+	// Stop using the mapped file if it has been truncated since it was mapped
+	if (mapped_file_ && mapped_file_->truncated())
+	{
+		Log::warning("Wad file {} was truncated externally, no longer using its memory mapping", filename_);
+		mapped_file_.reset();
+	}
+
+	// Point to the lump data within the mapped file if possible
+	if (mapped_file_
+		&& entry->data(false).importMapped(mapped_file_, getEntryOffset(entry), entry->size()))
+	{
+		entry->setLoaded();
+		entry->setState(ArchiveEntry::State::Unmodified);
+		return true;
+	}
+
 	// Open wadfile
 	wxFile file(filename_);
 
@@ -713,6 +994,25 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Replaces the data of all loaded, unmodified entries with views into the
+// mapped wad file, freeing any memory used by copies of their data
+// -----------------------------------------------------------------------------
+void WadArchive::mapEntryData()
+{
+	if (!mapped_file_ || mapped_file_->truncated())
+		return;
+
+	for (unsigned a = 0; a < numEntries(); a++)
+	{
+		auto entry = entryAt(a);
+		if (entry->size() == 0 || !entry->isLoaded() || entry->state() != ArchiveEntry::State::Unmodified)
+			continue;
+
+		entry->data(false).importMapped(mapped_file_, getEntryOffset(entry), entry->size());
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Override of Archive::addEntry to force entry addition to the root directory,
 // update namespaces if needed and rename the entry if necessary to be
@@ -1278,8 +1578,8 @@ void WadArchive::detectIncludes()
 ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 {
 	// Init search variables
-	unsigned index     = 0;
-	auto     index_end = numEntries();
+	unsigned index_start = 0;
+	auto     index_end   = numEntries();
 	StrUtil::upperIP(options.match_name);
 
 	// "graphics" namespace is the global namespace in a wad
@@ -1295,9 +1595,9 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 		{
 			if (ns.name == options.match_namespace)
 			{
-				index     = ns.start_index + 1;
-				index_end = ns.end_index + 1;
-				ns_found  = true;
+				index_start = ns.start_index + 1;
+				index_end   = ns.end_index + 1;
+				ns_found    = true;
 				break;
 			}
 		}
@@ -1307,33 +1607,15 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 			return nullptr;
 	}
 
-	// Begin search
-	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	// Search entries within the namespace (names in a wad have no extension)
+	auto opt            = options;
+	opt.match_namespace = "";
+	opt.ignore_ext      = false;
+	for (auto entry : searchCandidates(rootDir().get(), opt))
 	{
-		entry = entryAt(index);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!StrUtil::matches(options.match_name, entry->upperName()))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		return entry;
+		auto index = (unsigned)entryIndex(entry);
+		if (index >= index_start && index < index_end && entryMatches(entry, opt))
+			return entry;
 	}
 
 	// No match found
@@ -1347,7 +1629,7 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 {
 	// Init search variables
-	int index       = numEntries() - 1;
+	int index_end   = numEntries() - 1;
 	int index_start = 0;
 	StrUtil::upperIP(options.match_name);
 
@@ -1368,7 +1650,7 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 		{
 			if (ns.name == options.match_namespace)
 			{
-				index       = ns.end_index - 1;
+				index_end   = ns.end_index - 1;
 				index_start = ns.start_index + 1;
 				ns_found    = true;
 				break;
@@ -1380,33 +1662,16 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 			return nullptr;
 	}
 
-	// Begin search
-	ArchiveEntry* entry;
-	for (; index >= index_start; --index)
+	// Search entries within the namespace (bottom-up)
+	auto opt            = options;
+	opt.match_namespace = "";
+	opt.ignore_ext      = false;
+	auto candidates     = searchCandidates(rootDir().get(), opt);
+	for (auto i = candidates.rbegin(); i != candidates.rend(); ++i)
 	{
-		entry = entryAt(index);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!StrUtil::matches(entry->upperName(), options.match_name))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		return entry;
+		auto index = entryIndex(*i);
+		if (index >= index_start && index <= index_end && entryMatches(*i, opt))
+			return *i;
 	}
 
 	// No match found
@@ -1419,8 +1684,8 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 {
 	// Init search variables
-	unsigned index     = 0;
-	auto     index_end = numEntries();
+	unsigned index_start = 0;
+	auto     index_end   = numEntries();
 	StrUtil::upperIP(options.match_name);
 	vector<ArchiveEntry*> ret;
 
@@ -1438,9 +1703,9 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 		{
 			if (namespaces_[a].name == options.match_namespace)
 			{
-				index     = namespaces_[a].start_index + 1;
-				index_end = namespaces_[a].end_index + 1;
-				ns_found  = true;
+				index_start = namespaces_[a].start_index + 1;
+				index_end   = namespaces_[a].end_index + 1;
+				ns_found    = true;
 				break;
 			}
 		}
@@ -1450,32 +1715,15 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 			return ret;
 	}
 
-	ArchiveEntry* entry;
-	for (; index < index_end; ++index)
+	// Search entries within the namespace
+	auto opt            = options;
+	opt.match_namespace = "";
+	opt.ignore_ext      = false;
+	for (auto entry : searchCandidates(rootDir().get(), opt))
 	{
-		entry = entryAt(index);
-
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->type() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(*entry))
-					continue;
-			}
-			else if (options.match_type != entry->type())
-				continue;
-		}
-
-		// Check name
-		if (!options.match_name.empty())
-		{
-			if (!StrUtil::matches(entry->upperName(), options.match_name))
-				continue;
-		}
-
-		// Entry passed all checks so far, so we found a match
-		ret.push_back(entry);
+		auto index = (unsigned)entryIndex(entry);
+		if (index >= index_start && index < index_end && entryMatches(entry, opt))
+			ret.push_back(entry);
 	}
 
 	// Return search result
@@ -1562,3 +1810,52 @@ bool WadArchive::isWadArchive(const string& filename)
 	// If it's passed to here it's probably a wad file
 	return true;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Opens the wad file at [args[0]] and checks that (with wad_mmap enabled) the
+// file is still mapped after opening, and that entry data points into it
+// rather than being copied into memory
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_wad_mmap, 1, false)
+{
+	if (!wad_mmap)
+	{
+		Log::console("wad_mmap is disabled");
+		return;
+	}
+
+	WadArchive wad;
+	if (!wad.open(args[0]))
+	{
+		Log::console(fmt::format("FAILED: Unable to open {}: {}", args[0], Global::error));
+		return;
+	}
+
+	// Count entries with data still mapped
+	unsigned n_data   = 0;
+	unsigned n_mapped = 0;
+	for (unsigned a = 0; a < wad.numEntries(); a++)
+	{
+		auto entry = wad.entryAt(a);
+		if (entry->size() == 0 || entry->encryption() != ArchiveEntry::Encryption::None)
+			continue;
+
+		n_data++;
+		if (entry->data(false).isMapped())
+			n_mapped++;
+	}
+
+	if (!wad.isMapped() || n_mapped != n_data)
+		Log::console(fmt::format(
+			"FAILED: wad {}mapped, {} of {} entries mapped", wad.isMapped() ? "" : "not ", n_mapped, n_data));
+	else
+		Log::console(fmt::format("OK: wad mapped, all {} entries mapped", n_data));
+}
@@ -2,6 +2,8 @@
 
 #include "Archive/Archive.h"
 
+class MappedFile;
+
 class WadArchive : public TreelessArchive
 {
 public:
@@ -10,17 +12,20 @@ public:
 
 	// Wad specific
 	bool     isIWAD() const { return iwad_; }
+	bool     isMapped() const { return mapped_file_ != nullptr; }
 	bool     isWritable() override;
 	uint32_t getEntryOffset(ArchiveEntry* entry);
 	void     setEntryOffset(ArchiveEntry* entry, uint32_t offset);
 	void     updateNamespaces();
 
 	// Opening
+	bool open(string_view filename) override;
 	bool open(MemChunk& mc) override;
 
 	// Writing/Saving
 	bool write(MemChunk& mc, bool update = true) override;         // Write to MemChunk
 	bool write(string_view filename, bool update = true) override; // Write to File
+	bool canAppendSave(string_view filename) override;
 
 	// Misc
 	bool loadEntryData(ArchiveEntry* entry) override;
@@ -86,6 +91,17 @@ private:
 		NSPair(ArchiveEntry* start, ArchiveEntry* end) : start{ start }, start_index{ 0 }, end{ end }, end_index{ 0 } {}
 	};
 
-	bool           iwad_ = false;
-	vector<NSPair> namespaces_;
+	bool                   iwad_ = false;
+	vector<NSPair>         namespaces_;
+	shared_ptr<MappedFile> mapped_file_;   // The wad file mapped into memory, if opened from disk (see wad_mmap)
+	uint64_t               file_size_ = 0; // Size of the wad file when opened/last saved
+	time_t                 file_time_ = 0; // Modification time of the wad file when opened/last saved
+	uint32_t               file_crc_  = 0; // CRC of the wad file header and directory when opened/last saved
+
+	void mapEntryData();
+	bool writeWad(SeekableData& out, bool update);
+	bool checkAppend(string_view filename, vector<uint8_t>& append, uint64_t& append_size);
+	bool writeAppend(string_view filename);
+	void setFileInfo(string_view filename);
+	void remapFile(string_view filename);
 };
@@ -35,18 +35,32 @@
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "UI/WxUtils.h"
+#include "Utility/Compression.h"
 #include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
+#include <ctime>
 #include <fstream>
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, zip_read_central_dir, true, CVar::Flag::Save) // Open zips by reading the central directory
+CVAR(Int, zip_compression_level, 9, CVar::Flag::Save)    // Deflate level for saved zip entries (0 = store)
+CVAR(Int, zip_save_threads, 0, CVar::Flag::Save)         // Threads used to compress zip entries (0 = auto)
+
+
 // -----------------------------------------------------------------------------
 //
 // External Variables
 //
 // -----------------------------------------------------------------------------
 EXTERN_CVAR(Bool, archive_load_data)
+EXTERN_CVAR(Int, archive_detect_threads)
 
 
 // -----------------------------------------------------------------------------
@@ -71,6 +85,143 @@ struct ZipFileHeader
 	uint16_t len_fn;
 	uint16_t len_extra;
 };
+
+// Zip record signatures and sizes
+const uint32_t ZIP_SIG_LOCAL_HEADER = 0x04034b50;
+const uint32_t ZIP_SIG_DIR_ENTRY    = 0x02014b50;
+const uint32_t ZIP_SIG_DIR_END      = 0x06054b50;
+const unsigned ZIP_SIZE_LOCAL       = 30;
+const unsigned ZIP_SIZE_DIR_ENTRY   = 46;
+const unsigned ZIP_SIZE_DIR_END     = 22;
+
+// Zip record values used when writing
+const uint16_t ZIP_VERSION         = 20;     // Version made by/needed to extract (2.0, MS-DOS)
+const uint16_t ZIP_FLAG_DESCRIPTOR = 0x0008; // Sizes/crc follow the data in a data descriptor
+const uint16_t ZIP_FLAG_UTF8       = 0x0800; // Name is UTF-8 encoded
+const uint32_t ZIP_ATTR_DIR        = 0x10;   // MS-DOS directory attribute
+
+// Maximum amount of (uncompressed) entry data to compress at once when saving
+const unsigned ZIP_WRITE_BATCH_SIZE = 64 * 1024 * 1024;
+
+// Info for a zip record being written
+struct ZipRecord
+{
+	string   name;
+	uint16_t flags        = 0;
+	uint16_t method       = wxZIP_METHOD_STORE;
+	uint16_t mod_time     = 0;
+	uint16_t mod_date     = 0;
+	uint32_t crc          = 0;
+	uint32_t size_comp    = 0;
+	uint32_t size         = 0;
+	uint32_t local_offset = 0;
+	uint32_t ext_attr     = 0;
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns a path in the temp folder for [filename] that doesn't already exist
+// (in case there are multiple zips open with the same name)
+// -----------------------------------------------------------------------------
+string uniqueTempPath(string_view filename)
+{
+	StrUtil::Path tfn(filename);
+	auto          path = App::path(tfn.fileName(), App::Dir::Temp);
+	for (int n = 1; wxFileExists(path); n++)
+		path = App::path(fmt::format("{}.{}", tfn.fileName(), n), App::Dir::Temp);
+
+	return path;
+}
+
+// -----------------------------------------------------------------------------
+// Appends [value] to [buf] in little endian
+// -----------------------------------------------------------------------------
+void putL16(vector<uint8_t>& buf, uint16_t value)
+{
+	buf.push_back(value & 0xFF);
+	buf.push_back(value >> 8);
+}
+void putL32(vector<uint8_t>& buf, uint32_t value)
+{
+	putL16(buf, value & 0xFFFF);
+	putL16(buf, value >> 16);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the current local time in MS-DOS format, as used in zip records
+// -----------------------------------------------------------------------------
+void currentDosTime(uint16_t& time, uint16_t& date)
+{
+	auto now = std::time(nullptr);
+	auto tm  = *std::localtime(&now);
+	time     = (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2);
+	date     = ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the zip record name for [entry], from its path in the archive.
+// Zip names have no leading slash, and directory names end with a slash
+// -----------------------------------------------------------------------------
+string zipRecordName(ArchiveEntry* entry, bool dir)
+{
+	auto name = dir ? entry->path(true) + "/" : entry->path() + Misc::lumpNameToFileName(entry->name());
+	if (StrUtil::startsWith(name, '/'))
+		name.erase(0, 1);
+
+	return name;
+}
+
+// -----------------------------------------------------------------------------
+// Appends the zip local file header for [record] to [buf]
+// -----------------------------------------------------------------------------
+void putLocalHeader(vector<uint8_t>& buf, const ZipRecord& record)
+{
+	putL32(buf, ZIP_SIG_LOCAL_HEADER);
+	putL16(buf, ZIP_VERSION);
+	putL16(buf, record.flags);
+	putL16(buf, record.method);
+	putL16(buf, record.mod_time);
+	putL16(buf, record.mod_date);
+	putL32(buf, record.crc);
+	putL32(buf, record.size_comp);
+	putL32(buf, record.size);
+	putL16(buf, record.name.size());
+	putL16(buf, 0); // Extra field length
+	buf.insert(buf.end(), record.name.begin(), record.name.end());
+}
+
+// -----------------------------------------------------------------------------
+// Appends the zip central directory entry for [record] to [buf]
+// -----------------------------------------------------------------------------
+void putDirEntry(vector<uint8_t>& buf, const ZipRecord& record)
+{
+	putL32(buf, ZIP_SIG_DIR_ENTRY);
+	putL16(buf, ZIP_VERSION); // Version made by
+	putL16(buf, ZIP_VERSION); // Version needed
+	putL16(buf, record.flags);
+	putL16(buf, record.method);
+	putL16(buf, record.mod_time);
+	putL16(buf, record.mod_date);
+	putL32(buf, record.crc);
+	putL32(buf, record.size_comp);
+	putL32(buf, record.size);
+	putL16(buf, record.name.size());
+	putL16(buf, 0); // Extra field length
+	putL16(buf, 0); // Comment length
+	putL16(buf, 0); // Disk number
+	putL16(buf, 0); // Internal attributes
+	putL32(buf, record.ext_attr);
+	putL32(buf, record.local_offset);
+	buf.insert(buf.end(), record.name.begin(), record.name.end());
+}
 } // namespace
 
 
@@ -103,9 +254,14 @@ bool ZipArchive::open(string_view filename)
 		return false;
 	}
 
-	// Copy the zip to a temp file (for use when saving)
-	generateTempFileName(filename);
-	FileUtil::copyFile(filename, temp_file_);
+	// Entry data is read from the file itself as needed, and unmodified entries
+	// are copied from it when saving
+	setSource(filename);
+
+	// Read the zip central directory if possible, so entry data can be loaded
+	// as needed rather than reading through the whole zip
+	if (zip_read_central_dir && readCentralDir(filename))
+		return openFromCentralDir(filename);
 
 	// Open the file
 	wxFFileInputStream in(WxUtils::strFromView(filename));
@@ -127,12 +283,16 @@ bool ZipArchive::open(string_view filename)
 	ArchiveModSignalBlocker sig_blocker{ *this };
 
 	// Go through all zip entries
-	int  entry_index = 0;
-	auto zip_entry   = zip.GetNextEntry();
+	int                   entry_index = 0;
+	int                   batch_start = 0;
+	float                 n_entries   = std::max(zip.GetTotalEntries(), 1);
+	auto                  zip_entry   = zip.GetNextEntry();
+	vector<ArchiveEntry*> batch;
+	size_t                batch_size = 0;
 	UI::setSplashProgressMessage("Reading zip data");
 	while (zip_entry)
 	{
-		UI::setSplashProgress(-1.0f);
+		UI::setSplashProgress((float)entry_index / n_entries);
 		if (zip_entry->GetMethod() != wxZIP_METHOD_DEFLATE && zip_entry->GetMethod() != wxZIP_METHOD_STORE)
 		{
 			Global::error = "Unsupported zip compression method";
@@ -156,30 +316,22 @@ bool ZipArchive::open(string_view filename)
 			auto ndir = createDir(fn.path(true));
 			ndir->addEntry(new_entry);
 
-			// Read the data, if possible
+			// Read the data directly into the entry
 			auto ze_size = zip_entry->GetSize();
-			if (ze_size < 250 * 1024 * 1024)
+			if (ze_size > 0)
 			{
-				if (ze_size > 0)
+				auto& data = new_entry->data(false);
+				if (!data.reSize(ze_size, false) || !zip.ReadAll(data.data(), ze_size))
 				{
-					vector<uint8_t> data(ze_size);
-					zip.Read(data.data(), ze_size); // Note: this is where exceedingly large files cause an exception.
-					new_entry->importMem(data.data(), ze_size);
+					Global::error = fmt::format("Unable to read zip entry {}", fn.fullPath());
+					return false;
 				}
-				new_entry->setLoaded(true);
-
-				// Determine its type
-				EntryType::detectEntryType(*new_entry);
-
-				// Unload data if needed
-				if (!archive_load_data)
-					new_entry->unloadData();
-			}
-			else
-			{
-				Global::error = fmt::format("Entry too large: {} is {} mb", fn.fullPath(), ze_size / (1 << 20));
-				return false;
 			}
+			new_entry->setLoaded(true);
+
+			// Queue for type detection
+			batch.push_back(new_entry.get());
+			batch_size += ze_size;
 		}
 		else
 		{
@@ -192,9 +344,24 @@ bool ZipArchive::open(string_view filename)
 		delete zip_entry;
 		zip_entry = zip.GetNextEntry();
 		entry_index++;
-	}
-	UI::updateSplash();
 
+		// Detect entry types for the current batch once it is big enough (or all entries have been read)
+		if (zip_entry && batch_size < EntryType::DETECT_BATCH_SIZE && batch.size() < EntryType::DETECT_BATCH_COUNT)
+			continue;
+
+		UI::setSplashProgressMessage("Detecting entry types");
+		EntryType::detectEntryTypes(batch, (float)batch_start / n_entries, (float)entry_index / n_entries);
+		batch_start = entry_index;
+
+		// Unload data if needed
+		if (!archive_load_data)
+			for (auto entry : batch)
+				entry->unloadData();
+
+		batch.clear();
+		batch_size = 0;
+		UI::setSplashProgressMessage("Reading zip data");
+	}
 	// Set all entries/directories to unmodified
 	vector<ArchiveEntry*> entry_list;
 	putEntryTreeAsList(entry_list);
@@ -220,17 +387,18 @@ bool ZipArchive::open(string_view filename)
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(MemChunk& mc)
 {
-	// Write the MemChunk to a temp file
-	auto tempfile = App::path("slade-temp-open.zip", App::Dir::Temp);
-	mc.exportFile(tempfile);
+	// Write the MemChunk to a temp file, which is kept to read entry data from
+	if (FileUtil::fileExists(temp_file_))
+		FileUtil::removeFile(temp_file_);
+	temp_file_ = uniqueTempPath("slade-temp-open.zip");
+	if (!mc.exportFile(temp_file_))
+	{
+		Global::error = "Unable to write temp file";
+		return false;
+	}
 
 	// Load the file
-	bool success = open(tempfile);
-
-	// Clean up
-	FileUtil::removeFile(tempfile);
-
-	return success;
+	return open(temp_file_);
 }
 
 // -----------------------------------------------------------------------------
@@ -239,18 +407,23 @@ bool ZipArchive::open(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(MemChunk& mc, bool update)
 {
-	bool success = false;
-
 	// Write to a temporary file
-	auto tempfile = App::path("slade-temp-write.zip", App::Dir::Temp);
-	if (write(tempfile, true))
+	auto tempfile = uniqueTempPath("slade-temp-write.zip");
+	if (!write(tempfile, update))
 	{
-		// Load file into MemChunk
-		success = mc.importFile(tempfile);
+		FileUtil::removeFile(tempfile);
+		return false;
 	}
 
-	// Clean up
-	wxRemoveFile(tempfile);
+	// Load file into MemChunk
+	bool success = mc.importFile(tempfile);
+
+	// If [update] is true the written file is now the source of entry data, so
+	// keep it until it is no longer needed
+	if (update)
+		temp_file_ = tempfile;
+	else
+		FileUtil::removeFile(tempfile);
 
 	return success;
 }
@@ -261,111 +434,79 @@ bool ZipArchive::write(MemChunk& mc, bool update)
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(string_view filename, bool update)
 {
-	// Open the file
-	wxFFileOutputStream out(WxUtils::strFromView(filename));
-	if (!out.IsOk())
-	{
-		Global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
-		return false;
-	}
+	// Get a linear list of all entries in the archive
+	vector<ArchiveEntry*> entries;
+	putEntryTreeAsList(entries);
 
-	// Open as zip for writing
-	wxZipOutputStream zip(out, 9);
-	if (!zip.IsOk())
+	// Check the source file hasn't been changed elsewhere if any entry data
+	// still needs to be read from it
+	bool source_ok = sourceValid();
+	if (!source_ok)
 	{
-		Global::error = "Unable to create zip for saving";
-		return false;
+		for (auto entry : entries)
+			if (!entry->isLoaded() && entry->size() > 0)
+			{
+				Global::error = "The zip file has been modified or removed outside of SLADE, unable to save";
+				return false;
+			}
 	}
 
-	// Open old zip for copying, from the temp file that was copied on opening.
-	// This is used to copy any entries that have been previously saved/compressed
-	// and are unmodified, to greatly speed up zip file saving by not having to
-	// recompress unchanged entries
-	unique_ptr<wxFFileInputStream> in;
-	unique_ptr<wxZipInputStream>   inzip;
-	vector<wxZipEntry*>            c_entries;
-	if (FileUtil::fileExists(temp_file_))
+	// If the source file is about to be overwritten, copy it first so data can
+	// still be copied from it
+	if (source_ok && FileUtil::sameFile(filename, source_file_))
 	{
-		in    = std::make_unique<wxFFileInputStream>(temp_file_);
-		inzip = std::make_unique<wxZipInputStream>(*in);
-
-		if (inzip->IsOk())
-		{
-			// Get a list of all entries in the old zip
-			c_entries.resize(inzip->GetTotalEntries());
-			for (unsigned a = 0; a < c_entries.size(); a++)
-				c_entries[a] = inzip->GetNextEntry();
-		}
-		else
+		if (FileUtil::fileExists(temp_file_))
+			FileUtil::removeFile(temp_file_);
+		temp_file_ = uniqueTempPath(filename);
+		if (!FileUtil::copyFile(source_file_, temp_file_))
 		{
-			in    = nullptr;
-			inzip = nullptr;
+			Global::error = "Unable to copy zip file for saving";
+			return false;
 		}
+		setSource(temp_file_);
 	}
 
-	// Get a linear list of all entries in the archive
-	vector<ArchiveEntry*> entries;
-	putEntryTreeAsList(entries);
-
-	// Go through all entries
-	for (size_t a = 0; a < entries.size(); a++)
+	// Get the central directory of the source file if needed, for copying
+	// unmodified entries directly
+	if (zip_dir_.empty() && source_ok)
+		readCentralDir(source_file_);
+
+	// Write the zip. wxZipOutputStream is used instead if zip64 records are
+	// needed, or if the source file's central directory couldn't be read (wx
+	// can still copy unmodified entries from it in that case)
+	bool use_wx  = entries.size() >= 0xFFFF || (zip_dir_.empty() && source_ok);
+	bool too_big = false;
+	if (!use_wx && !writeParallel(filename, entries, update, too_big))
 	{
-		if (entries[a]->type() == EntryType::folderType())
-		{
-			// If the current entry is a folder, just write a directory entry and continue
-			zip.PutNextDirEntry(entries[a]->path(true));
-			if (update)
-				entries[a]->setState(ArchiveEntry::State::Unmodified);
-			continue;
-		}
-
-		// Get entry zip index
-		int index = -1;
-		if (entries[a]->exProps().propertyExists("ZipIndex"))
-			index = entries[a]->exProp("ZipIndex");
-
-		auto saname = Misc::lumpNameToFileName(entries[a]->name());
-		if (!inzip || entries[a]->state() != ArchiveEntry::State::Unmodified || index < 0
-			|| index >= inzip->GetTotalEntries())
-		{
-			// If the current entry has been changed, or doesn't exist in the old zip,
-			// (re)compress its data and write it to the zip
-			auto zipentry = new wxZipEntry(entries[a]->path() + saname);
-			zip.PutNextEntry(zipentry);
-			zip.Write(entries[a]->rawData(), entries[a]->size());
-		}
-		else
-		{
-			// If the entry is unmodified and exists in the old zip, just copy it over
-			c_entries[index]->SetName(entries[a]->path() + saname);
-			zip.CopyEntry(c_entries[index], *inzip);
-			inzip->Reset();
-		}
+		if (!too_big)
+			return false;
 
-		// Update entry info
-		if (update)
-		{
-			entries[a]->setState(ArchiveEntry::State::Unmodified);
-			entries[a]->exProp("ZipIndex") = (int)a;
-		}
+		use_wx = true;
 	}
+	if (use_wx && !writeWx(filename, entries, update))
+		return false;
 
-	// Clean up
-	zip.Close();
-	out.Close();
-
-	// Update the temp file
-	if (temp_file_.empty())
-		generateTempFileName(filename);
-	FileUtil::copyFile(filename, temp_file_);
+	// The written file is now the source of entry data (entry zip indices only
+	// match it if [update] is true)
+	if (update)
+	{
+		setSource(filename);
+		if (!zip_read_central_dir || !readCentralDir(filename))
+			zip_dir_.clear();
+
+		// Remove any previous temp copy, it's no longer needed
+		if (FileUtil::fileExists(temp_file_))
+			FileUtil::removeFile(temp_file_);
+		temp_file_.clear();
+	}
 
 	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Loads an entry's data from the saved copy of the archive if any.
+// Loads an entry's data from the source zip file.
 // Returns false if the entry is invalid, doesn't belong to the archive or
-// doesn't exist in the saved copy, true otherwise.
+// doesn't exist in the source file, true otherwise.
 // -----------------------------------------------------------------------------
 bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 {
@@ -394,11 +535,40 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 		return false;
 	}
 
+	// Check the source file hasn't been changed elsewhere
+	if (!sourceValid())
+	{
+		Log::error("ZipArchive::loadEntryData: Zip file \"{}\" has been modified or removed!", source_file_);
+		return false;
+	}
+
+	// Read the entry data directly if we have the central directory of the
+	// source file
+	if (zip_index >= 0 && zip_index < (int)zip_dir_.size())
+	{
+		SFile file(source_file_);
+		if (!file.isOpen())
+		{
+			Log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", source_file_);
+			return false;
+		}
+
+		if (!readEntryData(file, zip_dir_[zip_index], entry->data(false)))
+		{
+			Log::error("ZipArchive::loadEntryData: Unable to read data for entry \"{}\"", entry->name());
+			entry->data(false).clear();
+			return false;
+		}
+
+		entry->setLoaded();
+		return true;
+	}
+
 	// Open the file
-	wxFFileInputStream in(filename_);
+	wxFFileInputStream in(source_file_);
 	if (!in.IsOk())
 	{
-		Log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", filename_);
+		Log::error("ZipArchive::loadEntryData: Unable to open zip file \"{}\"!", source_file_);
 		return false;
 	}
 
@@ -406,7 +576,7 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 	wxZipInputStream zip(in);
 	if (!zip.IsOk())
 	{
-		Log::error("ZipArchive::loadEntryData: Invalid zip file \"{}\"!", filename_);
+		Log::error("ZipArchive::loadEntryData: Invalid zip file \"{}\"!", source_file_);
 		return false;
 	}
 
@@ -636,27 +806,646 @@ vector<ArchiveEntry*> ZipArchive::findAll(SearchOptions& options)
 }
 
 // -----------------------------------------------------------------------------
-// Generates the temp file path to use, from [filename].
-// The temp file will be in the configured temp folder
+// Writes [entries] to a zip file at [filename] using wxZipOutputStream.
+// Unmodified entries are copied from the source zip file if it is unchanged.
+// Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
-void ZipArchive::generateTempFileName(string_view filename)
+bool ZipArchive::writeWx(string_view filename, const vector<ArchiveEntry*>& entries, bool update) const
 {
-	StrUtil::Path tfn(filename);
-	temp_file_ = App::path(tfn.fileName(), App::Dir::Temp);
-	if (wxFileExists(temp_file_))
+	// Open the file
+	wxFFileOutputStream out(WxUtils::strFromView(filename));
+	if (!out.IsOk())
+	{
+		Global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+		return false;
+	}
+
+	// Open as zip for writing
+	wxZipOutputStream zip(out, std::clamp<int>(zip_compression_level, 0, 9));
+	if (!zip.IsOk())
+	{
+		Global::error = "Unable to create zip for saving";
+		return false;
+	}
+
+	// Open the source zip for copying. This is used to copy any entries that
+	// have been previously saved/compressed and are unmodified, to greatly speed
+	// up zip file saving by not having to recompress unchanged entries
+	unique_ptr<wxFFileInputStream> in;
+	unique_ptr<wxZipInputStream>   inzip;
+	vector<wxZipEntry*>            c_entries;
+	if (sourceValid())
+	{
+		in    = std::make_unique<wxFFileInputStream>(source_file_);
+		inzip = std::make_unique<wxZipInputStream>(*in);
+
+		if (inzip->IsOk())
+		{
+			// Get a list of all entries in the old zip
+			c_entries.resize(inzip->GetTotalEntries());
+			for (unsigned a = 0; a < c_entries.size(); a++)
+				c_entries[a] = inzip->GetNextEntry();
+		}
+		else
+		{
+			in    = nullptr;
+			inzip = nullptr;
+		}
+	}
+
+	// Go through all entries
+	for (size_t a = 0; a < entries.size(); a++)
 	{
-		// Make sure we don't overwrite an existing temp file
-		// (in case there are multiple zips open with the same name)
-		int n = 1;
-		while (true)
+		if (entries[a]->type() == EntryType::folderType())
+		{
+			// If the current entry is a folder, just write a directory entry and continue
+			zip.PutNextDirEntry(entries[a]->path(true));
+			if (update)
+				entries[a]->setState(ArchiveEntry::State::Unmodified);
+			continue;
+		}
+
+		// Get entry zip index
+		int index = -1;
+		if (entries[a]->exProps().propertyExists("ZipIndex"))
+			index = entries[a]->exProp("ZipIndex");
+
+		auto saname = Misc::lumpNameToFileName(entries[a]->name());
+		if (!inzip || entries[a]->state() != ArchiveEntry::State::Unmodified || index < 0
+			|| index >= inzip->GetTotalEntries())
 		{
-			temp_file_ = App::path(fmt::format("{}.{}", tfn.fileName(), n), App::Dir::Temp);
-			if (!wxFileExists(temp_file_))
+			// If the current entry has been changed, or doesn't exist in the old zip,
+			// (re)compress its data and write it to the zip
+			auto zipentry = new wxZipEntry(entries[a]->path() + saname);
+			zip.PutNextEntry(zipentry);
+			zip.Write(entries[a]->rawData(), entries[a]->size());
+		}
+		else
+		{
+			// If the entry is unmodified and exists in the old zip, just copy it over
+			c_entries[index]->SetName(entries[a]->path() + saname);
+			zip.CopyEntry(c_entries[index], *inzip);
+			inzip->Reset();
+		}
+
+		// Update entry info
+		if (update)
+		{
+			entries[a]->setState(ArchiveEntry::State::Unmodified);
+			entries[a]->exProp("ZipIndex") = (int)a;
+		}
+	}
+
+	// Clean up
+	zip.Close();
+	out.Close();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [entries] to a zip file at [filename]. Modified entries are
+// compressed in batches on worker threads, then written in order along with
+// unmodified entries, whose (still compressed) data is copied directly from
+// its byte range in the source file.
+// Returns true if successful, false otherwise. If the zip would be too big to
+// write without zip64 records, [too_big] is set to true
+// -----------------------------------------------------------------------------
+bool ZipArchive::writeParallel(
+	string_view                  filename,
+	const vector<ArchiveEntry*>& entries,
+	bool                         update,
+	bool&                        too_big) const
+{
+	// Open the file
+	SFile file(filename, SFile::Mode::Write);
+	if (!file.isOpen())
+	{
+		Global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+		return false;
+	}
+
+	// Open the source zip for copying unmodified entries
+	SFile old_file;
+	if (!zip_dir_.empty() && sourceValid())
+		old_file.open(source_file_);
+
+	uint16_t mod_time, mod_date;
+	currentDosTime(mod_time, mod_date);
+
+	// Setup zip records, determine which entries need compressing
+	auto              folder_type = EntryType::folderType();
+	vector<ZipRecord> records(entries.size());
+	vector<int>       copy_index(entries.size(), -1);
+	for (unsigned a = 0; a < entries.size(); a++)
+	{
+		auto  entry  = entries[a];
+		auto& record = records[a];
+		bool  dir    = entry->type() == folder_type;
+
+		record.name     = zipRecordName(entry, dir);
+		record.mod_time = mod_time;
+		record.mod_date = mod_date;
+		for (auto c : record.name)
+			if (c & 0x80)
+			{
+				record.flags |= ZIP_FLAG_UTF8;
 				break;
+			}
+
+		if (dir)
+		{
+			record.ext_attr = ZIP_ATTR_DIR;
+			continue;
+		}
+
+		// Check if the entry can be copied from the source zip
+		int index = -1;
+		if (entry->exProps().propertyExists("ZipIndex"))
+			index = entry->exProp("ZipIndex");
+		if (old_file.isOpen() && entry->state() == ArchiveEntry::State::Unmodified && index >= 0
+			&& index < (int)zip_dir_.size())
+		{
+			const auto& ze = zip_dir_[index];
+			if (!ze.isDir() && !(ze.flags & 1)
+				&& (ze.method == wxZIP_METHOD_DEFLATE || ze.method == wxZIP_METHOD_STORE))
+				copy_index[a] = index;
+		}
+	}
+
+	// Compress and write entries in batches
+	int             level  = std::clamp<int>(zip_compression_level, 0, 9);
+	uint64_t        offset = 0;
+	vector<uint8_t> header;
+	unsigned        start = 0;
+	while (start < entries.size())
+	{
+		// Get the next batch of entries, loading data for those to compress
+		vector<unsigned> compress;
+		unsigned         end        = start;
+		size_t           batch_size = 0;
+		while (end < entries.size() && batch_size < ZIP_WRITE_BATCH_SIZE)
+		{
+			if (copy_index[end] < 0 && records[end].ext_attr != ZIP_ATTR_DIR)
+			{
+				batch_size += entries[end]->data().size();
+				compress.push_back(end);
+			}
+			end++;
+		}
+
+		// Compress entry data in parallel
+		vector<MemChunk> compressed(compress.size());
+		ThreadPool::runParallel(
+			compress.size(),
+			[&](size_t index) {
+				auto& data   = entries[compress[index]]->data(false);
+				auto& record = records[compress[index]];
+				record.crc   = data.crc();
+				record.size  = data.size();
+
+				// Use deflate unless it doesn't make the data any smaller
+				if (level > 0 && data.size() > 0 && Compression::zipDeflate(data, compressed[index], level)
+					&& compressed[index].size() < data.size())
+					record.method = wxZIP_METHOD_DEFLATE;
+				else
+					compressed[index].clear();
+			},
+			ThreadPool::numThreads(zip_save_threads));
+
+		// Write the batch
+		unsigned c = 0;
+		MemChunk copy_data;
+		for (unsigned a = start; a < end; a++)
+		{
+			auto&          record = records[a];
+			const uint8_t* data   = nullptr;
+
+			if (copy_index[a] >= 0)
+			{
+				// Copy data from source zip as-is
+				const auto& ze = zip_dir_[copy_index[a]];
+				if (ze.size_comp > 0 && (!seekToEntryData(old_file, ze) || !old_file.read(copy_data, ze.size_comp)))
+				{
+					Global::error = fmt::format("Unable to copy zip entry {}", ze.name);
+					return false;
+				}
+				record.flags |= ze.flags & ~(ZIP_FLAG_DESCRIPTOR | ZIP_FLAG_UTF8);
+				record.method    = ze.method;
+				record.mod_time  = ze.mod_time;
+				record.mod_date  = ze.mod_date;
+				record.crc       = ze.crc;
+				record.size_comp = ze.size_comp;
+				record.size      = ze.size;
+				data             = copy_data.data();
+			}
+			else if (record.ext_attr != ZIP_ATTR_DIR)
+			{
+				// Compressed (or stored) data
+				if (record.method == wxZIP_METHOD_DEFLATE)
+					data = compressed[c].data();
+				else
+					data = entries[a]->rawData(false);
+				record.size_comp = record.method == wxZIP_METHOD_DEFLATE ? compressed[c].size() : record.size;
+				c++;
+			}
+
+			// Check the zip doesn't need zip64
+			if (offset + ZIP_SIZE_LOCAL + record.name.size() + record.size_comp > 0xFFFFFFFF)
+			{
+				too_big = true;
+				return false;
+			}
+
+			// Write local header + data
+			record.local_offset = offset;
+			header.clear();
+			putLocalHeader(header, record);
+			if (!file.write(header.data(), header.size())
+				|| (record.size_comp > 0 && !file.write(data, record.size_comp)))
+			{
+				Global::error = "Unable to write zip file";
+				return false;
+			}
+			offset += header.size() + record.size_comp;
+		}
+
+		start = end;
+	}
+
+	// Write central directory
+	header.clear();
+	for (const auto& record : records)
+		putDirEntry(header, record);
+	if (offset + header.size() + ZIP_SIZE_DIR_END > 0xFFFFFFFF)
+	{
+		too_big = true;
+		return false;
+	}
+	auto dir_size = header.size();
+	putL32(header, ZIP_SIG_DIR_END);
+	putL16(header, 0); // Disk number
+	putL16(header, 0); // Central directory disk
+	putL16(header, records.size());
+	putL16(header, records.size());
+	putL32(header, dir_size);
+	putL32(header, offset);
+	putL16(header, 0); // Comment length
+	if (!file.write(header.data(), header.size()))
+	{
+		Global::error = "Unable to write zip file";
+		return false;
+	}
+
+	// Update entry info
+	if (update)
+	{
+		for (unsigned a = 0; a < entries.size(); a++)
+		{
+			entries[a]->setState(ArchiveEntry::State::Unmodified);
+			if (entries[a]->type() != folder_type)
+				entries[a]->exProp("ZipIndex") = (int)a;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sets the file that entry data is read (and unmodified entries are copied)
+// from to [path], recording its size and modification time so that changes
+// to it from elsewhere can be detected
+// -----------------------------------------------------------------------------
+void ZipArchive::setSource(string_view path)
+{
+	source_file_ = path;
+	source_size_ = FileUtil::fileSize(path);
+	source_time_ = FileUtil::fileExists(path) ? FileUtil::fileModifiedTime(path) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the source file exists and hasn't been changed since it
+// was set (see setSource)
+// -----------------------------------------------------------------------------
+bool ZipArchive::sourceValid() const
+{
+	return !source_file_.empty() && FileUtil::fileExists(source_file_)
+		   && FileUtil::fileSize(source_file_) == source_size_
+		   && FileUtil::fileModifiedTime(source_file_) == source_time_;
+}
+// -----------------------------------------------------------------------------
+// Reads the central directory of the zip file at [filename] into zip_dir_.
+// Returns false (and clears zip_dir_) if the central directory couldn't be
+// read or uses features that aren't supported here (zip64, multiple disks)
+// -----------------------------------------------------------------------------
+bool ZipArchive::readCentralDir(string_view filename)
+{
+	zip_dir_.clear();
+
+	SFile file(string{ filename });
+	if (!file.isOpen() || file.size() < ZIP_SIZE_DIR_END)
+		return false;
+
+	// Find the end of central directory record, it's at the end of the file
+	// followed by a comment of up to 64kb
+	auto     search_size = std::min<unsigned>(file.size(), ZIP_SIZE_DIR_END + 0xFFFF);
+	MemChunk tail;
+	if (!file.seekFromStart(file.size() - search_size) || !file.read(tail, search_size))
+		return false;
+	int dir_end = -1;
+	for (int a = search_size - ZIP_SIZE_DIR_END; a >= 0; a--)
+	{
+		if (tail.readL32(a) == ZIP_SIG_DIR_END)
+		{
+			dir_end = a;
+			break;
+		}
+	}
+	if (dir_end < 0)
+		return false;
+
+	// Read end of central directory record
+	unsigned disk        = tail.readL16(dir_end + 4);
+	unsigned dir_disk    = tail.readL16(dir_end + 6);
+	unsigned num_entries = tail.readL16(dir_end + 10);
+	unsigned dir_size    = tail.readL32(dir_end + 12);
+	unsigned dir_offset  = tail.readL32(dir_end + 16);
+	if (disk != 0 || dir_disk != 0 || num_entries == 0xFFFF || dir_offset == 0xFFFFFFFF
+		|| (uint64_t)dir_offset + dir_size > file.size())
+		return false;
+
+	// Read central directory
+	MemChunk dir;
+	if (dir_size > 0 && (!file.seekFromStart(dir_offset) || !file.read(dir, dir_size)))
+		return false;
+
+	vector<ZipDirEntry> entries(num_entries);
+	unsigned            pos = 0;
+	for (auto& zip_entry : entries)
+	{
+		if (pos + ZIP_SIZE_DIR_ENTRY > dir.size() || dir.readL32(pos) != ZIP_SIG_DIR_ENTRY)
+			return false;
+
+		zip_entry.flags        = dir.readL16(pos + 8);
+		zip_entry.method       = dir.readL16(pos + 10);
+		zip_entry.mod_time     = dir.readL16(pos + 12);
+		zip_entry.mod_date     = dir.readL16(pos + 14);
+		zip_entry.crc          = dir.readL32(pos + 16);
+		zip_entry.size_comp    = dir.readL32(pos + 20);
+		zip_entry.size         = dir.readL32(pos + 24);
+		zip_entry.local_offset = dir.readL32(pos + 42);
+		unsigned len_name      = dir.readL16(pos + 28);
+		unsigned len_extra     = dir.readL16(pos + 30);
+		unsigned len_comment   = dir.readL16(pos + 32);
+
+		// Check for zip64 values
+		if (zip_entry.size_comp == 0xFFFFFFFF || zip_entry.size == 0xFFFFFFFF
+			|| zip_entry.local_offset == 0xFFFFFFFF)
+			return false;
+
+		if (pos + ZIP_SIZE_DIR_ENTRY + len_name > dir.size())
+			return false;
+		zip_entry.name.assign(reinterpret_cast<const char*>(dir.data() + pos + ZIP_SIZE_DIR_ENTRY), len_name);
+
+		pos += ZIP_SIZE_DIR_ENTRY + len_name + len_extra + len_comment;
+	}
+
+	zip_dir_ = std::move(entries);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Opens the zip file at [filename] using the already-read central directory
+// (see readCentralDir). Entry data is read and inflated in batches (in
+// parallel) for type detection, and unloaded again afterwards unless
+// archive_load_data is set
+// -----------------------------------------------------------------------------
+bool ZipArchive::openFromCentralDir(string_view filename)
+{
+	// Check all entries are supported
+	for (const auto& zip_entry : zip_dir_)
+	{
+		if (zip_entry.isDir())
+			continue;
+
+		if (zip_entry.flags & 1)
+		{
+			Global::error = "Encrypted zip entries are not supported";
+			return false;
+		}
+		if (zip_entry.method != wxZIP_METHOD_DEFLATE && zip_entry.method != wxZIP_METHOD_STORE)
+		{
+			Global::error = "Unsupported zip compression method";
+			return false;
+		}
+	}
+
+	// Open the file
+	SFile file(string{ filename });
+	if (!file.isOpen())
+	{
+		Global::error = "Unable to open file";
+		return false;
+	}
+
+	// Stop announcements (don't want to be announcing modification due to entries being added etc)
+	ArchiveModSignalBlocker sig_blocker{ *this };
+
+	// Go through all zip entries
+	vector<ArchiveEntry*>      batch;
+	vector<const ZipDirEntry*> batch_zip;
+	size_t                     batch_size  = 0;
+	unsigned                   batch_start = 0;
+	unsigned                   n_entries   = zip_dir_.size();
+	UI::setSplashProgressMessage("Reading zip data");
+	for (unsigned a = 0; a < n_entries; a++)
+	{
+		const auto&   zip_entry = zip_dir_[a];
+		StrUtil::Path fn(zip_entry.name);
+
+		if (zip_entry.isDir())
+		{
+			// Zip entry is a directory, add it to the directory tree
+			createDir(fn.path(true));
+		}
+		else
+		{
+			// Create entry
+			auto new_entry = std::make_shared<ArchiveEntry>(Misc::fileNameToLumpName(fn.fileName()), zip_entry.size);
+			new_entry->setLoaded(false);
+			new_entry->exProp("ZipIndex") = (int)a;
+
+			// Add entry and directory to directory tree
+			auto ndir = createDir(fn.path(true));
+			ndir->addEntry(new_entry);
+
+			// Queue for data reading + type detection
+			batch.push_back(new_entry.get());
+			batch_zip.push_back(&zip_entry);
+			batch_size += zip_entry.size;
+		}
+
+		// Process the current batch once it is big enough (or all entries have been read)
+		if (a < n_entries - 1 && batch_size < EntryType::DETECT_BATCH_SIZE
+			&& batch.size() < EntryType::DETECT_BATCH_COUNT)
+			continue;
+
+		// Read entry data (stored entries directly, compressed data for deflated
+		// entries so it can be inflated in parallel below)
+		vector<MemChunk> compressed(batch.size());
+		for (unsigned b = 0; b < batch.size(); b++)
+		{
+			auto  ze   = batch_zip[b];
+			auto& data = batch[b]->data(false);
+			if (ze->size == 0)
+				continue;
+
+			bool ok = seekToEntryData(file, *ze) && data.reSize(ze->size, false);
+			if (ok && ze->method == wxZIP_METHOD_STORE)
+				ok = file.read(data.data(), ze->size);
+			else if (ok)
+				ok = ze->size_comp > 0 && file.read(compressed[b], ze->size_comp);
+
+			if (!ok)
+			{
+				Global::error = fmt::format("Unable to read zip entry {}", ze->name);
+				return false;
+			}
+		}
+
+		// Inflate compressed entry data and check the CRC of all entry data
+		vector<uint8_t> failed(batch.size(), 0);
+		ThreadPool::runParallel(
+			batch.size(),
+			[&](size_t index) {
+				auto& data = batch[index]->data(false);
+				if (data.size() == 0)
+					return;
 
-			n++;
+				if (compressed[index].size() > 0)
+				{
+					auto& in = compressed[index];
+					in.seek(0, SEEK_SET);
+					bool ok = Compression::zipInflateStream(in, in.size(), data.data(), data.size());
+					in.clear();
+					if (!ok)
+					{
+						failed[index] = 1;
+						return;
+					}
+				}
+
+				if (data.crc() != batch_zip[index]->crc)
+					failed[index] = 2;
+			},
+			ThreadPool::numThreads(archive_detect_threads));
+
+		for (unsigned b = 0; b < batch.size(); b++)
+		{
+			if (failed[b] == 1)
+			{
+				Global::error = fmt::format("Unable to inflate zip entry {}", batch_zip[b]->name);
+				return false;
+			}
+			if (failed[b] == 2)
+			{
+				Global::error = fmt::format("CRC mismatch in zip entry {}", batch_zip[b]->name);
+				Log::error("ZipArchive::openFromCentralDir: {}", Global::error);
+				return false;
+			}
+			batch[b]->setLoaded();
+		}
+
+		// Detect entry types
+		UI::setSplashProgressMessage("Detecting entry types");
+		EntryType::detectEntryTypes(batch, (float)batch_start / (float)n_entries, (float)(a + 1) / (float)n_entries);
+		batch_start = a + 1;
+
+		// Unload data if needed
+		for (auto entry : batch)
+		{
+			entry->setState(ArchiveEntry::State::Unmodified);
+			if (!archive_load_data)
+				entry->unloadData();
 		}
+
+		batch.clear();
+		batch_zip.clear();
+		batch_size = 0;
+		UI::setSplashProgressMessage("Reading zip data");
+	}
+
+	// Set all entries/directories to unmodified
+	vector<ArchiveEntry*> entry_list;
+	putEntryTreeAsList(entry_list);
+	for (auto& entry : entry_list)
+		entry->setState(ArchiveEntry::State::Unmodified);
+
+	// Enable announcements
+	sig_blocker.unblock();
+
+	// Setup variables
+	filename_ = filename;
+	setModified(false);
+	on_disk_ = true;
+
+	UI::setSplashProgressMessage("");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Seeks [file] to the start of the data for [zip_entry] (after its local file
+// header). Returns false if the local file header is invalid
+// -----------------------------------------------------------------------------
+bool ZipArchive::seekToEntryData(SFile& file, const ZipDirEntry& zip_entry) const
+{
+	uint8_t header[ZIP_SIZE_LOCAL];
+	if (!file.seekFromStart(zip_entry.local_offset) || !file.read(header, ZIP_SIZE_LOCAL))
+		return false;
+
+	// Check signature
+	auto sig = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+	if (sig != ZIP_SIG_LOCAL_HEADER)
+		return false;
+
+	// Skip filename and extra field (can differ from those in the central directory)
+	unsigned len_name  = header[26] | (header[27] << 8);
+	unsigned len_extra = header[28] | (header[29] << 8);
+	return file.seek(len_name + len_extra);
+}
+
+// -----------------------------------------------------------------------------
+// Reads (and decompresses if needed) the data for [zip_entry] from [file] into
+// [data]. Compressed data is inflated as it is read rather than being read into
+// memory first. Returns false if the data couldn't be read or doesn't match
+// the entry's CRC
+// -----------------------------------------------------------------------------
+bool ZipArchive::readEntryData(SFile& file, const ZipDirEntry& zip_entry, MemChunk& data) const
+{
+	if (zip_entry.size == 0)
+	{
+		data.clear();
+		return true;
 	}
+
+	if (!seekToEntryData(file, zip_entry) || !data.reSize(zip_entry.size, false))
+		return false;
+
+	bool ok;
+	if (zip_entry.method == wxZIP_METHOD_STORE)
+		ok = file.read(data.data(), zip_entry.size);
+	else
+		ok = Compression::zipInflateStream(file, zip_entry.size_comp, data.data(), zip_entry.size);
+
+	// Check the data against its CRC from the central directory
+	if (ok && data.crc() != zip_entry.crc)
+	{
+		Log::error("ZipArchive::readEntryData: CRC mismatch in zip entry {}", zip_entry.name);
+		return false;
+	}
+
+	return ok;
 }
 
 
@@ -2,6 +2,8 @@
 
 #include "Archive/Archive.h"
 
+class SFile;
+
 class ZipArchive : public Archive
 {
 public:
@@ -36,7 +38,34 @@ public:
 	static bool isZipArchive(const string& filename);
 
 private:
-	string temp_file_;
+	// Entry info read from the zip central directory
+	struct ZipDirEntry
+	{
+		string   name;
+		uint16_t flags        = 0;
+		uint16_t method       = 0;
+		uint16_t mod_time     = 0;
+		uint16_t mod_date     = 0;
+		uint32_t crc          = 0;
+		uint32_t size_comp    = 0;
+		uint32_t size         = 0;
+		uint32_t local_offset = 0;
+
+		bool isDir() const { return !name.empty() && name.back() == '/'; }
+	};
+
+	string              source_file_; // File entry data is read from (the zip file, or temp_file_)
+	uint64_t            source_size_ = 0;
+	time_t              source_time_ = 0;
+	string              temp_file_; // Temp copy of the zip, only made when needed
+	vector<ZipDirEntry> zip_dir_;   // Central directory of source_file_ (indexed by ZipIndex), if it could be read
 
-	void generateTempFileName(string_view filename);
+	bool writeWx(string_view filename, const vector<ArchiveEntry*>& entries, bool update) const;
+	bool writeParallel(string_view filename, const vector<ArchiveEntry*>& entries, bool update, bool& too_big) const;
+	void setSource(string_view path);
+	bool sourceValid() const;
+	bool readCentralDir(string_view filename);
+	bool openFromCentralDir(string_view filename);
+	bool seekToEntryData(SFile& file, const ZipDirEntry& zip_entry) const;
+	bool readEntryData(SFile& file, const ZipDirEntry& zip_entry, MemChunk& data) const;
 };
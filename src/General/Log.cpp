@@ -33,6 +33,7 @@
 #include "App.h"
 #include "thirdparty/fmt/fmt/time.h"
 #include <fstream>
+#include <mutex>
 
 
 // -----------------------------------------------------------------------------
@@ -44,6 +45,7 @@ namespace Log
 {
 vector<Message> log;
 std::ofstream   log_file;
+std::mutex      log_mutex;
 } // namespace Log
 CVAR(Int, log_verbosity, 1, CVar::Flag::Save)
 
@@ -153,11 +155,15 @@ void Log::init()
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Returns a copy of the log message history, starting from message [start]
 // -----------------------------------------------------------------------------
-const vector<Log::Message>& Log::history()
+vector<Log::Message> Log::history(size_t start)
 {
-	return log;
+	std::lock_guard<std::mutex> lock(log_mutex);
+	if (start >= log.size())
+		return {};
+
+	return { log.begin() + start, log.end() };
 }
 
 // -----------------------------------------------------------------------------
@@ -182,8 +188,9 @@ void Log::setVerbosity(int verbosity)
 // -----------------------------------------------------------------------------
 void Log::message(MessageType type, string_view text)
 {
-	// Add log message
-	auto t = std::time(nullptr);
+	// Add log message (can be called from worker threads)
+	std::lock_guard<std::mutex> lock(log_mutex);
+	auto                        t = std::time(nullptr);
 	log.emplace_back(text, type, *std::localtime(&t));
 
 	// Write to log file
@@ -204,12 +211,13 @@ void Log::message(MessageType type, string_view text, fmt::format_args args)
 // -----------------------------------------------------------------------------
 // Returns a list of log messages of [type] that have been recorded since [time]
 // -----------------------------------------------------------------------------
-vector<Log::Message*> Log::since(time_t time, MessageType type)
+vector<Log::Message> Log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
+	std::lock_guard<std::mutex> lock(log_mutex);
+	vector<Message>             list;
 	for (auto& msg : log)
 		if (mktime(&msg.timestamp) >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -251,8 +259,9 @@ void Log::message(MessageType type, int level, string_view text)
 	if (level > log_verbosity)
 		return;
 
-	// Add log message
-	auto t = std::time(nullptr);
+	// Add log message (can be called from worker threads)
+	std::lock_guard<std::mutex> lock(log_mutex);
+	auto                        t = std::time(nullptr);
 	log.emplace_back(text, type, *std::localtime(&t));
 
 	// Write to log file
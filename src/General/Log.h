@@ -29,7 +29,7 @@ struct Message
 	string formattedMessageLine() const;
 };
 
-const vector<Message>& history();
+vector<Message>        history(size_t start = 0);
 int                    verbosity();
 void                   setVerbosity(int verbosity);
 void                   init();
@@ -37,7 +37,7 @@ void                   message(MessageType type, int level, string_view text);
 void                   message(MessageType type, string_view text);
 void                   message(MessageType type, int level, string_view text, fmt::format_args args);
 void                   message(MessageType type, string_view text, fmt::format_args args);
-vector<Message*>       since(time_t time, MessageType type = MessageType::Any);
+vector<Message>        since(time_t time, MessageType type = MessageType::Any);
 
 
 // Message shortcuts by type
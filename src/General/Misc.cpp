@@ -130,6 +130,9 @@ bool Misc::loadImageFromEntry(SImage* image, ArchiveEntry* entry, int index)
 		return image->loadJaguarTexture(entry->rawData(), entry->size(), dimensions.x, dimensions.y);
 	}
 
+	// Image formats only read the entry data, so don't copy it if it's mapped
+	MemChunk::ReadOnlyScope read_only;
+
 	// Firstly try SIFormat system
 	if (image->open(entry->data(), index, format_hint))
 		return true;
@@ -36,6 +36,7 @@
 #include "Archive/ArchiveManager.h"
 #include "General/Console/Console.h"
 #include "Graphics/CTexture/CTexture.h"
+#include "Graphics/CTexture/TextureCache.h"
 #include "Graphics/CTexture/TextureXList.h"
 #include "Utility/StringUtils.h"
 
@@ -246,6 +247,9 @@ void ResourceManager::addArchive(Archive* archive)
 	for (auto& entry : entries)
 		addEntry(entry);
 
+	// Patches in the archive may override ones used by cached textures
+	TextureCache::resourcesChanged();
+
 	// Update entries from the archive when changed (added/removed/modified)
 	archive->signals().entry_added.connect([this](Archive&, ArchiveEntry& e) { updateEntry(e, false, true); });
 	archive->signals().entry_removed.connect([this](Archive&, ArchiveEntry& e) { updateEntry(e, true, false); });
@@ -258,6 +262,7 @@ void ResourceManager::addArchive(Archive* archive)
 		removeEntry(entry_shared, prev_upper);
 		addEntry(entry_shared);
 
+		TextureCache::resourcesChanged();
 		signals_.resources_updated();
 	});
 
@@ -295,6 +300,9 @@ void ResourceManager::removeArchive(Archive* archive)
 	for (auto& i : textures_)
 		i.second.remove(archive);
 
+	// Remove any cached images from the archive
+	TextureCache::resourcesChanged(archive);
+
 	// Announce resource update
 	signals_.resources_updated();
 }
@@ -747,6 +755,14 @@ void ResourceManager::updateEntry(ArchiveEntry& entry, bool remove, bool add)
 	if (add)
 		addEntry(sptr);
 
+	// Update cached texture images. A modified entry only affects textures
+	// using it, unless it's a texture definition list (which can change the
+	// patches any other texture resolves to)
+	TextureCache::entryModified(entry);
+	auto type_id = entry.type()->id();
+	if (!(remove && add) || type_id == "texturex" || type_id == "zdtextures" || type_id == "pnames")
+		TextureCache::resourcesChanged();
+
 	signals_.resources_updated();
 }
 
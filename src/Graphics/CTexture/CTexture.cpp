@@ -34,14 +34,26 @@
 #include "CTexture.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
-#include "General/Misc.h"
 #include "General/ResourceManager.h"
+#include "Graphics/Palette/Palette.h"
 #include "Graphics/SImage/SImage.h"
+#include "TextureCache.h"
 #include "TextureXList.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr int MAX_PATCH_TEXTURE_DEPTH = 16;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // CTPatch Class Functions
@@ -806,9 +818,102 @@ bool CTexture::convertRegular()
 
 // -----------------------------------------------------------------------------
 // Generates a SImage representation of this texture, using patches from
-// [parent] primarily, and the palette [pal]
+// [parent] primarily, and the palette [pal].
+// The generated image is cached (see TextureCache), so this only rebuilds the
+// texture from its patches if its definition or patches have changed
 // -----------------------------------------------------------------------------
 bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_rgba)
+{
+	// Check for cached image
+	auto key    = imageCacheKey(parent, pal, force_rgba);
+	bool result = false;
+	if (TextureCache::getTexture(key, image, result))
+	{
+		if (result)
+			updateDefinedSize(image);
+
+		return result;
+	}
+
+	// Not cached, generate it
+	auto load_patch = [this, parent, pal](unsigned index, SImage& patch_image) {
+		// Regular textures can only use patches
+		if (!extended_)
+			return TextureCache::loadPatch(patch_image, patches_[index]->patchEntry(parent));
+
+		return loadPatchImage(index, patch_image, parent, pal);
+	};
+	TextureCache::beginTexture();
+	result = generateImage(image, pal, force_rgba, load_patch);
+	TextureCache::endTexture(key, image, result);
+
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a copy of everything needed to generate the image for this texture
+// (as in toImage), which can then be generated without accessing any
+// resources or archives (eg. on another thread) via ImageSource::toImage
+// -----------------------------------------------------------------------------
+unique_ptr<CTexture::ImageSource> CTexture::imageSource(Archive* parent, Palette* pal, bool force_rgba)
+{
+	auto source     = std::make_unique<ImageSource>();
+	source->palette = std::make_shared<Palette>();
+	if (pal)
+		source->palette->copyPalette(pal);
+	initImageSource(*source, parent, pal, force_rgba, 0);
+
+	return source;
+}
+
+// -----------------------------------------------------------------------------
+// Loads the image for the patch at [pindex] into [image].
+// Can deal with textures-as-patches
+// -----------------------------------------------------------------------------
+bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, Palette* pal)
+{
+	// Check patch index
+	if (pindex >= patches_.size())
+		return false;
+
+	// Texture-as-patch
+	if (auto tex = patchTexture(pindex, parent))
+		return tex->toImage(image, parent, pal);
+
+	// Patch entry
+	return TextureCache::loadPatch(image, patchImageEntry(pindex, parent));
+}
+
+// -----------------------------------------------------------------------------
+// Returns a key identifying the image generated by toImage with the given
+// parameters, which changes whenever the texture definition does
+// -----------------------------------------------------------------------------
+string CTexture::imageCacheKey(Archive* parent, Palette* pal, bool force_rgba)
+{
+	auto key = fmt::format(
+		"{}:{}:{:08x}:{}\n",
+		(void*)parent,
+		(void*)in_list_,
+		TextureCache::paletteHash(pal),
+		force_rgba ? 1 : 0);
+
+	// Extended textures have a full text definition
+	if (extended_)
+		return key + asText();
+
+	// Otherwise just the size and patches matter
+	key += fmt::format("{} {} {}\n", name_, size_.x, size_.y);
+	for (auto& patch : patches_)
+		key += fmt::format("{} {} {}\n", patch->name(), patch->xOffset(), patch->yOffset());
+
+	return key;
+}
+
+// -----------------------------------------------------------------------------
+// Builds the image for this texture from its patches (see toImage), with
+// each patch image loaded by [load_patch]
+// -----------------------------------------------------------------------------
+bool CTexture::generateImage(SImage& image, Palette* pal, bool force_rgba, const PatchLoader& load_patch)
 {
 	// Init image
 	image.clear();
@@ -820,7 +925,7 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 	dp.src_alpha = false;
 	if (defined_)
 	{
-		if (!loadPatchImage(0, p_img, parent, pal))
+		if (!load_patch(0, p_img))
 			return false;
 		size_.x = p_img.width();
 		size_.y = p_img.height();
@@ -839,7 +944,7 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 			auto patch = dynamic_cast<CTPatchEx*>(patches_[a].get());
 
 			// Load patch entry
-			if (!loadPatchImage(a, p_img, parent, pal))
+			if (!load_patch(a, p_img))
 				continue;
 
 			// Handle offsets
@@ -912,10 +1017,10 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 		// Normal texture
 
 		// Add each patch to image
-		for (auto& patch : patches_)
+		for (unsigned a = 0; a < patches_.size(); a++)
 		{
-			if (Misc::loadImageFromEntry(&p_img, patch->patchEntry(parent)))
-				image.drawImage(p_img, patch->xOffset(), patch->yOffset(), dp, pal, pal);
+			if (load_patch(a, p_img))
+				image.drawImage(p_img, patches_[a]->xOffset(), patches_[a]->yOffset(), dp, pal, pal);
 		}
 	}
 
@@ -923,60 +1028,152 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 }
 
 // -----------------------------------------------------------------------------
-// Loads the image for the patch at [pindex] into [image].
-// Can deal with textures-as-patches
+// Sets the size and scale of a 'defined' texture from its generated [image]
+// (for when the image was cached and generateImage wasn't called)
 // -----------------------------------------------------------------------------
-bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, Palette* pal)
+void CTexture::updateDefinedSize(const SImage& image)
 {
-	// Check patch index
-	if (pindex >= patches_.size())
-		return false;
+	if (!defined_)
+		return;
 
+	size_.x  = image.width();
+	size_.y  = image.height();
+	scale_.x = (double)size_.x / (double)def_size_.x;
+	scale_.y = (double)size_.y / (double)def_size_.y;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the texture to use for the patch at [pindex] if it is a
+// texture-as-patch, or nullptr if it's a regular patch
+// -----------------------------------------------------------------------------
+CTexture* CTexture::patchTexture(unsigned pindex, Archive* parent) const
+{
 	auto patch = patches_[pindex].get();
 
-	// If the texture is extended, search for textures-as-patches first
+	// Only extended textures can use textures as patches
 	// (as long as the patch name is different from this texture's name)
-	if (extended_ && !(StrUtil::equalCI(patch->name(), name_)))
+	if (!extended_ || StrUtil::equalCI(patch->name(), name_))
+		return nullptr;
+
+	// Search the texture list we're in first
+	if (in_list_)
 	{
-		// Search the texture list we're in first
-		if (in_list_)
+		for (unsigned a = 0; a < in_list_->size(); a++)
 		{
-			for (unsigned a = 0; a < in_list_->size(); a++)
-			{
-				auto tex = in_list_->texture(a);
+			auto tex = in_list_->texture(a);
 
-				// Don't look past this texture in the list
-				if (tex->name() == name_)
-					break;
+			// Don't look past this texture in the list
+			if (tex->name() == name_)
+				break;
 
-				// Check for name match
-				if (StrUtil::equalCI(tex->name(), patch->name()))
-				{
-					// Load texture to image
-					return tex->toImage(image, parent, pal);
-				}
-			}
+			// Check for name match
+			if (StrUtil::equalCI(tex->name(), patch->name()))
+				return tex;
 		}
-
-		// Otherwise, try the resource manager
-		// TODO: Something has to be ignored here. The entire archive or just the current list?
-		auto tex = App::resources().getTexture(patch->name(), parent);
-		if (tex)
-			return tex->toImage(image, parent, pal);
 	}
 
+	// Otherwise, try the resource manager
+	// TODO: Something has to be ignored here. The entire archive or just the current list?
+	return App::resources().getTexture(patch->name(), parent);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry to load the image for the patch at [pindex] from
+// -----------------------------------------------------------------------------
+ArchiveEntry* CTexture::patchImageEntry(unsigned pindex, Archive* parent) const
+{
+	auto patch = patches_[pindex].get();
+
 	// Get patch entry
 	auto entry = patch->patchEntry(parent);
 
-	// Load entry to image if valid
-	if (entry)
-		return Misc::loadImageFromEntry(&image, entry);
-
 	// Maybe it's a texture?
-	entry = App::resources().getTextureEntry(patch->name(), "", parent);
+	if (!entry)
+		entry = App::resources().getTextureEntry(patch->name(), "", parent);
 
-	if (entry)
-		return Misc::loadImageFromEntry(&image, entry);
+	return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Fills in [source] for generating this texture's image (see imageSource).
+// [depth] is the number of textures-as-patches deep we are, to avoid infinite
+// recursion if textures use each other as patches
+// -----------------------------------------------------------------------------
+void CTexture::initImageSource(ImageSource& source, Archive* parent, Palette* pal, bool force_rgba, int depth)
+{
+	source.texture = std::make_unique<CTexture>();
+	source.texture->copyTexture(*this);
+	source.cache_key  = imageCacheKey(parent, pal, force_rgba);
+	source.force_rgba = force_rgba;
+
+	source.patches.resize(patches_.size());
+	for (unsigned a = 0; a < patches_.size(); a++)
+	{
+		auto& patch = source.patches[a];
+
+		// Texture-as-patch
+		if (depth < MAX_PATCH_TEXTURE_DEPTH)
+		{
+			if (auto tex = patchTexture(a, parent))
+			{
+				patch.texture          = std::make_unique<ImageSource>();
+				patch.texture->palette = source.palette;
+				tex->initImageSource(*patch.texture, parent, pal, false, depth + 1);
+				continue;
+			}
+		}
+
+		// Copy patch entry
+		patch.entry = extended_ ? patchImageEntry(a, parent) : patches_[a]->patchEntry(parent);
+		if (patch.entry)
+		{
+			patch.entry_ptr = patch.entry->getShared();
+			patch.data      = std::make_unique<ArchiveEntry>(*patch.entry);
+		}
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// CTexture::ImageSource Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Generates the texture image into [image], as CTexture::toImage would.
+// Only uses the copied texture and patches, so is safe to call from any
+// thread
+// -----------------------------------------------------------------------------
+bool CTexture::ImageSource::toImage(SImage& image)
+{
+	// Check for cached image
+	bool result = false;
+	if (TextureCache::getTexture(cache_key, image, result))
+	{
+		if (result)
+			texture->updateDefinedSize(image);
+
+		return result;
+	}
+
+	// Not cached, generate it
+	auto load_patch = [this](unsigned index, SImage& patch_image) {
+		if (index >= patches.size())
+			return false;
+
+		auto& patch = patches[index];
+		if (patch.texture)
+			return patch.texture->toImage(patch_image);
+		if (patch.data)
+			return TextureCache::loadPatch(patch_image, patch.entry, patch.entry_ptr, *patch.data);
+
+		return false;
+	};
+	TextureCache::beginTexture();
+	result = texture->generateImage(image, palette.get(), force_rgba, load_patch);
+	TextureCache::endTexture(cache_key, image, result);
 
-	return false;
+	return result;
 }
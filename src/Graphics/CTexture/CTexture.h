@@ -2,6 +2,7 @@
 
 #include "Archive/ArchiveEntry.h"
 #include "Graphics/Translation.h"
+#include <functional>
 
 class SImage;
 class Tokenizer;
@@ -176,6 +177,28 @@ public:
 	bool loadPatchImage(unsigned pindex, SImage& image, Archive* parent = nullptr, Palette* pal = nullptr);
 	bool toImage(SImage& image, Archive* parent = nullptr, Palette* pal = nullptr, bool force_rgba = false);
 
+	// Everything needed to generate a texture's image without accessing
+	// resources or archives (eg. to generate it on another thread)
+	struct ImageSource
+	{
+		struct Patch
+		{
+			ArchiveEntry*            entry = nullptr; // Original patch entry
+			weak_ptr<ArchiveEntry>   entry_ptr;
+			unique_ptr<ArchiveEntry> data;    // Copy of the patch entry
+			unique_ptr<ImageSource>  texture; // Texture-as-patch
+		};
+
+		unique_ptr<CTexture> texture;
+		string               cache_key;
+		shared_ptr<Palette>  palette;
+		bool                 force_rgba = false;
+		vector<Patch>        patches;
+
+		bool toImage(SImage& image);
+	};
+	unique_ptr<ImageSource> imageSource(Archive* parent = nullptr, Palette* pal = nullptr, bool force_rgba = false);
+
 	// Signals
 	struct Signals
 	{
@@ -208,4 +231,13 @@ private:
 
 	// Signals
 	Signals signals_;
+
+	typedef std::function<bool(unsigned index, SImage& image)> PatchLoader;
+
+	string        imageCacheKey(Archive* parent, Palette* pal, bool force_rgba);
+	bool          generateImage(SImage& image, Palette* pal, bool force_rgba, const PatchLoader& load_patch);
+	void          updateDefinedSize(const SImage& image);
+	CTexture*     patchTexture(unsigned pindex, Archive* parent) const;
+	ArchiveEntry* patchImageEntry(unsigned pindex, Archive* parent) const;
+	void          initImageSource(ImageSource& source, Archive* parent, Palette* pal, bool force_rgba, int depth);
 };
@@ -0,0 +1,466 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureCache.cpp
+// Description: A cache of loaded patch images and generated composite texture
+//              images, so textures aren't rebuilt from their patches every
+//              time they are needed (eg. when switching maps or refreshing
+//              resources).
+//              Patches are cached by entry, and composite textures by a key
+//              generated from their definition (see CTexture::toImage). Each
+//              composite records the patch entries it was built from, so
+//              modifying an entry only invalidates the textures that use it.
+//              The cache is limited in size by the texture_cache_size cvar,
+//              with the least recently used images removed first
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureCache.h"
+#include "Archive/Archive.h"
+#include "General/Console/Console.h"
+#include "General/Misc.h"
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/SImage/SImage.h"
+#include <mutex>
+#include <unordered_map>
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, texture_cache_size, 128, CVar::Flag::Save)
+
+namespace
+{
+struct CachedImage
+{
+	unique_ptr<SImage> image; // Null if loading failed
+	bool               result    = false;
+	size_t             size      = 0;
+	unsigned           last_used = 0;
+};
+
+struct CachedPatch : CachedImage
+{
+	weak_ptr<ArchiveEntry> entry;
+	unsigned               entry_size = 0;
+};
+
+struct CachedTexture : CachedImage
+{
+	vector<ArchiveEntry*> deps;
+};
+
+std::mutex                                     cache_mutex;
+std::unordered_map<ArchiveEntry*, CachedPatch> cached_patches;
+std::unordered_map<string, CachedTexture>      cached_textures;
+size_t                                         cache_size  = 0;
+unsigned                                       use_counter = 0;
+
+// Incremented whenever cached images are invalidated, so that images which
+// started loading before then (eg. on a background thread) aren't added to the
+// cache once they finish
+unsigned cache_generation = 0;
+
+// Patch entries used by each texture currently being built on this thread
+// (nested when a texture uses another texture as a patch), and the cache
+// generation when each was begun
+thread_local vector<vector<ArchiveEntry*>> dep_collectors;
+thread_local vector<unsigned>              dep_generations;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the (approximate) memory used by [image]
+// -----------------------------------------------------------------------------
+size_t imageMemSize(const SImage& image)
+{
+	// Image data + mask
+	return (size_t)image.width() * image.height() * (image.bpp() + 1);
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entry] as a dependency of any textures currently being built
+// -----------------------------------------------------------------------------
+void addDependency(ArchiveEntry* entry)
+{
+	for (auto& deps : dep_collectors)
+		deps.push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the image in [cached] to a copy of [image] (if [result] is true)
+// -----------------------------------------------------------------------------
+void setCachedImage(CachedImage& cached, const SImage& image, bool result)
+{
+	cache_size -= cached.size;
+
+	cached.result    = result;
+	cached.image     = result ? std::make_unique<SImage>(image) : nullptr;
+	cached.size      = result ? imageMemSize(image) : 0;
+	cached.last_used = ++use_counter;
+
+	cache_size += cached.size;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the least recently used images until the cache is under 3/4 of its
+// size limit, if it is currently over the limit.
+// The cache mutex must be locked when calling this
+// -----------------------------------------------------------------------------
+void limitCacheSize()
+{
+	auto limit = (size_t)std::max(0, (int)texture_cache_size) * 1024 * 1024;
+	if (cache_size <= limit)
+		return;
+
+	// Get all cached images ordered by last use
+	struct LRUItem
+	{
+		unsigned      last_used;
+		ArchiveEntry* patch;
+		const string* texture;
+	};
+	vector<LRUItem> items;
+	items.reserve(cached_patches.size() + cached_textures.size());
+	for (auto& i : cached_patches)
+		items.push_back({ i.second.last_used, i.first, nullptr });
+	for (auto& i : cached_textures)
+		items.push_back({ i.second.last_used, nullptr, &i.first });
+	std::sort(
+		items.begin(), items.end(), [](const LRUItem& l, const LRUItem& r) { return l.last_used < r.last_used; });
+
+	// Remove oldest first
+	auto target = limit / 4 * 3;
+	for (auto& item : items)
+	{
+		if (cache_size <= target)
+			break;
+
+		if (item.patch)
+		{
+			auto i = cached_patches.find(item.patch);
+			cache_size -= i->second.size;
+			cached_patches.erase(i);
+		}
+		else
+		{
+			auto i = cached_textures.find(*item.texture);
+			cache_size -= i->second.size;
+			cached_textures.erase(i);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes all cached composite textures.
+// The cache mutex must be locked when calling this
+// -----------------------------------------------------------------------------
+void clearTextures()
+{
+	for (auto& i : cached_textures)
+		cache_size -= i.second.size;
+	cached_textures.clear();
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+// Loads the patch image from [entry] into [image], from the cache if it has
+// already been loaded. Returns false if the entry isn't a valid image
+// -----------------------------------------------------------------------------
+bool TextureCache::loadPatch(SImage& image, ArchiveEntry* entry)
+{
+	if (!entry)
+		return false;
+
+	return loadPatch(image, entry, entry->getShared(), *entry);
+}
+
+// -----------------------------------------------------------------------------
+// Loads the patch image for [entry] into [image], from the cache if it has
+// already been loaded, otherwise from [data]. [entry_ptr] must point to
+// [entry] (or be empty if it isn't in an archive).
+// [data] can be a copy of [entry], so that this can be used without accessing
+// the original entry at all (eg. from another thread)
+// -----------------------------------------------------------------------------
+bool TextureCache::loadPatch(
+	SImage&                       image,
+	ArchiveEntry*                 entry,
+	const weak_ptr<ArchiveEntry>& entry_ptr,
+	ArchiveEntry&                 data)
+{
+	addDependency(entry);
+
+	// Don't cache entries that aren't in an archive
+	if (texture_cache_size <= 0 || entry_ptr.expired())
+		return Misc::loadImageFromEntry(&image, &data);
+
+	// Check for cached patch
+	unsigned generation;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		generation = cache_generation;
+
+		auto i = cached_patches.find(entry);
+		if (i != cached_patches.end())
+		{
+			auto& patch = i->second;
+
+			// Check it's actually the same entry (the cached one may have been
+			// deleted and a new one created at the same address)
+			bool same_entry = !patch.entry.owner_before(entry_ptr) && !entry_ptr.owner_before(patch.entry);
+			if (same_entry && patch.entry_size == data.size())
+			{
+				patch.last_used = ++use_counter;
+				if (patch.result)
+					image.copyImage(patch.image.get());
+				return patch.result;
+			}
+
+			cache_size -= patch.size;
+			cached_patches.erase(i);
+		}
+	}
+
+	// Not cached, load it
+	bool result = Misc::loadImageFromEntry(&image, &data);
+
+	// Add to cache (unless the cache was invalidated while loading, in which
+	// case the image may be out of date)
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (generation != cache_generation)
+		return result;
+	auto& patch = cached_patches[entry];
+	setCachedImage(patch, image, result);
+	patch.entry      = entry_ptr;
+	patch.entry_size = data.size();
+	limitCacheSize();
+
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Gets the cached composite texture image for [key] into [image], with the
+// result of generating it in [result]. Returns false if the texture isn't
+// cached
+// -----------------------------------------------------------------------------
+bool TextureCache::getTexture(const string& key, SImage& image, bool& result)
+{
+	if (texture_cache_size <= 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+
+	auto i = cached_textures.find(key);
+	if (i == cached_textures.end())
+		return false;
+
+	auto& texture     = i->second;
+	texture.last_used = ++use_counter;
+	result            = texture.result;
+	if (result)
+		image.copyImage(texture.image.get());
+
+	// Pass the texture's dependencies on to any textures using it as a patch
+	for (auto& deps : dep_collectors)
+		deps.insert(deps.end(), texture.deps.begin(), texture.deps.end());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Begins generating a composite texture image. All patches loaded via
+// loadPatch until the matching endTexture call are recorded as dependencies of
+// the texture
+// -----------------------------------------------------------------------------
+void TextureCache::beginTexture()
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	dep_collectors.emplace_back();
+	dep_generations.push_back(cache_generation);
+}
+
+// -----------------------------------------------------------------------------
+// Finishes generating a composite texture image (see beginTexture), adding
+// [image] to the cache with [key]
+// -----------------------------------------------------------------------------
+void TextureCache::endTexture(const string& key, const SImage& image, bool result)
+{
+	if (dep_collectors.empty())
+		return;
+
+	auto deps       = std::move(dep_collectors.back());
+	auto generation = dep_generations.back();
+	dep_collectors.pop_back();
+	dep_generations.pop_back();
+	std::sort(deps.begin(), deps.end());
+	deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+	// Pass dependencies on to any textures using this one as a patch
+	for (auto& outer : dep_collectors)
+		outer.insert(outer.end(), deps.begin(), deps.end());
+
+	if (texture_cache_size <= 0)
+		return;
+
+	// Add to cache (unless the cache was invalidated while generating it)
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (generation != cache_generation)
+		return;
+	auto& texture = cached_textures[key];
+	setCachedImage(texture, image, result);
+	texture.deps = std::move(deps);
+	limitCacheSize();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a hash of the colours in [pal], for use in composite texture keys
+// -----------------------------------------------------------------------------
+uint32_t TextureCache::paletteHash(const Palette* pal)
+{
+	if (!pal)
+		return 0;
+
+	// 32-bit FNV-1a
+	uint32_t hash = 2166136261u;
+	for (auto& colour : pal->colours())
+	{
+		for (auto c : { colour.r, colour.g, colour.b, colour.a })
+			hash = (hash ^ c) * 16777619u;
+	}
+
+	return hash;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the cached image for [entry] and any composite textures using it
+// -----------------------------------------------------------------------------
+void TextureCache::entryModified(ArchiveEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	++cache_generation;
+
+	auto patch = cached_patches.find(&entry);
+	if (patch != cached_patches.end())
+	{
+		cache_size -= patch->second.size;
+		cached_patches.erase(patch);
+	}
+
+	for (auto i = cached_textures.begin(); i != cached_textures.end();)
+	{
+		if (std::binary_search(i->second.deps.begin(), i->second.deps.end(), &entry))
+		{
+			cache_size -= i->second.size;
+			i = cached_textures.erase(i);
+		}
+		else
+			++i;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Called when the set of available resources has changed (which can change
+// the patches used by any composite texture), removes all cached composite
+// textures. If [removed] is given, cached patches from that archive are also
+// removed
+// -----------------------------------------------------------------------------
+void TextureCache::resourcesChanged(Archive* removed)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	++cache_generation;
+
+	clearTextures();
+
+	if (!removed)
+		return;
+
+	for (auto i = cached_patches.begin(); i != cached_patches.end();)
+	{
+		auto entry = i->second.entry.lock();
+		if (!entry || entry->parent() == removed)
+		{
+			cache_size -= i->second.size;
+			i = cached_patches.erase(i);
+		}
+		else
+			++i;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes everything from the cache
+// -----------------------------------------------------------------------------
+void TextureCache::clear()
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	++cache_generation;
+
+	cached_patches.clear();
+	cached_textures.clear();
+	cache_size = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Shows the number of cached patch and texture images and their total size
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(texture_cache_info, 0, false)
+{
+	std::lock_guard<std::mutex> lock(cache_mutex);
+
+	Log::info(
+		"Texture cache: {} patches, {} textures, {:1.2f}MB",
+		cached_patches.size(),
+		cached_textures.size(),
+		(double)cache_size / (1024 * 1024));
+}
+
+// -----------------------------------------------------------------------------
+// Clears the texture cache
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(texture_cache_clear, 0, false)
+{
+	TextureCache::clear();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+class Archive;
+class ArchiveEntry;
+class SImage;
+class Palette;
+
+namespace TextureCache
+{
+bool loadPatch(SImage& image, ArchiveEntry* entry);
+bool loadPatch(SImage& image, ArchiveEntry* entry, const weak_ptr<ArchiveEntry>& entry_ptr, ArchiveEntry& data);
+
+bool getTexture(const string& key, SImage& image, bool& result);
+void beginTexture();
+void endTexture(const string& key, const SImage& image, bool result);
+
+uint32_t paletteHash(const Palette* pal);
+
+void entryModified(ArchiveEntry& entry);
+void resourcesChanged(Archive* removed = nullptr);
+void clear();
+} // namespace TextureCache
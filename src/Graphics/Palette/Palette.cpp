@@ -32,11 +32,16 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Palette.h"
+#include "App.h"
+#include "General/Console/Console.h"
+#include "Graphics/Palette/PaletteManager.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/Translation.h"
 #include "Utility/CIEDeltaEquations.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
+#include <atomic>
+#include <random>
 
 
 // -----------------------------------------------------------------------------
@@ -54,6 +59,65 @@ CVAR(Float, col_match_l, 1.0, CVar::Flag::Save)
 EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
+namespace
+{
+bool use_match_cache = true; // Disabled to benchmark against a full search every time
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Palette::MatchCache Struct
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Cached nearest colour lookups for a single colour matching method.
+// Results are memoised per RGB value in lazily allocated pages of 4096 colours.
+// For matching methods that are a sum of squared per-axis differences, the
+// palette indices are also sorted along one axis so that searching for a colour
+// that isn't memoised yet can stop early (see Palette::searchNearestColour).
+// Pages are allocated and filled in using atomics, so the same palette can be
+// used for lookups from multiple threads at once (eg. when converting images
+// in parallel). The search axis is only written when the cache is built
+// -----------------------------------------------------------------------------
+struct Palette::MatchCache
+{
+	struct Page
+	{
+		std::atomic<uint8_t>  index[4096];
+		std::atomic<uint64_t> known[64] = {};
+	};
+
+	double               weights[3] = { 0., 0., 0. }; // col_match_* weights the cache was built with
+	vector<uint8_t>      axis_order;                   // Palette indices sorted along the search axis
+	vector<double>       axis_keys;                    // Search axis values, in axis_order
+	std::atomic<Page*>   pages[4096] = {};
+
+	~MatchCache()
+	{
+		for (auto& page : pages)
+			delete page.load();
+	}
+
+	// Returns the page for [rgb], allocating it if needed
+	Page& page(unsigned rgb)
+	{
+		auto& slot = pages[rgb >> 12];
+		auto  page = slot.load(std::memory_order_acquire);
+		if (page)
+			return *page;
+
+		// Allocate a new page, unless another thread got there first
+		auto new_page = new Page;
+		if (slot.compare_exchange_strong(page, new_page, std::memory_order_acq_rel))
+			return *new_page;
+
+		delete new_page;
+		return *page;
+	}
+};
 
 
 // -----------------------------------------------------------------------------
@@ -108,6 +172,7 @@ bool Palette::loadMem(MemChunk& mc)
 			break;
 	}
 	mc.seek(0, SEEK_SET);
+	clearMatchCache();
 
 	return true;
 }
@@ -134,6 +199,7 @@ bool Palette::loadMem(const uint8_t* data, uint32_t size)
 		if (++c == 256)
 			break;
 	}
+	clearMatchCache();
 
 	return true;
 }
@@ -428,6 +494,7 @@ void Palette::setColour(uint8_t index, const ColRGBA& col)
 	colours_[index].index = index;
 	colours_lab_[index]   = colours_[index].asLAB();
 	colours_hsl_[index]   = colours_[index].asHSL();
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -438,6 +505,7 @@ void Palette::setColourR(uint8_t index, uint8_t val)
 	colours_[index].r   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -448,6 +516,7 @@ void Palette::setColourG(uint8_t index, uint8_t val)
 	colours_[index].g   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -458,6 +527,7 @@ void Palette::setColourB(uint8_t index, uint8_t val)
 	colours_[index].b   = val;
 	colours_lab_[index] = colours_[index].asLAB();
 	colours_hsl_[index] = colours_[index].asHSL();
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -493,6 +563,8 @@ void Palette::setGradient(uint8_t startIndex, uint8_t endIndex, const ColRGBA& s
 			a + startIndex);
 		colours_[a + startIndex].set(gradCol);
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -570,15 +642,172 @@ double Palette::colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB&
 }
 
 // -----------------------------------------------------------------------------
-// Returns the index of the closest colour in the palette to [colour]
+// Returns the difference between the given colour [rgb]/[lab] and the palette
+// colour at [index] along the search axis only, for colour matching methods
+// that can be searched along a sorted axis (Old, RGB and C76).
+// This is never greater than the colourDiff for the same colours
 // -----------------------------------------------------------------------------
-short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
+double Palette::axisDiff(const ColRGBA& rgb, const ColLAB& lab, int index, ColourMatch match)
+{
+	double d;
+	switch (match)
+	{
+	default:
+	case ColourMatch::Old: d = rgb.r - colours_[index].r; break;
+	case ColourMatch::RGB:
+		d = rgb.dr() - colours_[index].dr();
+		d *= col_match_r;
+		break;
+	case ColourMatch::C76: d = lab.l - colours_lab_[index].l; break;
+	}
+	return d * d;
+}
+
+// -----------------------------------------------------------------------------
+// Searches the palette for the closest colour to [colour] using the colour
+// matching method [match]. If [cache] is given and has a sorted search axis,
+// only the palette colours near [colour] along that axis are checked.
+// Either way the result is the same as checking every colour: the lowest index
+// of the closest colour(s)
+// -----------------------------------------------------------------------------
+short Palette::searchNearestColour(const ColRGBA& colour, ColourMatch match, const MatchCache* cache)
 {
 	double min_d = 999999;
 	short  index = 0;
 	ColHSL chsl  = colour.asHSL();
 	ColLAB clab  = colour.asLAB();
 
+	// Check every colour
+	if (!cache || cache->axis_order.empty())
+	{
+		double delta;
+		for (short a = 0; a < 256; a++)
+		{
+			delta = colourDiff(colour, chsl, clab, a, match);
+
+			// Exact match?
+			if (delta == 0.0)
+				return a;
+			else if (delta < min_d)
+			{
+				min_d = delta;
+				index = a;
+			}
+		}
+
+		return index;
+	}
+
+	// Search outwards in both directions from the colour's position along the
+	// sorted axis, until the difference along the axis alone is greater than
+	// the closest match found so far
+	const auto& order = cache->axis_order;
+	const auto& keys  = cache->axis_keys;
+	double      key   = match == ColourMatch::C76 ? clab.l : (double)colour.r;
+	int         up    = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+	int         down  = up - 1;
+	auto        check = [&](short a) {
+		auto delta = colourDiff(colour, chsl, clab, a, match);
+		if (delta < min_d || (delta == min_d && a < index))
+		{
+			min_d = delta;
+			index = a;
+		}
+	};
+	while (up < 256 || down >= 0)
+	{
+		if (up < 256)
+		{
+			if (axisDiff(colour, clab, order[up], match) > min_d)
+				up = 256;
+			else
+				check(order[up++]);
+		}
+
+		if (down >= 0)
+		{
+			if (axisDiff(colour, clab, order[down], match) > min_d)
+				down = -1;
+			else
+				check(order[down--]);
+		}
+	}
+
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the nearest colour lookup cache for [match], (re)building it if it
+// doesn't exist or the colour matching weights have changed.
+// The cache pointers are only accessed atomically, so if multiple threads
+// rebuild the cache at once each just uses its own, and a cache stays valid
+// for anything still using it after being cleared
+// -----------------------------------------------------------------------------
+shared_ptr<Palette::MatchCache> Palette::matchCache(ColourMatch match)
+{
+	double weights[3] = { 0., 0., 0. };
+	if (match == ColourMatch::RGB)
+	{
+		weights[0] = col_match_r;
+		weights[1] = col_match_g;
+		weights[2] = col_match_b;
+	}
+	else if (match == ColourMatch::HSL)
+	{
+		weights[0] = col_match_h;
+		weights[1] = col_match_s;
+		weights[2] = col_match_l;
+	}
+
+	auto cache = std::atomic_load(&match_cache_[(int)match]);
+	if (cache && cache->weights[0] == weights[0] && cache->weights[1] == weights[1]
+		&& cache->weights[2] == weights[2])
+		return cache;
+
+	cache = std::make_shared<MatchCache>();
+	std::copy(weights, weights + 3, cache->weights);
+
+	// Sort palette indices along the search axis (red or lightness), for
+	// matching methods where the difference along one axis is a lower bound
+	if (match == ColourMatch::Old || match == ColourMatch::RGB || match == ColourMatch::C76)
+	{
+		auto axis_key = [&](int index) {
+			return match == ColourMatch::C76 ? colours_lab_[index].l : (double)colours_[index].r;
+		};
+
+		cache->axis_order.resize(256);
+		for (unsigned a = 0; a < 256; a++)
+			cache->axis_order[a] = a;
+		std::stable_sort(cache->axis_order.begin(), cache->axis_order.end(), [&](uint8_t left, uint8_t right) {
+			return axis_key(left) < axis_key(right);
+		});
+
+		for (auto index : cache->axis_order)
+			cache->axis_keys.push_back(axis_key(index));
+	}
+
+	std::atomic_store(&match_cache_[(int)match], cache);
+
+	return cache;
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached nearest colour lookups, needs to be called whenever any
+// palette colours change
+// -----------------------------------------------------------------------------
+void Palette::clearMatchCache()
+{
+	for (auto& cache : match_cache_)
+		std::atomic_store(&cache, shared_ptr<MatchCache>());
+}
+
+// -----------------------------------------------------------------------------
+// Returns the index of the closest colour in the palette to [colour].
+// Results are cached per colour matching method, so repeated lookups of the
+// same colour (eg. when converting an image) don't need to search again
+// -----------------------------------------------------------------------------
+short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
+{
 	// Be nice if there was an easier way to convert from int -> enum class,
 	// but then that's kind of the point of them I guess
 	static vector<ColourMatch> cm_convert = {
@@ -588,20 +817,27 @@ short Palette::nearestColour(const ColRGBA& colour, ColourMatch match)
 	if (match == ColourMatch::Default)
 		match = cm_convert[col_match];
 
-	double delta;
-	for (short a = 0; a < 256; a++)
-	{
-		delta = colourDiff(colour, chsl, clab, a, match);
+	// Anything else is matched the same as 'Old' by colourDiff
+	if (match == ColourMatch::Default || match == ColourMatch::Stop)
+		match = ColourMatch::Old;
 
-		// Exact match?
-		if (delta == 0.0)
-			return a;
-		else if (delta < min_d)
-		{
-			min_d = delta;
-			index = a;
-		}
-	}
+	if (!use_match_cache)
+		return searchNearestColour(colour, match, nullptr);
+
+	// Check for a previous lookup of the same colour
+	auto     cache = matchCache(match);
+	unsigned rgb   = (colour.r << 16) | (colour.g << 8) | colour.b;
+	auto&    page  = cache->page(rgb);
+	unsigned slot  = rgb & 0xFFF;
+	uint64_t bit   = 1ull << (slot & 63);
+	if (page.known[slot >> 6].load(std::memory_order_acquire) & bit)
+		return page.index[slot].load(std::memory_order_relaxed);
+
+	// Search and remember the result (another thread may be doing the same
+	// search, but will get the same result)
+	auto index = searchNearestColour(colour, match, cache.get());
+	page.index[slot].store(index, std::memory_order_relaxed);
+	page.known[slot >> 6].fetch_or(bit, std::memory_order_release);
 
 	return index;
 }
@@ -774,6 +1010,8 @@ void Palette::saturate(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -802,6 +1040,8 @@ void Palette::illuminate(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -830,6 +1070,8 @@ void Palette::shift(float amount, int start, int end)
 		colours_[i]     = colours_hsl_[i].asRGB();
 		colours_lab_[i] = colours_[i].asLAB();
 	}
+
+	clearMatchCache();
 }
 
 // -----------------------------------------------------------------------------
@@ -852,3 +1094,85 @@ void Palette::invert(int start, int end)
 		setColour(i, colours_[i]); // Just to update the HSL values
 	}
 }
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Benchmarks converting an RGBA image (2048x2048 by default, or [args[0]]
+// squared) to the global palette with each colour matching method, comparing
+// a sample of the converted pixels against a full palette search
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_palette_match, 0, false)
+{
+	int size = 2048;
+	if (!args.empty())
+		size = StrUtil::asInt(args[0]);
+	if (size <= 0)
+		return;
+
+	// Build a test image with smooth gradients plus some noise
+	std::mt19937    rng(1234);
+	vector<ColRGBA> pixels(size * size);
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+			pixels[y * size + x].set(
+				x * 255 / size, y * 255 / size, ((x + y) * 127 / size + rng() % 32) & 0xFF, 255);
+
+	auto           pal           = App::paletteManager()->globalPalette();
+	int            prev_match    = col_match;
+	const char*    match_names[] = { "Old", "RGB", "HSL", "C76", "C94", "C2K" };
+	vector<short>  samples;
+	constexpr auto sample_step = 257;
+
+	for (int match = (int)Palette::ColourMatch::Old; match <= (int)Palette::ColourMatch::C2K; match++)
+	{
+		col_match = match;
+
+		SImage image;
+		image.create(size, size, SImage::Type::RGBA);
+		for (int a = 0; a < size * size; a++)
+			image.setPixel(a % size, a / size, pixels[a]);
+
+		// Convert (with lookup caching)
+		auto start = App::runTimer();
+		image.convertPaletted(pal);
+		auto time_cached = App::runTimer() - start;
+
+		// Check a sample of pixels with a full search
+		Palette temp(*pal);
+		use_match_cache = false;
+		start           = App::runTimer();
+		samples.clear();
+		for (int a = 0; a < size * size; a += sample_step)
+			samples.push_back(temp.nearestColour(pixels[a]));
+		auto time_full  = App::runTimer() - start;
+		use_match_cache = true;
+
+		int mismatches = 0;
+		for (unsigned a = 0; a < samples.size(); a++)
+		{
+			auto p = a * sample_step;
+			if (image.pixelIndexAt(p % size, p / size) != samples[a])
+				mismatches++;
+		}
+
+		Log::console(fmt::format(
+			"{}: converted {}x{} in {}ms (full search ~{}ms), {} mismatches in {} samples",
+			match_names[match - 1],
+			size,
+			size,
+			time_cached,
+			time_full * sample_step,
+			mismatches,
+			samples.size()));
+	}
+
+	col_match = prev_match;
+}
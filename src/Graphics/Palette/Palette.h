@@ -67,10 +67,22 @@ public:
 	void idtint(int r, int g, int b, int shift, int steps);
 
 private:
-	vector<ColRGBA> colours_;
-	vector<ColHSL>  colours_hsl_;
-	vector<ColLAB>  colours_lab_;
-	short           index_trans_;
+	struct MatchCache;
 
-	double colourDiff(const ColRGBA& rgb, const ColHSL& hsl, const ColLAB& lab, int index, ColourMatch match);
+	vector<ColRGBA>        colours_;
+	vector<ColHSL>         colours_hsl_;
+	vector<ColLAB>         colours_lab_;
+	short                  index_trans_;
+	shared_ptr<MatchCache> match_cache_[(int)ColourMatch::Stop];
+
+	double                 colourDiff(
+						const ColRGBA& rgb,
+						const ColHSL&  hsl,
+						const ColLAB&  lab,
+						int            index,
+						ColourMatch    match);
+	double                 axisDiff(const ColRGBA& rgb, const ColLAB& lab, int index, ColourMatch match);
+	short                  searchNearestColour(const ColRGBA& colour, ColourMatch match, const MatchCache* cache);
+	shared_ptr<MatchCache> matchCache(ColourMatch match);
+	void                   clearMatchCache();
 };
@@ -50,6 +50,76 @@ EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the alpha a source pixel with [alpha] is drawn with, according to
+// [properties] (same as in SImage::drawPixel)
+// -----------------------------------------------------------------------------
+inline uint8_t drawAlpha(uint8_t alpha, const SImage::DrawProps& properties)
+{
+	if (properties.src_alpha)
+		return alpha * properties.alpha;
+	else
+		return 255 * properties.alpha;
+}
+
+// -----------------------------------------------------------------------------
+// Blends a row of [count] source pixels on to the RGBA pixels at [dest], with
+// normal or additive blending only. [src_colour] should return the colour of
+// the source pixel at the given index in the row.
+// Gives the same results as drawing each pixel via SImage::drawPixel, without
+// the per-pixel bounds, type and blend mode checks
+// -----------------------------------------------------------------------------
+template<typename F> void blendRowRGBA(uint8_t* dest, int count, const SImage::DrawProps& properties, F src_colour)
+{
+	bool additive = properties.blend == SImage::BlendType::Add;
+
+	for (int a = 0; a < count; a++, dest += 4)
+	{
+		ColRGBA colour = src_colour(a);
+		if (colour.a == 0)
+			continue;
+
+		uint8_t d_alpha = drawAlpha(colour.a, properties);
+		if (d_alpha == 0)
+			continue;
+
+		// Opaque, just copy
+		if (d_alpha == 255 && !additive)
+		{
+			dest[0] = colour.r;
+			dest[1] = colour.g;
+			dest[2] = colour.b;
+			dest[3] = 255;
+			continue;
+		}
+
+		float alpha = (float)d_alpha / 255.0f;
+		if (additive)
+		{
+			dest[0] = std::min(dest[0] + colour.r * alpha, 255.0f);
+			dest[1] = std::min(dest[1] + colour.g * alpha, 255.0f);
+			dest[2] = std::min(dest[2] + colour.b * alpha, 255.0f);
+		}
+		else
+		{
+			float inv_alpha = 1.0f - alpha;
+			dest[0]         = dest[0] * inv_alpha + colour.r * alpha;
+			dest[1]         = dest[1] * inv_alpha + colour.g * alpha;
+			dest[2]         = dest[2] * inv_alpha + colour.b * alpha;
+		}
+		dest[3] = std::min(dest[3] + d_alpha, 255);
+	}
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // SImage Class Functions
@@ -1495,28 +1565,105 @@ bool SImage::drawImage(SImage& img, int x_pos, int y_pos, DrawProps& properties,
 	if (has_palette_ || !pal_dest)
 		pal_dest = &palette_;
 
-	// Go through pixels
+	// Clip to image bounds
+	int x_start = std::max(0, x_pos);
+	int y_start = std::max(0, y_pos);
+	int x_end   = std::min(width_, x_pos + img.width_);
+	int y_end   = std::min(height_, y_pos + img.height_);
+	if (x_start >= x_end || y_start >= y_end)
+		return true;
+
 	unsigned s_stride = img.stride();
 	uint8_t  s_bpp    = img.bpp();
-	unsigned sp       = 0;
-	for (int y = y_pos; y < y_pos + img.height_; y++) // Rows
+	unsigned d_stride = stride();
+	int      count    = x_end - x_start;
+
+	// Normal or additive blending on to RGBA, blend whole rows at once
+	if (type_ == Type::RGBA && (properties.blend == BlendType::Normal || properties.blend == BlendType::Add)
+		&& (img.type_ == Type::RGBA || img.type_ == Type::PalMask))
 	{
-		// Skip out-of-bounds rows
-		if (y < 0 || y >= height_)
+		auto& s_colours = pal_src->colours();
+		for (int y = y_start; y < y_end; y++)
 		{
-			sp += s_stride;
-			continue;
+			auto dest = data_.data() + y * d_stride + x_start * 4;
+			auto sp   = (y - y_pos) * s_stride + (x_start - x_pos) * s_bpp;
+
+			if (img.type_ == Type::RGBA)
+			{
+				auto src = img.data_.data() + sp;
+				blendRowRGBA(dest, count, properties, [src](int a) {
+					return ColRGBA(src[a * 4], src[a * 4 + 1], src[a * 4 + 2], src[a * 4 + 3]);
+				});
+			}
+			else
+			{
+				auto src  = img.data_.data() + sp;
+				auto mask = img.mask_.data() + sp;
+				blendRowRGBA(dest, count, properties, [src, mask, &s_colours](int a) {
+					auto colour = s_colours[src[a]];
+					colour.a    = mask[a];
+					return colour;
+				});
+			}
 		}
 
-		for (int x = x_pos; x < x_pos + img.width_; x++) // Columns
+		return true;
+	}
+
+	// Normal blending of paletted on to paletted, opaque pixels are remapped
+	// via a lookup table rather than finding the nearest colour every time
+	if (type_ == Type::PalMask && img.type_ == Type::PalMask && properties.blend == BlendType::Normal)
+	{
+		short remap[256];
+		std::fill(remap, remap + 256, -1);
+
+		for (int y = y_start; y < y_end; y++)
 		{
-			// Skip out-of-bounds columns
-			if (x < 0 || x >= width_)
+			auto dp     = y * d_stride + x_start;
+			auto sp     = (y - y_pos) * s_stride + (x_start - x_pos);
+			auto d_data = data_.data() + dp;
+			auto d_mask = mask_.data() + dp;
+			auto s_data = img.data_.data() + sp;
+			auto s_mask = img.mask_.data() + sp;
+
+			for (int a = 0; a < count; a++)
 			{
-				sp += s_bpp;
-				continue;
+				if (s_mask[a] == 0)
+					continue;
+
+				auto alpha = drawAlpha(s_mask[a], properties);
+				if (alpha == 255)
+				{
+					auto& index = remap[s_data[a]];
+					if (index < 0)
+					{
+						auto colour = pal_src->colour(s_data[a]);
+						colour.a    = 255;
+						index       = pal_dest->nearestColour(colour);
+					}
+
+					d_data[a] = index;
+					d_mask[a] = 255;
+				}
+				else if (alpha > 0)
+				{
+					// Translucent, needs blending
+					auto colour = pal_src->colour(s_data[a]);
+					colour.a    = s_mask[a];
+					drawPixel(x_start + a, y, colour, properties, pal_dest);
+				}
 			}
+		}
 
+		return true;
+	}
+
+	// Anything else, go through pixels
+	for (int y = y_start; y < y_end; y++) // Rows
+	{
+		unsigned sp = (y - y_pos) * s_stride + (x_start - x_pos) * s_bpp;
+		for (int x = x_start; x < x_end; x++) // Columns
+		{
 			// Skip if source pixel is fully transparent
 			if ((img.type_ == Type::PalMask && img.mask_[sp] == 0)
 				|| (img.type_ == Type::AlphaMap && img.data_[sp] == 0)
@@ -32,13 +32,17 @@
 #include "Main.h"
 #include "MapBackupManager.h"
 #include "App.h"
+#include "Archive/EntryType/EntryType.h"
+#include "Archive/Formats/WadArchive.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "General/Misc.h"
 #include "MapEditor.h"
 #include "UI/MapBackupPanel.h"
 #include "UI/SDialog.h"
 #include "UI/WxUtils.h"
+#include "Utility/FileUtils.h"
 #include "Utility/StringUtils.h"
+#include <fstream>
 
 
 
@@ -53,6 +57,267 @@ namespace
 // List of entry names to be ignored for backups
 string mb_ignore_entries[] = { "NODES",    "SSECTORS", "ZNODES",  "SEGS",     "REJECT",
 							   "BLOCKMAP", "GL_VERT",  "GL_SEGS", "GL_SSECT", "GL_NODES" };
+
+const string MANIFEST_HEADER = "SLADE map backup 1";
+const string EMPTY_BLOB      = "-";
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A single map data entry in a backup manifest
+struct ManifestEntry
+{
+	string name;
+	string blob;
+
+	bool operator==(const ManifestEntry& other) const { return name == other.name && blob == other.blob; }
+};
+
+// -----------------------------------------------------------------------------
+// Returns the path to the backup store directory for [archive_name].
+// The store contains a 'data' directory with each distinct entry data blob
+// (named by its content hash), and a 'maps' directory with a subdirectory per
+// map, containing a manifest file for each backup of that map
+// -----------------------------------------------------------------------------
+string storeDir(string_view archive_name)
+{
+	string fname{ archive_name };
+	std::replace(fname.begin(), fname.end(), '.', '_');
+	return App::path(fmt::format("backups/{}_backup", fname), App::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the path to the old (zip format) backup file for [archive_name]
+// -----------------------------------------------------------------------------
+string legacyBackupFile(string_view archive_name)
+{
+	string fname{ archive_name };
+	std::replace(fname.begin(), fname.end(), '.', '_');
+	return App::path(fmt::format("backups/{}_backup.zip", fname), App::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the name of the blob to store [data] as, from its size and content
+// hashes (CRC32 and 64-bit FNV-1a)
+// -----------------------------------------------------------------------------
+string blobName(const MemChunk& data)
+{
+	if (data.size() == 0)
+		return EMPTY_BLOB;
+
+	uint64_t fnv = 14695981039346656037ull;
+	for (unsigned a = 0; a < data.size(); a++)
+		fnv = (fnv ^ data[a]) * 1099511628211ull;
+
+	return fmt::format("{:08x}{:016x}_{}", Misc::crc(data.data(), data.size()), fnv, data.size());
+}
+
+// -----------------------------------------------------------------------------
+// Writes [data] to the store at [store_dir] as [blob], if it isn't already
+// there. Returns false if writing failed
+// -----------------------------------------------------------------------------
+bool writeBlob(const string& store_dir, const string& blob, const MemChunk& data)
+{
+	if (blob == EMPTY_BLOB)
+		return true;
+
+	auto path = fmt::format("{}/data/{}", store_dir, blob);
+	if (FileUtil::fileExists(path))
+		return true;
+
+	// Write to a temp file first, so an interrupted write doesn't leave a
+	// partial blob in the store
+	auto temp_path = path + ".tmp";
+	if (!data.exportFile(temp_path) || !wxRenameFile(temp_path, path, true))
+	{
+		Log::error("Unable to write map backup data file \"{}\"", path);
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the backup manifest at [path] into [entries].
+// Each line is in the form <entry name>\t<blob name>
+// -----------------------------------------------------------------------------
+bool readManifest(const string& path, vector<ManifestEntry>& entries)
+{
+	entries.clear();
+
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+
+	// Check header
+	string line;
+	if (!std::getline(file, line) || line != MANIFEST_HEADER)
+		return false;
+
+	while (std::getline(file, line))
+	{
+		auto tab = line.find('\t');
+		if (tab == string::npos)
+			continue;
+
+		entries.push_back({ line.substr(0, tab), line.substr(tab + 1) });
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes [entries] to the backup manifest at [path]
+// -----------------------------------------------------------------------------
+bool writeManifest(const string& path, const vector<ManifestEntry>& entries)
+{
+	auto temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path);
+		if (!file.is_open())
+			return false;
+
+		file << MANIFEST_HEADER << "\n";
+		for (const auto& entry : entries)
+			file << entry.name << '\t' << entry.blob << "\n";
+
+		if (!file.good())
+			return false;
+	}
+
+	return wxRenameFile(temp_path, path, true);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the paths of all backup manifests for [map_name] in the store at
+// [store_dir], oldest first
+// -----------------------------------------------------------------------------
+vector<string> manifestFiles(const string& store_dir, string_view map_name)
+{
+	vector<string> manifests;
+
+	auto map_dir = fmt::format("{}/maps/{}", store_dir, map_name);
+	if (!FileUtil::dirExists(map_dir))
+		return manifests;
+
+	for (auto& path : FileUtil::allFilesInDir(map_dir))
+		if (StrUtil::endsWith(path, ".txt"))
+			manifests.push_back(path);
+
+	// Manifests are named by timestamp, so sorting by name sorts by date
+	std::sort(manifests.begin(), manifests.end());
+
+	return manifests;
+}
+
+// -----------------------------------------------------------------------------
+// Removes any data blobs in the store at [store_dir] that aren't referenced by
+// any backup manifest
+// -----------------------------------------------------------------------------
+void removeUnusedBlobs(const string& store_dir)
+{
+	// Get all blobs referenced by manifests
+	std::set<string>      used;
+	vector<ManifestEntry> entries;
+	for (auto& path : FileUtil::allFilesInDir(store_dir + "/maps", true))
+	{
+		if (!StrUtil::endsWith(path, ".txt"))
+			continue;
+
+		// Don't remove anything if a manifest can't be read
+		if (!readManifest(path, entries))
+		{
+			Log::warning("Unable to read map backup manifest \"{}\"", path);
+			return;
+		}
+
+		for (auto& entry : entries)
+			used.insert(entry.blob);
+	}
+
+	// Remove unused blobs
+	for (auto& path : FileUtil::allFilesInDir(store_dir + "/data"))
+		if (used.find(string{ StrUtil::Path::fileNameOf(path) }) == used.end())
+			FileUtil::removeFile(path);
+}
+
+// -----------------------------------------------------------------------------
+// Creates the store directories for [map_name] in [store_dir] if needed.
+// Returns false if they couldn't be created
+// -----------------------------------------------------------------------------
+bool createStoreDirs(const string& store_dir, string_view map_name)
+{
+	for (auto& dir : { App::path("backups", App::Dir::User),
+					   store_dir,
+					   store_dir + "/data",
+					   store_dir + "/maps",
+					   fmt::format("{}/maps/{}", store_dir, map_name) })
+	{
+		if (!FileUtil::dirExists(dir) && !FileUtil::createDir(dir))
+		{
+			Log::error("Unable to create map backup directory \"{}\"", dir);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Imports any backups in the old (zip format) backup file for [archive_name]
+// into the backup store. The zip is renamed afterwards so that it is only
+// imported once
+// -----------------------------------------------------------------------------
+void importLegacyBackups(string_view archive_name)
+{
+	auto zip_file = legacyBackupFile(archive_name);
+	if (!FileUtil::fileExists(zip_file))
+		return;
+
+	ZipArchive zip;
+	if (!zip.open(zip_file))
+		return;
+
+	Log::info("Importing map backups from {}", zip_file);
+
+	// Each map is a dir, with a subdir (named by timestamp) per backup
+	auto store_dir = storeDir(archive_name);
+	auto root      = zip.rootDir();
+	for (unsigned a = 0; a < root->numSubdirs(); a++)
+	{
+		auto map_dir = root->subdirAt(a);
+		if (!createStoreDirs(store_dir, map_dir->name()))
+			return;
+
+		for (unsigned b = 0; b < map_dir->numSubdirs(); b++)
+		{
+			auto                  backup_dir = map_dir->subdirAt(b);
+			vector<ManifestEntry> entries;
+			for (unsigned c = 0; c < backup_dir->numEntries(); c++)
+			{
+				auto entry = backup_dir->entryAt(c);
+				auto blob  = blobName(entry->data());
+				if (!writeBlob(store_dir, blob, entry->data()))
+					return;
+
+				entries.push_back({ entry->name(), blob });
+			}
+
+			auto path = fmt::format("{}/maps/{}/{}.txt", store_dir, map_dir->name(), backup_dir->name());
+			if (!writeManifest(path, entries))
+				return;
+		}
+	}
+
+	zip.close();
+	wxRenameFile(zip_file, zip_file + ".imported", true);
+}
 } // namespace
 
 
@@ -65,25 +330,20 @@ string mb_ignore_entries[] = { "NODES",    "SSECTORS", "ZNODES",  "SEGS",     "R
 
 // -----------------------------------------------------------------------------
 // Writes a backup for [map_name] in [archive_name], with the map data entries
-// in [map_data]
+// in [map_data].
+// Only entry data not already in the backup store is written, along with a
+// small manifest listing the entries in the backup
 // -----------------------------------------------------------------------------
 bool MapBackupManager::writeBackup(
 	vector<unique_ptr<ArchiveEntry>>& map_data,
 	std::string_view                  archive_name,
 	std::string_view                  map_name) const
 {
-	// Create backup directory if needed
-	auto backup_dir = App::path("backups", App::Dir::User);
-	if (!wxDirExists(backup_dir))
-		wxMkdir(backup_dir);
-
-	// Open or create backup zip
-	shared_ptr<Archive> backup = std::make_shared<ZipArchive>();
-	string              fname{ archive_name };
-	std::replace(fname.begin(), fname.end(), '.', '_');
-	auto backup_file = fmt::format("{}/{}_backup.zip", backup_dir, fname);
-	if (!backup->open(backup_file))
-		backup->setFilename(backup_file);
+	// Create backup store directories if needed
+	auto store_dir = storeDir(archive_name);
+	importLegacyBackups(archive_name);
+	if (!createStoreDirs(store_dir, map_name))
+		return false;
 
 	// Filter ignored entries
 	vector<ArchiveEntry*> backup_entries;
@@ -104,61 +364,102 @@ bool MapBackupManager::writeBackup(
 			backup_entries.push_back(entry.get());
 	}
 
+	// Build manifest
+	vector<ManifestEntry> manifest;
+	for (auto entry : backup_entries)
+		manifest.push_back({ entry->name(), blobName(entry->data()) });
+
 	// Compare with last backup (if any)
-	auto map_dir = backup->dirAtPath(map_name);
-	if (map_dir && map_dir->numSubdirs() > 0)
+	auto manifests = manifestFiles(store_dir, map_name);
+	if (!manifests.empty())
 	{
-		auto last_backup = map_dir->subdirAt(map_dir->numSubdirs() - 1);
-		bool same        = true;
-		if (last_backup->numEntries() != backup_entries.size())
-			same = false;
-		else
-		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
-			{
-				auto e1 = backup_entries[a];
-				auto e2 = last_backup->entryAt(a);
-				if (e1->size() != e2->size())
-				{
-					same = false;
-					break;
-				}
-
-				uint32_t crc1 = Misc::crc(e1->rawData(), e1->size());
-				uint32_t crc2 = Misc::crc(e2->rawData(), e2->size());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
-			}
-		}
-
-		if (same)
+		vector<ManifestEntry> last_backup;
+		if (readManifest(manifests.back(), last_backup) && last_backup == manifest)
 		{
 			Log::info(2, "Same data as previous backup - ignoring");
 			return true;
 		}
 	}
 
-	// Add map data to backup
+	// Write any entry data not already in the store
+	for (unsigned a = 0; a < backup_entries.size(); a++)
+		if (!writeBlob(store_dir, manifest[a].blob, backup_entries[a]->data()))
+			return false;
+
+	// Write manifest
 	auto timestamp = wxDateTime::Now().FormatISOCombined('_').ToStdString();
 	StrUtil::replaceIP(timestamp, ":", "");
-	auto dir = fmt::format("{}/{}", map_name, timestamp);
-	for (auto& entry : backup_entries)
-		backup->addEntry(std::make_shared<ArchiveEntry>(*entry), dir);
+	auto manifest_path = fmt::format("{}/maps/{}/{}.txt", store_dir, map_name, timestamp);
+	if (!writeManifest(manifest_path, manifest))
+	{
+		Log::error("Unable to write map backup manifest \"{}\"", manifest_path);
+		return false;
+	}
 
 	// Check for max backups & remove old ones if over
-	map_dir = backup->dirAtPath(map_name);
-	while ((int)map_dir->numSubdirs() > max_map_backups)
-		backup->removeDir(map_dir->subdirAt(0)->name(), map_dir);
+	manifests  = manifestFiles(store_dir, map_name);
+	bool prune = false;
+	for (int a = 0; a < (int)manifests.size() - max_map_backups; a++)
+	{
+		FileUtil::removeFile(manifests[a]);
+		prune = true;
+	}
+	if (prune)
+		removeUnusedBlobs(store_dir);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the timestamps of all backups for [map_name] in [archive_name],
+// oldest first
+// -----------------------------------------------------------------------------
+vector<string> MapBackupManager::backupTimestamps(string_view archive_name, string_view map_name) const
+{
+	importLegacyBackups(archive_name);
+
+	vector<string> timestamps;
+	for (auto& path : manifestFiles(storeDir(archive_name), map_name))
+		timestamps.emplace_back(StrUtil::Path::fileNameOf(path, false));
+
+	return timestamps;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the map data from the backup of [map_name] in [archive_name] at
+// [timestamp] in a WadArchive, or null if it couldn't be loaded
+// -----------------------------------------------------------------------------
+unique_ptr<Archive> MapBackupManager::backupMapData(
+	string_view archive_name,
+	string_view map_name,
+	string_view timestamp) const
+{
+	auto store_dir = storeDir(archive_name);
 
-	// Save backup file
-	Archive::save_backup = false;
-	bool ok              = backup->save();
-	Archive::save_backup = true;
+	vector<ManifestEntry> manifest;
+	auto                  manifest_path = fmt::format("{}/maps/{}/{}.txt", store_dir, map_name, timestamp);
+	if (!readManifest(manifest_path, manifest))
+	{
+		Log::error("Unable to read map backup manifest \"{}\"", manifest_path);
+		return nullptr;
+	}
+
+	auto wad = std::make_unique<WadArchive>();
+	for (auto& mentry : manifest)
+	{
+		auto entry = std::make_shared<ArchiveEntry>(mentry.name);
+		if (mentry.blob != EMPTY_BLOB && !entry->importFile(fmt::format("{}/data/{}", store_dir, mentry.blob)))
+		{
+			Log::error("Map backup data for {} in backup {} of {} is missing", mentry.name, timestamp, map_name);
+			return nullptr;
+		}
+
+		EntryType::detectEntryType(*entry);
+		entry->setState(ArchiveEntry::State::Unmodified);
+		wad->addEntry(entry, "");
+	}
 
-	return ok;
+	return wad;
 }
 
 // -----------------------------------------------------------------------------
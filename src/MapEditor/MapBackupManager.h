@@ -10,4 +10,7 @@ public:
 
 	bool writeBackup(vector<unique_ptr<ArchiveEntry>>& map_data, string_view archive_name, string_view map_name) const;
 	Archive* openBackup(string_view archive_name, string_view map_name) const;
+
+	vector<string>      backupTimestamps(string_view archive_name, string_view map_name) const;
+	unique_ptr<Archive> backupMapData(string_view archive_name, string_view map_name, string_view timestamp) const;
 };
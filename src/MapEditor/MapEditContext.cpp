@@ -284,8 +284,8 @@ void MapEditContext::lockMouse(bool lock)
 // -----------------------------------------------------------------------------
 bool MapEditContext::update(long frametime)
 {
-	// Force an update if animations are active
-	if (renderer_.animationsActive() || selection_.hasHilight())
+	// Force an update if animations are active or textures are still loading
+	if (renderer_.animationsActive() || selection_.hasHilight() || MapEditor::textureManager().loadsPending())
 		next_frame_length_ = 2;
 
 	// Ignore if we aren't ready to update
@@ -398,6 +398,25 @@ bool MapEditContext::openMap(Archive::MapDesc map)
 
 		// Reset rendering data
 		forceRefreshRenderer();
+
+		// Start loading all textures used in the map in the background
+		std::set<string> textures, flats;
+		for (unsigned a = 0; a < map_.nSides(); a++)
+		{
+			auto side = map_.side(a);
+			textures.insert(side->texUpper());
+			textures.insert(side->texMiddle());
+			textures.insert(side->texLower());
+		}
+		for (unsigned a = 0; a < map_.nSectors(); a++)
+		{
+			flats.insert(map_.sector(a)->floor().texture);
+			flats.insert(map_.sector(a)->ceiling().texture);
+		}
+		MapEditor::textureManager().prefetch(
+			{ textures.begin(), textures.end() },
+			{ flats.begin(), flats.end() },
+			Game::configuration().featureSupported(Game::Feature::MixTexFlats));
 	}
 
 	edit_3d_.setLinked(true, true);
@@ -2508,6 +2527,54 @@ CONSOLE_COMMAND(m_test_mobj_backup, 0, false)
 	Log::info("Total: {}ms", totalClock.getElapsedTime().asMilliseconds());
 }
 
+CONSOLE_COMMAND(m_test_undo_create_delete, 0, false)
+{
+	// Build a test map with 100k lines
+	SLADEMap    map;
+	UndoManager manager(&map);
+	for (unsigned a = 0; a < 100000; a++)
+	{
+		double x = (a % 1000) * 64;
+		double y = (a / 1000) * 64;
+		map.createLine(map.createVertex({ x, y }), map.createVertex({ x + 32, y + 32 }));
+	}
+
+	// Record 1000 'draw lines' operations (4 vertices, 4 lines each)
+	sf::Clock clock;
+	for (unsigned a = 0; a < 1000; a++)
+	{
+		double x = (a % 100) * 64;
+		double y = -64. - (a / 100) * 64;
+
+		manager.beginRecord("Draw Lines");
+		auto ustep = std::make_unique<MapEditor::MapObjectCreateDeleteUS>();
+		auto v1    = map.createVertex({ x, y });
+		auto v2    = map.createVertex({ x + 32, y });
+		auto v3    = map.createVertex({ x + 32, y + 32 });
+		auto v4    = map.createVertex({ x, y + 32 });
+		map.createLine(v1, v2);
+		map.createLine(v2, v3);
+		map.createLine(v3, v4);
+		map.createLine(v4, v1);
+		ustep->checkChanges();
+		manager.recordUndoStep(std::move(ustep));
+		manager.endRecord(true);
+	}
+	Log::info("Record: {}ms ({} lines)", clock.getElapsedTime().asMilliseconds(), map.nLines());
+
+	// Undo all
+	clock.restart();
+	while (!manager.undo().empty())
+		;
+	Log::info("Undo: {}ms ({} lines)", clock.getElapsedTime().asMilliseconds(), map.nLines());
+
+	// Redo all
+	clock.restart();
+	while (!manager.redo().empty())
+		;
+	Log::info("Redo: {}ms ({} lines)", clock.getElapsedTime().asMilliseconds(), map.nLines());
+}
+
 CONSOLE_COMMAND(m_vertex_attached, 1, false)
 {
 	MapVertex* vertex = MapEditor::editContext().map().vertex(atoi(args[0].c_str()));
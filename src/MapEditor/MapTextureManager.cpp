@@ -46,6 +46,7 @@
 #include "OpenGL/OpenGL.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "Utility/StringUtils.h"
+#include "Utility/ThreadPool.h"
 
 
 // -----------------------------------------------------------------------------
@@ -58,6 +59,88 @@ namespace
 MapTextureManager::Texture tex_invalid;
 }
 CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
+CVAR(Bool, map_tex_async, true, CVar::Flag::Save)
+CVAR(Int, map_tex_load_threads, 0, CVar::Flag::Save)
+CVAR(Int, map_tex_upload_time, 5, CVar::Flag::Save)
+CVAR(Bool, map_sprite_atlas, true, CVar::Flag::Save)
+
+
+// -----------------------------------------------------------------------------
+//
+// MapTextureManager::LoadJob Struct
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// A texture, flat or sprite image to be loaded on a background thread.
+// Everything needed to load the image is copied from resources beforehand (on
+// the main thread), so loading doesn't touch any archives or resources
+// -----------------------------------------------------------------------------
+struct MapTextureManager::LoadJob
+{
+	char     type = 't'; // t = texture, f = flat, s = sprite
+	string   key;
+	unsigned gl_id      = 0;
+	unsigned generation = 0;
+
+	// Image source (either a copy of an image entry or a composite texture)
+	unique_ptr<ArchiveEntry>          entry;
+	unique_ptr<ArchiveEntry>          scale_ref; // Hires scale reference
+	unique_ptr<CTexture::ImageSource> composite;
+
+	// Sprite modifiers (applied when uploading)
+	string translation;
+	string palette;
+	bool   mirror = false;
+
+	// Loaded image
+	SImage image;
+	bool   loaded        = false;
+	bool   world_panning = false;
+	Vec2d  scale         = { 1., 1. };
+
+	void load();
+};
+
+// -----------------------------------------------------------------------------
+// Loads the job's image from its source
+// -----------------------------------------------------------------------------
+void MapTextureManager::LoadJob::load()
+{
+	// Composite texture
+	if (composite)
+	{
+		loaded = composite->toImage(image);
+		if (loaded)
+		{
+			double sx = composite->texture->scaleX();
+			if (sx == 0)
+				sx = 1.0;
+			double sy = composite->texture->scaleY();
+			if (sy == 0)
+				sy = 1.0;
+
+			world_panning = composite->texture->worldPanning();
+			scale         = { 1.0 / sx, 1.0 / sy };
+		}
+
+		return;
+	}
+
+	// Image entry
+	if (!entry)
+		return;
+	loaded = Misc::loadImageFromEntry(&image, entry.get());
+
+	// Handle hires texture scale
+	SImage imgref;
+	if (loaded && scale_ref && Misc::loadImageFromEntry(&imgref, scale_ref.get()))
+	{
+		world_panning = true;
+		scale         = { (double)imgref.width() / (double)image.width(), (double)imgref.height() / (double)image.height() };
+	}
+}
 
 
 // -----------------------------------------------------------------------------
@@ -72,6 +155,21 @@ CVAR(Int, map_tex_filter, 0, CVar::Flag::Save)
 // -----------------------------------------------------------------------------
 MapTextureManager::MapTextureManager(shared_ptr<Archive> archive) : archive_{ archive }, palette_{ new Palette() } {}
 
+// -----------------------------------------------------------------------------
+// MapTextureManager class destructor
+// -----------------------------------------------------------------------------
+MapTextureManager::~MapTextureManager()
+{
+	// Stop background loading threads
+	{
+		std::lock_guard<std::mutex> lock(load_mutex_);
+		load_stop_ = true;
+	}
+	load_cv_.notify_all();
+	for (auto& thread : load_threads_)
+		thread.join();
+}
+
 // -----------------------------------------------------------------------------
 // Initialises the texture manager
 // -----------------------------------------------------------------------------
@@ -109,12 +207,15 @@ Palette* MapTextureManager::resourcePalette() const
 
 // -----------------------------------------------------------------------------
 // Returns the texture matching [name], loading it from resources if necessary.
-// If [mixed] is true, flats are also searched if no matching texture is found
+// If [mixed] is true, flats are also searched if no matching texture is found.
+// If [async] is true, the texture is loaded in the background and a
+// placeholder is returned until it is ready
 // -----------------------------------------------------------------------------
-const MapTextureManager::Texture& MapTextureManager::texture(string_view name, bool mixed)
+const MapTextureManager::Texture& MapTextureManager::texture(string_view name, bool mixed, bool async)
 {
 	// Get texture matching name
-	auto& mtex = textures_[StrUtil::upper(name)];
+	auto  key  = StrUtil::upper(name);
+	auto& mtex = textures_[key];
 
 	// Get desired filter type
 	auto filter = OpenGL::TexFilter::Linear;
@@ -153,6 +254,35 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 		etex         = App::resources().getTextureEntry(name, "textures", archive);
 		textypefound = CTexture::Type::Texture;
 	}
+	auto ctex = App::resources().getTexture(name, archive);
+
+	// Load in the background if requested
+	if (async && canLoadAsync('t', key))
+	{
+		auto job  = std::make_unique<LoadJob>();
+		job->type = 't';
+		job->key  = key;
+		if (ctex) // Composite textures take precedence over the textures directory
+			job->composite = ctex->imageSource(archive, palette_.get(), true);
+		else if (etex)
+		{
+			job->entry = std::make_unique<ArchiveEntry>(*etex);
+			if (textypefound == CTexture::Type::HiRes)
+				if (auto ref = App::resources().getTextureEntry(name, "textures", archive))
+					job->scale_ref = std::make_unique<ArchiveEntry>(*ref);
+		}
+		else if (mixed)
+			return flat(name, false, async);
+		else
+		{
+			mtex.gl_id = OpenGL::Texture::missingTexture();
+			return mtex;
+		}
+
+		mtex.gl_id = queueLoad(std::move(job), filter);
+		return mtex;
+	}
+
 	if (etex)
 	{
 		SImage image;
@@ -184,7 +314,6 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 	}
 
 	// Try composite textures then
-	auto ctex = App::resources().getTexture(name, archive);
 	if (ctex) // Composite textures take precedence over the textures directory
 	{
 		textypefound = CTexture::Type::WallTexture;
@@ -221,12 +350,15 @@ const MapTextureManager::Texture& MapTextureManager::texture(string_view name, b
 
 // -----------------------------------------------------------------------------
 // Returns the flat matching [name], loading it from resources if necessary.
-// If [mixed] is true, textures are also searched if no matching flat is found
+// If [mixed] is true, textures are also searched if no matching flat is found.
+// If [async] is true, the flat is loaded in the background and a placeholder is
+// returned until it is ready
 // -----------------------------------------------------------------------------
-const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool mixed)
+const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool mixed, bool async)
 {
 	// Get flat matching name
-	auto& mtex = flats_[StrUtil::upper(name)];
+	auto  key  = StrUtil::upper(name);
+	auto& mtex = flats_[key];
 
 	// Get desired filter type
 	auto filter = OpenGL::TexFilter::Linear;
@@ -255,6 +387,40 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 	}
 
 	auto archive = archive_.lock().get();
+
+	// Load in the background if requested
+	if (async && canLoadAsync('f', key))
+	{
+		auto job  = std::make_unique<LoadJob>();
+		job->type = 'f';
+		job->key  = key;
+
+		auto ctex = mixed ? App::resources().getTexture(name, archive) : nullptr;
+		if (ctex && ctex->isExtended() && ctex->type() != "WallTexture")
+			job->composite = ctex->imageSource(archive, palette_.get(), true);
+		else
+		{
+			auto entry = App::resources().getTextureEntry(name, "hires", archive);
+			if (entry == nullptr)
+				entry = App::resources().getTextureEntry(name, "flats", archive);
+			if (entry == nullptr)
+				entry = App::resources().getFlatEntry(name, archive);
+
+			if (entry)
+				job->entry = std::make_unique<ArchiveEntry>(*entry);
+			else if (mixed)
+				return texture(name, false, async);
+			else
+			{
+				mtex.gl_id = OpenGL::Texture::missingTexture();
+				return mtex;
+			}
+		}
+
+		mtex.gl_id = queueLoad(std::move(job), filter);
+		return mtex;
+	}
+
 	if (mixed)
 	{
 		auto ctex = App::resources().getTexture(name, archive);
@@ -314,12 +480,15 @@ const MapTextureManager::Texture& MapTextureManager::flat(string_view name, bool
 
 // -----------------------------------------------------------------------------
 // Returns the sprite matching [name], loading it from resources if necessary.
-// Sprite name also supports wildcards (?)
+// Sprite name also supports wildcards (?).
+// If [async] is true, the sprite is loaded in the background and a placeholder
+// is returned until it is ready
 // -----------------------------------------------------------------------------
 const MapTextureManager::Texture& MapTextureManager::sprite(
 	string_view name,
 	string_view translation,
-	string_view palette)
+	string_view palette,
+	bool        async)
 {
 	// Don't bother looking for nameless sprites
 	if (name.empty())
@@ -345,6 +514,7 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		filter = OpenGL::TexFilter::Linear;
 	else if (map_tex_filter == 3)
 		filter = OpenGL::TexFilter::NearestMipmap;
+	sprite_atlas_.setFilter(filter);
 
 	// If the texture is loaded
 	if (mtex.gl_id)
@@ -356,6 +526,7 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		else
 		{
 			// Otherwise, reload the texture
+			sprite_atlas_.remove(mtex.gl_id);
 			OpenGL::Texture::clear(mtex.gl_id);
 			mtex.gl_id = 0;
 		}
@@ -380,7 +551,28 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 		if (entry)
 			mirror = true;
 	}
-	if (entry)
+
+	// Load in the background if requested
+	if (async && canLoadAsync('s', hashname))
+	{
+		auto job  = std::make_unique<LoadJob>();
+		job->type = 's';
+		job->key  = hashname;
+		if (entry)
+			job->entry = std::make_unique<ArchiveEntry>(*entry);
+		else if (auto ctex = App::resources().getTexture(name, archive))
+			job->composite = ctex->imageSource(archive, palette_.get(), true);
+
+		if (job->entry || job->composite)
+		{
+			job->translation = translation;
+			job->palette     = palette;
+			job->mirror      = mirror;
+			mtex.gl_id       = queueLoad(std::move(job), filter, false);
+			return mtex;
+		}
+	}
+	else if (entry)
 	{
 		found = true;
 		Misc::loadImageFromEntry(&image, entry);
@@ -418,24 +610,26 @@ const MapTextureManager::Texture& MapTextureManager::sprite(
 
 		// Turn into GL texture
 		mtex.gl_id = OpenGL::Texture::createFromImage(image, pal, filter, false);
+		if (mtex.gl_id && map_sprite_atlas)
+			sprite_atlas_.add(mtex.gl_id, image, pal);
 		return mtex;
 	}
 	else if (name.back() == '?')
 	{
 		name.remove_suffix(1);
-		auto stex = &sprite(fmt::format("{}0", name), translation, palette);
+		auto stex = &sprite(fmt::format("{}0", name), translation, palette, async);
 		if (!stex->gl_id)
-			stex = &sprite(fmt::format("{}1", name), translation, palette);
+			stex = &sprite(fmt::format("{}1", name), translation, palette, async);
 		if (stex->gl_id)
 			return *stex;
 		if (!stex->gl_id && name.length() == 5)
 		{
 			for (char chr = 'A'; chr <= ']'; ++chr)
 			{
-				stex = &sprite(fmt::format("{}0{}0", name, chr), translation, palette);
+				stex = &sprite(fmt::format("{}0{}0", name, chr), translation, palette, async);
 				if (stex->gl_id)
 					return *stex;
-				stex = &sprite(fmt::format("{}1{}1", name, chr), translation, palette);
+				stex = &sprite(fmt::format("{}1{}1", name, chr), translation, palette, async);
 				if (stex->gl_id)
 					return *stex;
 			}
@@ -476,6 +670,225 @@ int MapTextureManager::verticalOffset(string_view name) const
 	return 0;
 }
 
+// -----------------------------------------------------------------------------
+// Queues background loading of all [textures] and [flats] that aren't already
+// loaded, so they are (hopefully) ready by the time they are first drawn
+// -----------------------------------------------------------------------------
+void MapTextureManager::prefetch(const vector<string>& textures, const vector<string>& flats, bool mixed)
+{
+	if (!map_tex_async || !OpenGL::isInitialised())
+		return;
+
+	for (const auto& name : textures)
+		if (!name.empty() && name != "-")
+			texture(name, mixed, true);
+
+	for (const auto& name : flats)
+		if (!name.empty())
+			flat(name, mixed, true);
+}
+
+// -----------------------------------------------------------------------------
+// Uploads background-loaded images to their OpenGL textures, for up to
+// map_tex_upload_time milliseconds (at least one is always uploaded).
+// Returns true if anything was uploaded and the map renderer should refresh
+// the textures in [uploaded] (sorted OpenGL texture ids). This is limited while
+// loads are still pending, to avoid refreshing renderer data every frame
+// -----------------------------------------------------------------------------
+bool MapTextureManager::uploadLoaded(vector<unsigned>& uploaded)
+{
+	if (loads_pending_ == 0)
+		return false;
+
+	// Get loaded jobs
+	{
+		std::lock_guard<std::mutex> lock(load_mutex_);
+		for (auto& job : loaded_)
+			upload_queue_.push_back(std::move(job));
+		loaded_.clear();
+	}
+
+	// Upload within the time limit
+	auto start    = App::runTimer();
+	bool uploaded_any = false;
+	while (!upload_queue_.empty())
+	{
+		if (uploaded_any && App::runTimer() - start >= map_tex_upload_time)
+			break;
+
+		auto job = std::move(upload_queue_.front());
+		upload_queue_.pop_front();
+		loads_pending_--;
+
+		if (uploadJob(*job))
+		{
+			uploaded_any = true;
+			uploaded_.push_back(job->gl_id);
+		}
+	}
+
+	// Check if the renderer needs updating
+	auto time = App::runTimer();
+	if (!uploaded_.empty() && (loads_pending_ == 0 || time - last_upload_update_ >= 500))
+	{
+		std::sort(uploaded_.begin(), uploaded_.end());
+		uploaded.swap(uploaded_);
+		uploaded_.clear();
+		last_upload_update_ = time;
+		return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the [type] texture [key] can be loaded in the background
+// (ie. background loading is enabled and it hasn't already failed to load)
+// -----------------------------------------------------------------------------
+bool MapTextureManager::canLoadAsync(char type, const string& key) const
+{
+	return map_tex_async && OpenGL::isInitialised() && load_failed_.count(type + key) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Queues [job] for loading on a background thread, starting the loader threads
+// if needed. Returns the id of a placeholder OpenGL texture (with [filter] and
+// [tiling]) that the loaded image will be uploaded to
+// -----------------------------------------------------------------------------
+unsigned MapTextureManager::queueLoad(unique_ptr<LoadJob> job, OpenGL::TexFilter filter, bool tiling)
+{
+	// Create placeholder texture (transparent for sprites)
+	uint8_t placeholder[] = { 128, 128, 128, job->type == 's' ? (uint8_t)0 : (uint8_t)255 };
+	auto    gl_id         = OpenGL::Texture::create(filter, tiling);
+	OpenGL::Texture::loadData(gl_id, placeholder, 1, 1);
+	job->gl_id      = gl_id;
+	job->generation = load_generation_;
+
+	// Start loader threads if needed (leaving a core free for the main thread
+	// by default)
+	if (load_threads_.empty())
+	{
+		auto num_threads = ThreadPool::numThreads(map_tex_load_threads);
+		if (map_tex_load_threads <= 0 && num_threads > 1)
+			num_threads--;
+		for (unsigned a = 0; a < num_threads; a++)
+			load_threads_.emplace_back(&MapTextureManager::loadThread, this);
+	}
+
+	// Queue job
+	{
+		std::lock_guard<std::mutex> lock(load_mutex_);
+		load_queue_.push_back(std::move(job));
+	}
+	loads_pending_++;
+	load_cv_.notify_one();
+
+	return gl_id;
+}
+
+// -----------------------------------------------------------------------------
+// Uploads the image loaded by [job] to its OpenGL texture, applying any sprite
+// modifiers. If the image failed to load the texture is cleared, so that it is
+// looked up (synchronously) again next time it is requested.
+// Returns false if the job is out of date and was discarded
+// -----------------------------------------------------------------------------
+bool MapTextureManager::uploadJob(LoadJob& job)
+{
+	// Discard if resources have been refreshed since the job was queued
+	if (job.generation != load_generation_)
+		return false;
+
+	// Discard if the texture was reloaded or removed since the job was queued
+	auto& map  = job.type == 't' ? textures_ : job.type == 'f' ? flats_ : sprites_;
+	auto  mtex = map.find(job.key);
+	if (mtex == map.end() || mtex->second.gl_id != job.gl_id)
+		return false;
+
+	auto pal = palette_.get();
+	if (job.loaded)
+	{
+		// Apply translation
+		if (!job.translation.empty())
+			job.image.applyTranslation(job.translation, pal, true);
+
+		// Apply palette override
+		if (!job.palette.empty())
+		{
+			auto newpal = App::resources().getPaletteEntry(job.palette, archive_.lock().get());
+			if (newpal && newpal->size() == 768)
+			{
+				pal = job.image.palette();
+				pal->loadMem(newpal->data());
+			}
+		}
+
+		// Apply mirroring
+		if (job.mirror)
+			job.image.mirror(false);
+	}
+
+	// Upload
+	if (!job.loaded || !OpenGL::Texture::loadImage(job.gl_id, job.image, pal))
+	{
+		OpenGL::Texture::clear(job.gl_id);
+		mtex->second.gl_id = 0;
+		load_failed_.insert(job.type + job.key);
+		return true;
+	}
+
+	mtex->second.world_panning = job.world_panning;
+	mtex->second.scale         = job.scale;
+
+	// Add sprites to the atlas
+	if (job.type == 's' && map_sprite_atlas)
+		sprite_atlas_.add(job.gl_id, job.image, pal);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Cancels all queued background loads. Any currently loading or loaded (but
+// not yet uploaded) images will be discarded when they are next uploaded
+// -----------------------------------------------------------------------------
+void MapTextureManager::clearLoads()
+{
+	{
+		std::lock_guard<std::mutex> lock(load_mutex_);
+		loads_pending_ -= load_queue_.size();
+		load_queue_.clear();
+	}
+
+	load_generation_++;
+	load_failed_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Background loader thread function, loads queued jobs until stopped
+// -----------------------------------------------------------------------------
+void MapTextureManager::loadThread()
+{
+	while (true)
+	{
+		// Wait for a job
+		unique_ptr<LoadJob> job;
+		{
+			std::unique_lock<std::mutex> lock(load_mutex_);
+			load_cv_.wait(lock, [this] { return load_stop_ || !load_queue_.empty(); });
+			if (load_stop_)
+				return;
+
+			job = std::move(load_queue_.front());
+			load_queue_.pop_front();
+		}
+
+		// Load it
+		job->load();
+
+		std::lock_guard<std::mutex> lock(load_mutex_);
+		loaded_.push_back(std::move(job));
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Loads all editor images (thing icons, etc) from the program resource archive
 // -----------------------------------------------------------------------------
@@ -534,7 +947,9 @@ const MapTextureManager::Texture& MapTextureManager::editorImage(string_view nam
 // -----------------------------------------------------------------------------
 void MapTextureManager::refreshResources()
 {
-	// Just clear all cached textures
+	// Just clear all cached textures (and any pending background loads)
+	clearLoads();
+	sprite_atlas_.clear();
 	textures_.clear();
 	flats_.clear();
 	sprites_.clear();
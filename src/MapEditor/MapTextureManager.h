@@ -1,6 +1,12 @@
 #pragma once
 
 #include "OpenGL/GLTexture.h"
+#include "OpenGL/TextureAtlas.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
 
 class ArchiveDir;
 class Archive;
@@ -55,7 +61,7 @@ public:
 	};
 
 	MapTextureManager(shared_ptr<Archive> archive = nullptr);
-	~MapTextureManager() = default;
+	~MapTextureManager();
 
 	void init();
 	void setArchive(shared_ptr<Archive> archive);
@@ -63,12 +69,22 @@ public:
 	void buildTexInfoList();
 
 	Palette*       resourcePalette() const;
-	const Texture& texture(string_view name, bool mixed);
-	const Texture& flat(string_view name, bool mixed);
-	const Texture& sprite(string_view name, string_view translation = "", string_view palette = "");
+	const Texture& texture(string_view name, bool mixed, bool async = false);
+	const Texture& flat(string_view name, bool mixed, bool async = false);
+	const Texture& sprite(
+		string_view name,
+		string_view translation = "",
+		string_view palette     = "",
+		bool        async       = false);
 	const Texture& editorImage(string_view name);
 	int            verticalOffset(string_view name) const;
 
+	void prefetch(const vector<string>& textures, const vector<string>& flats, bool mixed);
+	bool loadsPending() const { return loads_pending_ > 0; }
+	bool uploadLoaded(vector<unsigned>& uploaded);
+
+	const OpenGL::TextureAtlas::Region* spriteAtlasRegion(unsigned gl_id) const { return sprite_atlas_.region(gl_id); }
+
 	vector<TexInfo>& allTexturesInfo() { return tex_info_; }
 	vector<TexInfo>& allFlatsInfo() { return flat_info_; }
 
@@ -83,9 +99,32 @@ private:
 	vector<TexInfo>     tex_info_;
 	vector<TexInfo>     flat_info_;
 
+	// Small sprites packed into shared textures, by sprite texture id
+	OpenGL::TextureAtlas sprite_atlas_;
+
+	// Background loading
+	struct LoadJob;
+	vector<std::thread>             load_threads_;
+	std::mutex                      load_mutex_;
+	std::condition_variable         load_cv_;
+	std::deque<unique_ptr<LoadJob>> load_queue_;
+	vector<unique_ptr<LoadJob>>     loaded_;
+	bool                            load_stop_ = false;
+	std::deque<unique_ptr<LoadJob>> upload_queue_;
+	unsigned                        loads_pending_   = 0;
+	unsigned                        load_generation_ = 0;
+	vector<unsigned>                uploaded_;
+	long                            last_upload_update_ = 0;
+	std::set<string>                load_failed_;
+
 	// Signal connections
 	sigslot::scoped_connection sc_resources_updated_;
 	sigslot::scoped_connection sc_palette_changed_;
 
-	void importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path) const;
+	void     importEditorImages(MapTexHashMap& map, ArchiveDir* dir, string_view path) const;
+	bool     canLoadAsync(char type, const string& key) const;
+	unsigned queueLoad(unique_ptr<LoadJob> job, OpenGL::TexFilter filter, bool tiling = true);
+	bool     uploadJob(LoadJob& job);
+	void     clearLoads();
+	void     loadThread();
 };
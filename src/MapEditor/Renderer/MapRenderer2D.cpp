@@ -43,6 +43,7 @@
 #include "OpenGL/GLTexture.h"
 #include "OpenGL/OpenGL.h"
 #include "SLADEMap/SLADEMap.h"
+#include "Utility/MathStuff.h"
 #include "Utility/Polygon2D.h"
 
 
@@ -69,6 +70,7 @@ CVAR(Bool, map_animate_tagged, true, CVar::Flag::Save)
 CVAR(Float, arrow_alpha, 1.0f, CVar::Flag::Save)
 CVAR(Bool, arrow_colour, false, CVar::Flag::Save)
 CVAR(Bool, flats_use_vbo, true, CVar::Flag::Save)
+CVAR(Bool, things_use_vbo, true, CVar::Flag::Save)
 CVAR(Int, halo_width, 5, CVar::Flag::Save)
 CVAR(Float, arrowhead_angle, 0.7854f, CVar::Flag::Save)
 CVAR(Float, arrowhead_length, 25.f, CVar::Flag::Save)
@@ -80,6 +82,9 @@ namespace
 {
 // Texture coordinates for rendering square things (since we can't just rotate these)
 float sq_thing_tc[] = { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f };
+
+// Size (in map units) of the tiles the line and vertex VBOs are split into
+constexpr double VBO_TILE_SIZE = 1024.;
 } // namespace
 
 
@@ -91,6 +96,56 @@ float sq_thing_tc[] = { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f };
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Line classes, used to look up line colours
+enum LineClass : uint8_t
+{
+	LINE_INVALID   = 0, // No front side
+	LINE_NORMAL    = 1,
+	LINE_SPECIAL   = 2,
+	LINE_BASE_MASK = 3,
+
+	// Flags
+	LINE_TWOSIDED = 4,
+	LINE_FILTERED = 8,
+
+	LINE_CLASS_COUNT = 16
+};
+
+// -----------------------------------------------------------------------------
+// Returns the colour for lines of [line_class]
+// -----------------------------------------------------------------------------
+ColRGBA lineClassColour(uint8_t line_class)
+{
+	ColRGBA col;
+
+	// Base colour
+	switch (line_class & LINE_BASE_MASK)
+	{
+	case LINE_SPECIAL: col.set(ColourConfiguration::colour("map_line_special")); break;
+	case LINE_NORMAL: col.set(ColourConfiguration::colour("map_line_normal")); break;
+	default: col.set(ColourConfiguration::colour("map_line_invalid")); break;
+	}
+
+	// Two-sided lines are more transparent
+	if (line_class & LINE_TWOSIDED)
+		col.a *= 0.5f;
+
+	// As are filtered lines
+	if (line_class & LINE_FILTERED)
+		col.a *= 0.25f;
+
+	return col;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapRenderer2D Class Functions
@@ -103,12 +158,12 @@ EXTERN_CVAR(Bool, use_zeth_icons)
 // -----------------------------------------------------------------------------
 MapRenderer2D::~MapRenderer2D()
 {
-	if (vbo_vertices_ > 0)
-		glDeleteBuffers(1, &vbo_vertices_);
-	if (vbo_lines_ > 0)
-		glDeleteBuffers(1, &vbo_lines_);
+	clearVBOTiles(vertex_tiles_);
+	clearVBOTiles(line_tiles_);
 	if (vbo_flats_ > 0)
 		glDeleteBuffers(1, &vbo_flats_);
+	if (vbo_things_ > 0)
+		glDeleteBuffers(1, &vbo_things_);
 	if (list_vertices_ > 0)
 		glDeleteLists(list_vertices_, 1);
 	if (list_lines_ > 0)
@@ -237,7 +292,8 @@ void MapRenderer2D::renderVerticesImmediate()
 }
 
 // -----------------------------------------------------------------------------
-// Renders vertices using an OpenGL Vertex Buffer Object
+// Renders vertices using OpenGL Vertex Buffer Objects (one per tile, only tiles
+// within the view are drawn)
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderVerticesVBO()
 {
@@ -245,21 +301,39 @@ void MapRenderer2D::renderVerticesVBO()
 	if (map_->nVertices() == 0)
 		return;
 
-	// Update vertices VBO if required
-	if (vbo_vertices_ == 0 || map_->nVertices() != n_vertices_ || map_->geometryUpdated() > vertices_updated_)
+	// Rebuild vertex tiles if vertices were added, removed or reordered (since
+	// tiles hold vertex indices), otherwise just update tiles with modified
+	// vertices
+	if (vertex_tiles_.empty() || map_->vertices().structureVersion() != vertex_tiles_version_)
 		updateVerticesVBO();
+	else if (map_->geometryUpdated() > vertices_updated_)
+	{
+		for (unsigned a = 0; a < map_->nVertices(); a++)
+			if (map_->vertex(a)->modifiedTime() > vertices_updated_)
+				vertex_tiles_[vertex_tile_index_[a]].dirty = true;
+
+		for (auto& tile : vertex_tiles_)
+			if (tile.dirty)
+				writeVertexTile(tile);
+
+		vertices_updated_ = App::runTimer();
+	}
 
 	// Set VBO arrays to use
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_COLOR_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
-	// Setup VBO pointers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
-	glVertexPointer(2, GL_FLOAT, 0, nullptr);
+	// Render visible tiles
+	for (const auto& tile : vertex_tiles_)
+	{
+		if (!tileVisible(tile))
+			continue;
 
-	// Render the VBO
-	glDrawArrays(GL_POINTS, 0, map_->nVertices());
+		glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+		glVertexPointer(2, GL_FLOAT, 0, nullptr);
+		glDrawArrays(GL_POINTS, 0, tile.items.size());
+	}
 
 	// Cleanup state
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -334,32 +408,40 @@ void MapRenderer2D::renderVertexSelection(const ItemSelection& selection, float
 }
 
 // -----------------------------------------------------------------------------
-// Returns the colour for [line]
+// Returns the colour class for [line] (see LineClass)
 // -----------------------------------------------------------------------------
-ColRGBA MapRenderer2D::lineColour(MapLine* line, bool ignore_filter) const
+uint8_t MapRenderer2D::lineClass(const MapLine* line, bool ignore_filter) const
 {
-	ColRGBA col;
+	uint8_t line_class;
 
-	if (line)
-	{
-		// Check for special line
-		if (line->special() > 0)
-			col.set(ColourConfiguration::colour("map_line_special"));
-		else if (line->s1())
-			col.set(ColourConfiguration::colour("map_line_normal"));
-		else
-			col.set(ColourConfiguration::colour("map_line_invalid"));
+	// Check for special line
+	if (line->special() > 0)
+		line_class = LINE_SPECIAL;
+	else if (line->s1())
+		line_class = LINE_NORMAL;
+	else
+		line_class = LINE_INVALID;
 
-		// Check for two-sided line
-		if (line->s2())
-			col.a *= 0.5f;
+	// Check for two-sided line
+	if (line->s2())
+		line_class |= LINE_TWOSIDED;
 
-		// Check if filtered
-		if (line->isFiltered() && !ignore_filter)
-			col.a *= 0.25f;
-	}
+	// Check if filtered
+	if (line->isFiltered() && !ignore_filter)
+		line_class |= LINE_FILTERED;
 
-	return col;
+	return line_class;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the colour for [line]
+// -----------------------------------------------------------------------------
+ColRGBA MapRenderer2D::lineColour(MapLine* line, bool ignore_filter) const
+{
+	if (line)
+		return lineClassColour(lineClass(line, ignore_filter));
+
+	return {};
 }
 
 // -----------------------------------------------------------------------------
@@ -453,7 +535,8 @@ void MapRenderer2D::renderLinesImmediate(bool show_direction, float alpha)
 }
 
 // -----------------------------------------------------------------------------
-// Renders map lines using an OpenGL Vertex Buffer Object
+// Renders map lines using OpenGL Vertex Buffer Objects (one per tile, only
+// tiles within the view are drawn)
 // -----------------------------------------------------------------------------
 void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 {
@@ -461,11 +544,34 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 	if (map_->nLines() == 0)
 		return;
 
-	// Update lines VBO if required
-	if (vbo_lines_ == 0 || show_direction != lines_dirs_ || map_->nLines() != n_lines_
-		|| map_->geometryUpdated() > lines_updated_
-		|| map_->mapData().modifiedSince(lines_updated_, MapObject::Type::Line))
+	// Rebuild line tiles if needed (including when lines were added, removed or
+	// reordered, since tiles hold line indices), otherwise just update tiles
+	// with modified lines (or lines with moved vertices)
+	if (line_tiles_.empty() || show_direction != lines_dirs_ || map_->lines().structureVersion() != line_tiles_version_)
 		updateLinesVBO(show_direction, alpha);
+	else if (
+		map_->geometryUpdated() > lines_updated_
+		|| map_->mapData().modifiedSince(lines_updated_, MapObject::Type::Line))
+	{
+		for (unsigned a = 0; a < map_->nLines(); a++)
+		{
+			auto line = map_->line(a);
+			if (line->modifiedTime() > lines_updated_ || line->v1()->modifiedTime() > lines_updated_
+				|| line->v2()->modifiedTime() > lines_updated_)
+				line_tiles_[line_tile_index_[a]].dirty = true;
+		}
+
+		for (auto& tile : line_tiles_)
+			if (tile.dirty)
+				writeLineTile(tile, show_direction);
+
+		lines_updated_ = App::runTimer();
+	}
+
+	// Line alpha (eg. when fading) or line colour configuration changes only
+	// need the line colours updated
+	if (alpha != lines_alpha_ || lineColoursChanged())
+		updateLineColours(alpha);
 
 	// Disable any blending
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -475,17 +581,19 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 	glEnableClientState(GL_COLOR_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
-	// Setup VBO pointers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines_);
-	glVertexPointer(2, GL_FLOAT, 24, nullptr);
-
-	glColorPointer(4, GL_FLOAT, 24, ((char*)nullptr + 8));
+	// Render visible tiles
+	int vpl = show_direction ? 4 : 2;
+	for (const auto& tile : line_tiles_)
+	{
+		if (!tileVisible(tile))
+			continue;
 
-	// Render the VBO
-	if (show_direction)
-		glDrawArrays(GL_LINES, 0, map_->nLines() * 4);
-	else
-		glDrawArrays(GL_LINES, 0, map_->nLines() * 2);
+		glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+		glVertexPointer(2, GL_FLOAT, 0, nullptr);
+		glBindBuffer(GL_ARRAY_BUFFER, tile.vbo_colour);
+		glColorPointer(4, GL_FLOAT, 0, nullptr);
+		glDrawArrays(GL_LINES, 0, tile.items.size() * vpl);
+	}
 
 	// Clean state
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -777,22 +885,14 @@ void MapRenderer2D::renderThingOverlay(double x, double y, double radius, bool p
 }
 
 // -----------------------------------------------------------------------------
-// Renders a round thing icon at [x,y]
+// Returns the editor image texture to use for a round thing icon of [type]
+// facing [angle]. [rotate] is set to true if the icon should be rotated to the
+// angle
 // -----------------------------------------------------------------------------
-void MapRenderer2D::renderRoundThing(
-	double                 x,
-	double                 y,
-	double                 angle,
-	const Game::ThingType& type,
-	float                  alpha,
-	double                 radius_mult) const
+unsigned MapRenderer2D::roundThingIcon(const Game::ThingType& type, double angle, bool& rotate) const
 {
-	// --- Determine texture to use ---
-	unsigned tex    = 0;
-	bool     rotate = false;
-
-	// Set colour
-	glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
+	unsigned tex = 0;
+	rotate       = false;
 
 	// Check for custom thing icon
 	if (!type.icon().empty() && !thing_force_dir && !things_angles_)
@@ -818,6 +918,101 @@ void MapRenderer2D::renderRoundThing(
 			tex = MapEditor::textureManager().editorImage("thing/normal_n").gl_id;
 	}
 
+	return tex;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the editor image texture to use for a square thing icon of [type]
+// facing [angle]. [tc_start] is set to the index in sq_thing_tc to start from
+// for the icon's texture coordinates
+// -----------------------------------------------------------------------------
+unsigned MapRenderer2D::squareThingIcon(
+	const Game::ThingType& type,
+	double                 angle,
+	bool                   showicon,
+	bool                   framed,
+	int&                   tc_start) const
+{
+	unsigned tex = 0;
+	tc_start     = 0;
+
+	// Check for custom thing icon
+	if (!type.icon().empty() && showicon && !thing_force_dir && !things_angles_ && !framed)
+		tex = MapEditor::textureManager().editorImage(fmt::format("thing/square/{}", type.icon())).gl_id;
+
+	// Otherwise, no icon
+	if (!tex)
+	{
+		if (framed)
+		{
+			tex = MapEditor::textureManager().editorImage("thing/square/frame").gl_id;
+		}
+		else
+		{
+			tex = MapEditor::textureManager().editorImage("thing/square/normal_n").gl_id;
+
+			if ((type.angled() && showicon) || thing_force_dir || things_angles_)
+			{
+				tex = MapEditor::textureManager().editorImage("thing/square/normal_d1").gl_id;
+
+				// Setup variables depending on angle
+				switch ((int)angle)
+				{
+				case 0: // East: normal, texcoord 0
+					break;
+				case 45: // Northeast: diagonal, texcoord 0
+					tex = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
+					break;
+				case 90: // North: normal, texcoord 2
+					tc_start = 2;
+					break;
+				case 135: // Northwest: diagonal, texcoord 2
+					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
+					tc_start = 2;
+					break;
+				case 180: // West: normal, texcoord 4
+					tc_start = 4;
+					break;
+				case 225: // Southwest: diagonal, texcoord 4
+					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
+					tc_start = 4;
+					break;
+				case 270: // South: normal, texcoord 6
+					tc_start = 6;
+					break;
+				case 315: // Southeast: diagonal, texcoord 6
+					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
+					tc_start = 6;
+					break;
+				default: // Unsupported angle, don't draw arrow
+					tex = MapEditor::textureManager().editorImage("thing/square/normal_n").gl_id;
+					break;
+				};
+			}
+		}
+	}
+
+	return tex;
+}
+
+// -----------------------------------------------------------------------------
+// Renders a round thing icon at [x,y]
+// -----------------------------------------------------------------------------
+void MapRenderer2D::renderRoundThing(
+	double                 x,
+	double                 y,
+	double                 angle,
+	const Game::ThingType& type,
+	float                  alpha,
+	double                 radius_mult) const
+{
+	// --- Determine texture to use ---
+	bool rotate = false;
+	auto tex    = roundThingIcon(type, angle, rotate);
+
+	// Set colour
+	glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
+
 	// If for whatever reason the thing texture doesn't exist, just draw a basic, square thing
 	if (!tex)
 	{
@@ -885,7 +1080,7 @@ bool MapRenderer2D::renderSpriteThing(
 	// Attempt to get sprite texture
 	if (!tex)
 	{
-		tex = MapEditor::textureManager().sprite(type.sprite(), type.translation(), type.palette()).gl_id;
+		tex = MapEditor::textureManager().sprite(type.sprite(), type.translation(), type.palette(), true).gl_id;
 
 		if (index < thing_sprites_.size())
 		{
@@ -894,9 +1089,11 @@ bool MapRenderer2D::renderSpriteThing(
 		}
 	}
 
-	// If sprite not found, just draw as a normal, round thing
+	// If sprite not found, just draw as a normal, round thing (after any
+	// batched sprites, to keep the draw order)
 	if (!tex)
 	{
+		renderSpriteBatch();
 		if (thing_drawtype == ThingDrawType::FramedSprite)
 			renderRoundThing(x, y, angle, type, alpha, 0.7);
 		else
@@ -908,8 +1105,49 @@ bool MapRenderer2D::renderSpriteThing(
 	if (type.angled() || thing_force_dir || things_angles_)
 		show_angle = true;
 
-	// Bind texture
-	OpenGL::Texture::bind(tex, false);
+	// If batching, use the sprite's region in the atlas if it's there
+	auto  region = batch_sprites_ ? MapEditor::textureManager().spriteAtlasRegion(tex) : nullptr;
+	Vec2f tc_tl  = region ? region->tex_tl : Vec2f{ 0.0f, 0.0f };
+	Vec2f tc_br  = region ? region->tex_br : Vec2f{ 1.0f, 1.0f };
+
+	// Otherwise draw any batched sprites (to keep the draw order) and bind
+	// texture
+	if (!region)
+	{
+		renderSpriteBatch();
+		OpenGL::Texture::bind(tex, false);
+	}
+
+	// Draws a sprite quad from [x1,y1] to [x2,y2], either immediately or by
+	// adding it to the sprite batch (which is drawn first if the quad is on a
+	// different atlas page)
+	auto quad = [&](double x1, double y1, double x2, double y2, float r, float g, float b, float a) {
+		if (region)
+		{
+			if (region->page != sprite_batch_page_)
+			{
+				renderSpriteBatch();
+				sprite_batch_page_ = region->page;
+			}
+			sprite_batch_.push_back({ (float)x1, (float)y1, tc_tl.x, tc_br.y, r, g, b, a });
+			sprite_batch_.push_back({ (float)x1, (float)y2, tc_tl.x, tc_tl.y, r, g, b, a });
+			sprite_batch_.push_back({ (float)x2, (float)y2, tc_br.x, tc_tl.y, r, g, b, a });
+			sprite_batch_.push_back({ (float)x2, (float)y1, tc_br.x, tc_br.y, r, g, b, a });
+			return;
+		}
+
+		glColor4f(r, g, b, a);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0.0f, 1.0f);
+		glVertex2d(x1, y1);
+		glTexCoord2f(0.0f, 0.0f);
+		glVertex2d(x1, y2);
+		glTexCoord2f(1.0f, 0.0f);
+		glVertex2d(x2, y2);
+		glTexCoord2f(1.0f, 1.0f);
+		glVertex2d(x2, y1);
+		glEnd();
+	};
 
 	// Draw thing
 	auto&  tex_info = OpenGL::Texture::info(tex);
@@ -930,40 +1168,12 @@ bool MapRenderer2D::renderSpriteThing(
 		double sz = (min(hw, hh)) * 0.1;
 		if (sz < 1)
 			sz = 1;
-		glColor4f(0.0f, 0.0f, 0.0f, alpha * (thing_shadow * 0.7));
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);
-		glVertex2d(x - hw - sz, y - hh - sz);
-		glTexCoord2f(0.0f, 0.0f);
-		glVertex2d(x - hw - sz, y + hh + sz);
-		glTexCoord2f(1.0f, 0.0f);
-		glVertex2d(x + hw + sz, y + hh + sz);
-		glTexCoord2f(1.0f, 1.0f);
-		glVertex2d(x + hw + sz, y - hh - sz);
-		glEnd();
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0f, 1.0f);
-		glVertex2d(x - hw - sz, y - hh - sz - sz);
-		glTexCoord2f(0.0f, 0.0f);
-		glVertex2d(x - hw - sz, y + hh + sz);
-		glTexCoord2f(1.0f, 0.0f);
-		glVertex2d(x + hw + sz + sz, y + hh + sz);
-		glTexCoord2f(1.0f, 1.0f);
-		glVertex2d(x + hw + sz + sz, y - hh - sz - sz);
-		glEnd();
+		float shadow_alpha = alpha * (thing_shadow * 0.7);
+		quad(x - hw - sz, y - hh - sz, x + hw + sz, y + hh + sz, 0.0f, 0.0f, 0.0f, shadow_alpha);
+		quad(x - hw - sz, y - hh - sz - sz, x + hw + sz + sz, y + hh + sz, 0.0f, 0.0f, 0.0f, shadow_alpha);
 	}
 	// Draw thing
-	glColor4f(1.0f, 1.0f, 1.0f, alpha);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 1.0f);
-	glVertex2d(x - hw, y - hh);
-	glTexCoord2f(0.0f, 0.0f);
-	glVertex2d(x - hw, y + hh);
-	glTexCoord2f(1.0f, 0.0f);
-	glVertex2d(x + hw, y + hh);
-	glTexCoord2f(1.0f, 1.0f);
-	glVertex2d(x + hw, y - hh);
-	glEnd();
+	quad(x - hw, y - hh, x + hw, y + hh, 1.0f, 1.0f, 1.0f, alpha);
 
 
 	return show_angle;
@@ -981,72 +1191,16 @@ bool MapRenderer2D::renderSquareThing(
 	bool                   showicon,
 	bool                   framed) const
 {
-	// --- Determine texture to use ---
-	unsigned tex = 0;
-
-	// Set colour
-	glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
-
 	// Show icon anyway if no sprite set
 	if (type.sprite().empty())
 		showicon = true;
 
-	// Check for custom thing icon
-	if (!type.icon().empty() && showicon && !thing_force_dir && !things_angles_ && !framed)
-		tex = MapEditor::textureManager().editorImage(fmt::format("thing/square/{}", type.icon())).gl_id;
-
-	// Otherwise, no icon
-	int tc_start = 0;
-	if (!tex)
-	{
-		if (framed)
-		{
-			tex = MapEditor::textureManager().editorImage("thing/square/frame").gl_id;
-		}
-		else
-		{
-			tex = MapEditor::textureManager().editorImage("thing/square/normal_n").gl_id;
-
-			if ((type.angled() && showicon) || thing_force_dir || things_angles_)
-			{
-				tex = MapEditor::textureManager().editorImage("thing/square/normal_d1").gl_id;
+	// --- Determine texture to use ---
+	int  tc_start = 0;
+	auto tex      = squareThingIcon(type, angle, showicon, framed, tc_start);
 
-				// Setup variables depending on angle
-				switch ((int)angle)
-				{
-				case 0: // East: normal, texcoord 0
-					break;
-				case 45: // Northeast: diagonal, texcoord 0
-					tex = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
-					break;
-				case 90: // North: normal, texcoord 2
-					tc_start = 2;
-					break;
-				case 135: // Northwest: diagonal, texcoord 2
-					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
-					tc_start = 2;
-					break;
-				case 180: // West: normal, texcoord 4
-					tc_start = 4;
-					break;
-				case 225: // Southwest: diagonal, texcoord 4
-					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
-					tc_start = 4;
-					break;
-				case 270: // South: normal, texcoord 6
-					tc_start = 6;
-					break;
-				case 315: // Southeast: diagonal, texcoord 6
-					tex      = MapEditor::textureManager().editorImage("thing/square/normal_d2").gl_id;
-					tc_start = 6;
-					break;
-				default: // Unsupported angle, don't draw arrow
-					tex = MapEditor::textureManager().editorImage("thing/square/normal_n").gl_id;
-					break;
-				};
-			}
-		}
-	}
+	// Set colour
+	glColor4f(type.colour().fr(), type.colour().fg(), type.colour().fb(), alpha);
 
 	// If for whatever reason the thing texture doesn't exist, just draw a basic, square thing
 	if (!tex)
@@ -1146,7 +1300,13 @@ void MapRenderer2D::renderThings(float alpha, bool force_dir)
 		return;
 
 	things_angles_ = force_dir;
-	renderThingsImmediate(alpha);
+
+	// Sprites are loaded gradually and batched each frame, so are always drawn
+	// immediately
+	if (OpenGL::vboSupport() && things_use_vbo && thing_drawtype != ThingDrawType::Sprite)
+		renderThingsVBO(alpha);
+	else
+		renderThingsImmediate(alpha);
 }
 
 // -----------------------------------------------------------------------------
@@ -1243,8 +1403,9 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 		}
 	}
 
-	// Draw things
+	// Draw things (consecutive sprites in the atlas are batched)
 	double talpha;
+	batch_sprites_ = true;
 	for (unsigned a = 0; a < map_->nThings(); a++)
 	{
 		if (vis_t_[a] > 0)
@@ -1294,84 +1455,237 @@ void MapRenderer2D::renderThingsImmediate(float alpha)
 
 	// Draw thing sprites within squares if that drawtype is set
 	if (thing_drawtype > ThingDrawType::Sprite)
+		renderSquareThingSprites(alpha);
+
+	// Draw batched sprites
+	batch_sprites_ = false;
+	renderSpriteBatch();
+
+	// Draw any thing direction arrows needed
+	if (!things_arrows.empty())
+	{
+		auto acol = ColRGBA::WHITE;
+		acol.a    = 255 * alpha * arrow_alpha;
+		OpenGL::setColour(acol);
+		// glColor4f(1.0f, 1.0f, 1.0f, alpha * arrow_alpha);
+		auto tex_arrow = MapEditor::textureManager().editorImage("arrow").gl_id;
+		if (tex_arrow)
+		{
+			glEnable(GL_TEXTURE_2D);
+			OpenGL::Texture::bind(tex_arrow);
+
+			for (int things_arrow : things_arrows)
+			{
+				thing = map_->thing(things_arrow);
+				if (arrow_colour)
+				{
+					auto& tt = Game::configuration().thingType(thing->type());
+					if (tt.defined())
+					{
+						acol.set(tt.colour());
+						acol.a = 255 * alpha * arrow_alpha;
+						OpenGL::setColour(acol);
+					}
+				}
+				x = thing->xPos();
+				y = thing->yPos();
+
+				glPushMatrix();
+				glTranslated(x, y, 0);
+				glRotated(thing->angle(), 0, 0, 1);
+
+				glBegin(GL_QUADS);
+				glTexCoord2f(0.0f, 1.0f);
+				glVertex2d(-32, -32);
+				glTexCoord2f(0.0f, 0.0f);
+				glVertex2d(-32, 32);
+				glTexCoord2f(1.0f, 0.0f);
+				glVertex2d(32, 32);
+				glTexCoord2f(1.0f, 1.0f);
+				glVertex2d(32, -32);
+				glEnd();
+
+				glPopMatrix();
+			}
+		}
+	}
+
+	// Disable textures
+	glDisable(GL_TEXTURE_2D);
+}
+
+// -----------------------------------------------------------------------------
+// Renders map things using an OpenGL Vertex Buffer Object. All thing icons,
+// shadows and direction arrows are written to the VBO (by updateThingsVBO)
+// and drawn with one call per icon texture, the VBO is only updated when
+// things or their display settings change
+// -----------------------------------------------------------------------------
+void MapRenderer2D::renderThingsVBO(float alpha)
+{
+	if (!glGenBuffers)
+		return;
+
+	// Check if the VBO needs updating (display settings changed)
+	ThingsVBOState state;
+	state.alpha        = alpha;
+	state.drawtype     = thing_drawtype;
+	state.angles       = things_angles_;
+	state.shadow       = thing_shadow;
+	state.arrow_alpha  = arrow_alpha;
+	state.arrow_colour = arrow_colour;
+	state.zeth_icons   = use_zeth_icons;
+	bool update        = vbo_things_ == 0 || n_things_ != map_->nThings() || !(state == things_vbo_state_);
+	if (things_vbo_scaled_ && view_scale_ != things_vbo_scale_)
+		update = true;
+
+	// Check if the VBO needs updating (things changed)
+	long last_update = thing_sprites_updated_;
+	for (unsigned a = 0; a < map_->nThings(); a++)
+	{
+		auto thing = map_->thing(a);
+
+		// Reset thing sprite if modified
+		if (thing->modifiedTime() > last_update && thing_sprites_.size() > a)
+			thing_sprites_[a] = 0;
+
+		if (!update
+			&& (thing->modifiedTime() >= things_updated_ || thing->isFiltered() != (things_vbo_filtered_[a] > 0)))
+			update = true;
+	}
+	if (update)
+	{
+		things_vbo_state_ = state;
+		updateThingsVBO(alpha);
+	}
+
+	// Setup opengl state
+	glEnable(GL_TEXTURE_2D);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_things_);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, x)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, tx)));
+	glColorPointer(4, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, r)));
+
+	// Draw shadows and icons
+	for (const auto& range : things_vbo_ranges_)
+	{
+		OpenGL::Texture::bind(range.texture, false);
+		glDrawArrays(GL_QUADS, range.first, range.count);
+	}
+
+	// Clean up opengl state
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Draw things without an icon texture
+	glDisable(GL_TEXTURE_2D);
+	for (auto index : things_simple_)
+	{
+		if (vis_t_[index] > 0)
+			continue;
+
+		auto thing  = map_->thing(index);
+		auto talpha = thing->isFiltered() ? alpha * 0.25f : alpha;
+		renderSimpleSquareThing(
+			thing->xPos(), thing->yPos(), thing->angle(), Game::configuration().thingType(thing->type()), talpha);
+	}
+
+	// Draw thing sprites within squares if that drawtype is set
+	if (thing_drawtype > ThingDrawType::Sprite)
+	{
+		batch_sprites_ = true;
+		renderSquareThingSprites(alpha);
+		batch_sprites_ = false;
+		renderSpriteBatch();
+	}
+
+	// Draw direction arrows (after sprites so they aren't covered)
+	if (things_vbo_arrows_.count > 0)
 	{
 		glEnable(GL_TEXTURE_2D);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo_things_);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glVertexPointer(2, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, x)));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, tx)));
+		glColorPointer(4, GL_FLOAT, sizeof(GLSpriteVert), ((char*)nullptr + offsetof(GLSpriteVert, r)));
 
-		for (unsigned a = 0; a < map_->nThings(); a++)
-		{
-			if (vis_t_[a] > 0)
-				continue;
-
-			// Get thing info
-			thing    = map_->thing(a);
-			auto& tt = Game::configuration().thingType(thing->type());
-			x        = thing->xPos();
-			y        = thing->yPos();
+		OpenGL::Texture::bind(things_vbo_arrows_.texture, false);
+		glDrawArrays(GL_QUADS, things_vbo_arrows_.first, things_vbo_arrows_.count);
 
-			if (thing_drawtype == ThingDrawType::SquareSprite && tt.sprite().empty())
-				continue;
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisableClientState(GL_COLOR_ARRAY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 
-			// Set alpha
-			if (thing->isFiltered())
-				talpha = alpha * 0.25;
-			else
-				talpha = alpha;
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glDisable(GL_TEXTURE_2D);
+}
 
-			renderSpriteThing(x, y, thing->angle(), tt, a, talpha, true);
-		}
-	}
+// -----------------------------------------------------------------------------
+// Renders thing sprites within their squares (for the 'square + sprite' and
+// 'framed sprite' thing draw types)
+// -----------------------------------------------------------------------------
+void MapRenderer2D::renderSquareThingSprites(float alpha)
+{
+	glEnable(GL_TEXTURE_2D);
 
-	// Draw any thing direction arrows needed
-	if (!things_arrows.empty())
+	for (unsigned a = 0; a < map_->nThings(); a++)
 	{
-		auto acol = ColRGBA::WHITE;
-		acol.a    = 255 * alpha * arrow_alpha;
-		OpenGL::setColour(acol);
-		// glColor4f(1.0f, 1.0f, 1.0f, alpha * arrow_alpha);
-		auto tex_arrow = MapEditor::textureManager().editorImage("arrow").gl_id;
-		if (tex_arrow)
-		{
-			glEnable(GL_TEXTURE_2D);
-			OpenGL::Texture::bind(tex_arrow);
+		if (vis_t_[a] > 0)
+			continue;
 
-			for (int things_arrow : things_arrows)
-			{
-				thing = map_->thing(things_arrow);
-				if (arrow_colour)
-				{
-					auto& tt = Game::configuration().thingType(thing->type());
-					if (tt.defined())
-					{
-						acol.set(tt.colour());
-						acol.a = 255 * alpha * arrow_alpha;
-						OpenGL::setColour(acol);
-					}
-				}
-				x = thing->xPos();
-				y = thing->yPos();
+		// Get thing info
+		auto  thing = map_->thing(a);
+		auto& tt    = Game::configuration().thingType(thing->type());
 
-				glPushMatrix();
-				glTranslated(x, y, 0);
-				glRotated(thing->angle(), 0, 0, 1);
+		if (thing_drawtype == ThingDrawType::SquareSprite && tt.sprite().empty())
+			continue;
 
-				glBegin(GL_QUADS);
-				glTexCoord2f(0.0f, 1.0f);
-				glVertex2d(-32, -32);
-				glTexCoord2f(0.0f, 0.0f);
-				glVertex2d(-32, 32);
-				glTexCoord2f(1.0f, 0.0f);
-				glVertex2d(32, 32);
-				glTexCoord2f(1.0f, 1.0f);
-				glVertex2d(32, -32);
-				glEnd();
+		// Set alpha
+		float talpha = thing->isFiltered() ? alpha * 0.25f : alpha;
 
-				glPopMatrix();
-			}
-		}
+		renderSpriteThing(thing->xPos(), thing->yPos(), thing->angle(), tt, a, talpha, true);
 	}
+}
 
-	// Disable textures
-	glDisable(GL_TEXTURE_2D);
+// -----------------------------------------------------------------------------
+// Renders all sprite quads added to the sprite batch (by renderSpriteThing)
+// in one draw call, then clears the batch. The batch only holds consecutive
+// quads on the same atlas page, and is drawn early whenever a sprite that
+// can't be batched is drawn, so sprites are drawn in the same order as without
+// batching
+// -----------------------------------------------------------------------------
+void MapRenderer2D::renderSpriteBatch()
+{
+	if (sprite_batch_.empty())
+		return;
+
+	glEnable(GL_TEXTURE_2D);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	OpenGL::Texture::bind(sprite_batch_page_, false);
+	glVertexPointer(2, GL_FLOAT, sizeof(GLSpriteVert), &sprite_batch_[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(GLSpriteVert), &sprite_batch_[0].tx);
+	glColorPointer(4, GL_FLOAT, sizeof(GLSpriteVert), &sprite_batch_[0].r);
+	glDrawArrays(GL_QUADS, 0, sprite_batch_.size());
+
+	// Keep the vector allocated for next time
+	sprite_batch_.clear();
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 }
 
 // -----------------------------------------------------------------------------
@@ -1874,9 +2188,9 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 				// Get the sector texture
 				bool mix_tex_flats = Game::configuration().featureSupported(Feature::MixTexFlats);
 				if (type <= 1)
-					map_tex_props = &MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats);
+					map_tex_props = &MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats, true);
 				else
-					map_tex_props = &MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats);
+					map_tex_props = &MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats, true);
 
 				tex           = map_tex_props->gl_id;
 				tex_flats_[a] = tex;
@@ -2020,11 +2334,11 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 	// Setup VBO pointers
 	Polygon2D::setupVBOPointers();
 
-	// Go through sectors
-	unsigned tex_last = 0;
-	unsigned tex      = 0;
-	bool     first    = true;
-	unsigned update   = 0;
+	// Go through sectors, updating texture info and VBO data if needed and
+	// building the list of visible sectors to draw
+	unsigned tex    = 0;
+	unsigned update = 0;
+	flat_draw_list_.clear();
 	for (unsigned a = 0; a < map_->nSectors(); a++)
 	{
 		auto sector = map_->sector(a);
@@ -2033,7 +2347,6 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		if (vis_s_[a] > 0)
 			continue;
 
-		first                                           = false;
 		const MapTextureManager::Texture* map_tex_props = nullptr;
 		if (texture)
 		{
@@ -2042,9 +2355,9 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 				// Get the sector texture
 				bool mix_tex_flats = Game::configuration().featureSupported(Feature::MixTexFlats);
 				if (type <= 1)
-					map_tex_props = &MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats);
+					map_tex_props = &MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats, true);
 				else
-					map_tex_props = &MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats);
+					map_tex_props = &MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats, true);
 
 				tex           = map_tex_props->gl_id;
 				tex_flats_[a] = tex;
@@ -2118,26 +2431,44 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 				break;
 		}
 
+		flat_draw_list_.emplace_back(texture ? tex : 0, a);
+	}
+
+	// Sort sectors by texture, so each texture only needs to be bound once
+	if (texture)
+		std::stable_sort(flat_draw_list_.begin(), flat_draw_list_.end(), [](const auto& left, const auto& right) {
+			return left.first < right.first;
+		});
+
+	// Render sectors
+	unsigned tex_last = 0;
+	bool     first    = true;
+	for (const auto& [sector_tex, index] : flat_draw_list_)
+	{
 		// Bind the texture if needed
-		if (tex)
+		if (first || sector_tex != tex_last)
 		{
-			if (!tex_last || first)
+			if (sector_tex)
+			{
 				glEnable(GL_TEXTURE_2D);
-			if (tex != tex_last)
-				OpenGL::Texture::bind(tex);
+				OpenGL::Texture::bind(sector_tex);
+			}
+			else
+				glDisable(GL_TEXTURE_2D);
+
+			tex_last = sector_tex;
+			first    = false;
 		}
-		else if (!tex_last || first)
-			glDisable(GL_TEXTURE_2D);
-		tex_last = tex;
 
 		// Render the polygon
+		auto sector = map_->sector(index);
 		if (!flat_ignore_light)
 		{
 			auto col = sector->colourAt(type);
 			col.ampf(flat_brightness, flat_brightness, flat_brightness, 1.0f);
 			glColor4f(col.fr(), col.fg(), col.fb(), alpha);
 		}
-		poly->renderVBO(false);
+		sector->polygon()->renderVBO(false);
 	}
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -2868,43 +3199,192 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the map vertices VBO
+// (Re)builds the map vertices VBO tiles
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateVerticesVBO()
+{
+	// Split vertices into tiles
+	buildVBOTiles(vertex_tiles_, vertex_tile_index_, map_->nVertices(), [this](unsigned index) {
+		return map_->vertex(index)->position();
+	});
+
+	// Fill tile VBOs
+	for (auto& tile : vertex_tiles_)
+		writeVertexTile(tile);
+
+	n_vertices_           = map_->nVertices();
+	vertex_tiles_version_ = map_->vertices().structureVersion();
+	vertices_updated_     = App::runTimer();
+}
+
+// -----------------------------------------------------------------------------
+// (Re)builds the map lines VBO tiles
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
+{
+	Log::info(3, "Updating lines VBO");
+
+	// Update line colours
+	lines_alpha_ = base_alpha;
+	for (unsigned a = 0; a < LINE_CLASS_COUNT; a++)
+		line_class_colours_[a] = lineClassColour(a);
+
+	// Split lines into tiles (by midpoint)
+	buildVBOTiles(line_tiles_, line_tile_index_, map_->nLines(), [this](unsigned index) {
+		return map_->line(index)->getPoint(MapObject::Point::Mid);
+	});
+
+	// Fill tile VBOs
+	for (auto& tile : line_tiles_)
+		writeLineTile(tile, show_direction);
+
+	n_lines_            = map_->nLines();
+	line_tiles_version_ = map_->lines().structureVersion();
+	lines_dirs_         = show_direction;
+	lines_updated_      = App::runTimer();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if any of the configured line colours are different to those
+// the lines VBO tiles were last coloured with
+// -----------------------------------------------------------------------------
+bool MapRenderer2D::lineColoursChanged() const
+{
+	// Only the base classes need checking, the rest are derived from them
+	for (uint8_t a = 0; a <= LINE_BASE_MASK; a++)
+		if (!lineClassColour(a).equals(line_class_colours_[a], true))
+			return true;
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the colours of all lines in the lines VBO tiles, without rebuilding
+// line geometry. Only tiles with lines that changed colour class (eg. from
+// filtering) are rewritten, unless the line colours or [base_alpha] changed
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateLineColours(float base_alpha)
+{
+	// Update line colour table
+	bool changed = base_alpha != lines_alpha_;
+	for (unsigned a = 0; a < LINE_CLASS_COUNT; a++)
+	{
+		auto col = lineClassColour(a);
+		if (!col.equals(line_class_colours_[a], true))
+		{
+			line_class_colours_[a] = col;
+			changed                = true;
+		}
+	}
+	lines_alpha_ = base_alpha;
+
+	// Rewrite colours for tiles where needed
+	for (auto& tile : line_tiles_)
+	{
+		bool update = changed;
+		for (unsigned a = 0; a < tile.items.size(); a++)
+		{
+			auto line_class = lineClass(map_->line(tile.items[a]));
+			if (tile.classes[a] != line_class)
+			{
+				tile.classes[a] = line_class;
+				update          = true;
+			}
+		}
+
+		if (update)
+			writeLineTileColours(tile, lines_dirs_);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Splits [count] objects into square [tiles] of VBO_TILE_SIZE, by the
+// position of each given by [position]. The tile each object is put in is
+// written to [tile_index].
+// Objects stay in the same tile until the tiles are rebuilt, even if they
+// move, since each tile's bounds are updated when it is written
+// -----------------------------------------------------------------------------
+void MapRenderer2D::buildVBOTiles(
+	vector<VBOTile>&                      tiles,
+	vector<unsigned>&                     tile_index,
+	unsigned                              count,
+	const std::function<Vec2d(unsigned)>& position) const
+{
+	clearVBOTiles(tiles);
+	tile_index.resize(count);
+
+	std::map<std::pair<int, int>, unsigned> tile_map;
+	for (unsigned a = 0; a < count; a++)
+	{
+		auto pos = position(a);
+		auto key = std::make_pair((int)floor(pos.x / VBO_TILE_SIZE), (int)floor(pos.y / VBO_TILE_SIZE));
+
+		auto i = tile_map.find(key);
+		if (i == tile_map.end())
+		{
+			i = tile_map.emplace(key, tiles.size()).first;
+			tiles.emplace_back();
+		}
+
+		tiles[i->second].items.push_back(a);
+		tile_index[a] = i->second;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Deletes all [tiles] and their VBOs
+// -----------------------------------------------------------------------------
+void MapRenderer2D::clearVBOTiles(vector<VBOTile>& tiles) const
+{
+	for (auto& tile : tiles)
+	{
+		if (tile.vbo > 0)
+			glDeleteBuffers(1, &tile.vbo);
+		if (tile.vbo_colour > 0)
+			glDeleteBuffers(1, &tile.vbo_colour);
+	}
+
+	tiles.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Writes the vertices in [tile] to its VBO, and updates its bounds
+// -----------------------------------------------------------------------------
+void MapRenderer2D::writeVertexTile(VBOTile& tile) const
 {
 	// Create VBO if needed
-	if (vbo_vertices_ == 0)
-		glGenBuffers(1, &vbo_vertices_);
+	if (tile.vbo == 0)
+		glGenBuffers(1, &tile.vbo);
 
 	// Fill vertices VBO
-	int             nfloats = map_->nVertices() * 2;
-	vector<GLfloat> verts(nfloats);
+	vector<GLfloat> verts(tile.items.size() * 2);
 	unsigned        i = 0;
-	for (unsigned a = 0; a < map_->nVertices(); a++)
+	tile.resetBounds();
+	for (auto index : tile.items)
 	{
-		verts[i++] = map_->vertex(a)->xPos();
-		verts[i++] = map_->vertex(a)->yPos();
+		auto vertex = map_->vertex(index);
+		verts[i++]  = vertex->xPos();
+		verts[i++]  = vertex->yPos();
+		tile.extend(vertex->xPos(), vertex->yPos());
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * nfloats, verts.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * verts.size(), verts.data(), GL_STATIC_DRAW);
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	n_vertices_       = map_->nVertices();
-	vertices_updated_ = App::runTimer();
+	tile.dirty = false;
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the map lines VBO
+// Writes the lines in [tile] to its VBOs (with direction tabs if
+// [show_direction] is true), and updates its bounds
 // -----------------------------------------------------------------------------
-void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
+void MapRenderer2D::writeLineTile(VBOTile& tile, bool show_direction) const
 {
-	Log::info(3, "Updating lines VBO");
-
 	// Create VBO if needed
-	if (vbo_lines_ == 0)
-		glGenBuffers(1, &vbo_lines_);
+	if (tile.vbo == 0)
+		glGenBuffers(1, &tile.vbo);
 
 	// Determine the number of vertices per line
 	int vpl = 2;
@@ -2912,59 +3392,98 @@ void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 		vpl = 4;
 
 	// Fill lines VBO
-	int            nverts = map_->nLines() * vpl;
-	vector<GLVert> lines(nverts);
-	unsigned       v = 0;
-	ColRGBA        col;
-	float          alpha;
-	for (unsigned a = 0; a < map_->nLines(); a++)
+	vector<GLfloat> verts(tile.items.size() * vpl * 2);
+	unsigned        i = 0;
+	tile.classes.resize(tile.items.size());
+	tile.resetBounds();
+	for (unsigned a = 0; a < tile.items.size(); a++)
 	{
-		auto line = map_->line(a);
-
-		// Get line colour
-		col   = lineColour(line);
-		alpha = base_alpha * col.fa();
+		auto line = map_->line(tile.items[a]);
 
 		// Set line vertices
-		lines[v].x     = line->v1()->xPos();
-		lines[v].y     = line->v1()->yPos();
-		lines[v + 1].x = line->v2()->xPos();
-		lines[v + 1].y = line->v2()->yPos();
-
-		// Set line colour(s)
-		lines[v].r = lines[v + 1].r = col.fr();
-		lines[v].g = lines[v + 1].g = col.fg();
-		lines[v].b = lines[v + 1].b = col.fb();
-		lines[v].a = lines[v + 1].a = alpha;
+		verts[i++] = line->v1()->xPos();
+		verts[i++] = line->v1()->yPos();
+		verts[i++] = line->v2()->xPos();
+		verts[i++] = line->v2()->yPos();
+		tile.extend(line->v1()->xPos(), line->v1()->yPos());
+		tile.extend(line->v2()->xPos(), line->v2()->yPos());
 
 		// Direction tab if needed
 		if (show_direction)
 		{
-			auto mid       = line->getPoint(MapObject::Point::Mid);
-			auto tab       = line->dirTabPoint();
-			lines[v + 2].x = mid.x;
-			lines[v + 2].y = mid.y;
-			lines[v + 3].x = tab.x;
-			lines[v + 3].y = tab.y;
-
-			// Colours
-			lines[v + 2].r = lines[v + 3].r = col.fr();
-			lines[v + 2].g = lines[v + 3].g = col.fg();
-			lines[v + 2].b = lines[v + 3].b = col.fb();
-			lines[v + 2].a = lines[v + 3].a = alpha * 0.6f;
+			auto mid   = line->getPoint(MapObject::Point::Mid);
+			auto tab   = line->dirTabPoint();
+			verts[i++] = mid.x;
+			verts[i++] = mid.y;
+			verts[i++] = tab.x;
+			verts[i++] = tab.y;
+			tile.extend(tab.x, tab.y);
 		}
 
-		// Next line
-		v += vpl;
+		// Colour class
+		tile.classes[a] = lineClass(line);
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines_);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLVert) * nverts, lines.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * verts.size(), verts.data(), GL_STATIC_DRAW);
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	n_lines_       = map_->nLines();
-	lines_updated_ = App::runTimer();
+	// Colours
+	writeLineTileColours(tile, show_direction);
+
+	tile.dirty = false;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the colours for the lines in [tile] to its colour VBO, from each
+// line's colour class and the current line colour table
+// -----------------------------------------------------------------------------
+void MapRenderer2D::writeLineTileColours(VBOTile& tile, bool show_direction) const
+{
+	// Create VBO if needed
+	if (tile.vbo_colour == 0)
+		glGenBuffers(1, &tile.vbo_colour);
+
+	// Determine the number of vertices per line
+	int vpl = 2;
+	if (show_direction)
+		vpl = 4;
+
+	// Fill colours VBO
+	vector<GLfloat> colours(tile.items.size() * vpl * 4);
+	unsigned        i = 0;
+	for (auto line_class : tile.classes)
+	{
+		const auto& col   = line_class_colours_[line_class];
+		float       alpha = lines_alpha_ * col.fa();
+
+		for (int v = 0; v < vpl; v++)
+		{
+			colours[i++] = col.fr();
+			colours[i++] = col.fg();
+			colours[i++] = col.fb();
+			colours[i++] = v < 2 ? alpha : alpha * 0.6f; // Direction tab is fainter
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, tile.vbo_colour);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * colours.size(), colours.data(), GL_STATIC_DRAW);
+
+	// Clean up
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [tile] is (at least partially) within the current view.
+// Tile bounds are padded a little so vertex points and line widths at the
+// edges aren't cut off
+// -----------------------------------------------------------------------------
+bool MapRenderer2D::tileVisible(const VBOTile& tile) const
+{
+	double pad = view_scale_ > 0 ? 16. / view_scale_ : 0.;
+	return !(
+		tile.max.x + pad < view_tl_.x || tile.min.x - pad > view_br_.x || tile.max.y + pad < view_tl_.y
+		|| tile.min.y - pad > view_br_.y);
 }
 
 // -----------------------------------------------------------------------------
@@ -3007,11 +3526,155 @@ void MapRenderer2D::updateFlatsVBO()
 	flats_updated_ = App::runTimer();
 }
 
+// -----------------------------------------------------------------------------
+// (Re)builds the map things VBO with icon, shadow and direction arrow quads for
+// all things, grouped by texture
+// -----------------------------------------------------------------------------
+void MapRenderer2D::updateThingsVBO(float alpha)
+{
+	// Create VBO if needed
+	if (vbo_things_ == 0)
+		glGenBuffers(1, &vbo_things_);
+
+	// Get editor image textures
+	unsigned tex_shadow = 0;
+	if (thing_shadow > 0.01f)
+	{
+		if (thing_drawtype == ThingDrawType::Round)
+			tex_shadow = MapEditor::textureManager().editorImage("thing/shadow").gl_id;
+		else
+			tex_shadow = MapEditor::textureManager().editorImage("thing/square/shadow").gl_id;
+	}
+	auto tex_arrow = MapEditor::textureManager().editorImage("arrow").gl_id;
+
+	// Adds a quad of [radius] at [x,y] rotated by [angle] to [verts]
+	auto add_quad = [](vector<GLSpriteVert>& verts,
+					   double                x,
+					   double                y,
+					   double                radius,
+					   double                angle,
+					   int                   tc_start,
+					   const ColRGBA&        colour,
+					   float                 alpha) {
+		static const double corners[] = { -1., -1., -1., 1., 1., 1., 1., -1. };
+		double              rad       = MathStuff::degToRad(angle);
+		double              cos_a     = cos(rad);
+		double              sin_a     = sin(rad);
+		for (int c = 0; c < 8; c += 2)
+		{
+			double cx = corners[c] * radius;
+			double cy = corners[c + 1] * radius;
+			int    tc = (tc_start + c) % 8;
+			verts.push_back({ (float)(x + cx * cos_a - cy * sin_a),
+							  (float)(y + cx * sin_a + cy * cos_a),
+							  sq_thing_tc[tc],
+							  sq_thing_tc[tc + 1],
+							  colour.fr(),
+							  colour.fg(),
+							  colour.fb(),
+							  alpha });
+		}
+	};
+
+	// Build quads
+	vector<GLSpriteVert>                     shadows;
+	vector<GLSpriteVert>                     arrows;
+	std::map<unsigned, vector<GLSpriteVert>> icons;
+	things_simple_.clear();
+	things_vbo_filtered_.assign(map_->nThings(), 0);
+	things_vbo_scaled_ = false;
+	for (unsigned a = 0; a < map_->nThings(); a++)
+	{
+		auto   thing  = map_->thing(a);
+		auto&  tt     = Game::configuration().thingType(thing->type());
+		double x      = thing->xPos();
+		double y      = thing->yPos();
+		double angle  = thing->angle();
+		float  talpha = thing->isFiltered() ? alpha * 0.25f : alpha;
+		things_vbo_filtered_[a] = thing->isFiltered() ? 1 : 0;
+		if (tt.shrinkOnZoom())
+			things_vbo_scaled_ = true;
+
+		// Shadow
+		if (tex_shadow && !thing->isFiltered())
+		{
+			double radius = (tt.radius() + 1);
+			if (tt.shrinkOnZoom())
+				radius = scaledRadius(radius);
+			add_quad(shadows, x, y, radius * 1.3, 0., 0, ColRGBA::BLACK, alpha * thing_shadow);
+		}
+
+		// Icon
+		double radius = tt.radius();
+		if (tt.shrinkOnZoom())
+			radius = scaledRadius(radius);
+		if (thing_drawtype == ThingDrawType::Round)
+		{
+			bool rotate = false;
+			auto tex    = roundThingIcon(tt, angle, rotate);
+			if (!tex)
+			{
+				things_simple_.push_back(a);
+				continue;
+			}
+
+			add_quad(icons[tex], x, y, radius, rotate ? angle : 0., 0, tt.colour(), talpha);
+		}
+		else
+		{
+			bool showicon = thing_drawtype < ThingDrawType::SquareSprite || tt.sprite().empty();
+			bool framed   = thing_drawtype == ThingDrawType::FramedSprite;
+			int  tc_start = 0;
+			auto tex      = squareThingIcon(tt, angle, showicon, framed, tc_start);
+			if (!tex)
+			{
+				things_simple_.push_back(a);
+				continue;
+			}
+
+			add_quad(icons[tex], x, y, radius, 0., tc_start, tt.colour(), talpha);
+
+			// Direction arrow
+			if ((tt.angled() || thing_force_dir || things_angles_) && !showicon && tex_arrow)
+			{
+				auto acol = arrow_colour && tt.defined() ? tt.colour() : ColRGBA::WHITE;
+				add_quad(arrows, x, y, 32., angle, 0, acol, alpha * arrow_alpha);
+			}
+		}
+	}
+
+	// Setup draw ranges (shadows, then icons, then arrows)
+	vector<GLSpriteVert> verts = std::move(shadows);
+	things_vbo_ranges_.clear();
+	if (!verts.empty())
+		things_vbo_ranges_.push_back({ tex_shadow, 0, (unsigned)verts.size() });
+	for (auto& [tex, icon_verts] : icons)
+	{
+		things_vbo_ranges_.push_back({ tex, (unsigned)verts.size(), (unsigned)icon_verts.size() });
+		verts.insert(verts.end(), icon_verts.begin(), icon_verts.end());
+	}
+	things_vbo_arrows_ = { tex_arrow, (unsigned)verts.size(), (unsigned)arrows.size() };
+	verts.insert(verts.end(), arrows.begin(), arrows.end());
+
+	// Upload
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_things_);
+	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLSpriteVert), verts.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	n_things_         = map_->nThings();
+	things_vbo_scale_ = view_scale_;
+	things_updated_   = App::runTimer();
+}
+
 // -----------------------------------------------------------------------------
 // Updates map object visibility info depending on the current view
 // -----------------------------------------------------------------------------
 void MapRenderer2D::updateVisibility(Vec2d view_tl, Vec2d view_br)
 {
+	// Line and vertex tiles are checked against the view when drawn
+	view_tl_ = view_tl;
+	view_br_ = view_br;
+
 	// Sector visibility
 	if (map_->nSectors() != vis_s_.size())
 	{
@@ -3078,6 +3741,8 @@ void MapRenderer2D::forceUpdate(float line_alpha)
 	view_scale_inv_ = 1.0 / view_scale_;
 	tex_flats_.clear();
 	thing_sprites_.clear();
+	sprite_batch_.clear();
+	things_updated_ = 0;
 	thing_paths_.clear();
 
 	if (OpenGL::vboSupport())
@@ -3102,6 +3767,31 @@ void MapRenderer2D::forceUpdate(float line_alpha)
 	renderLines(lines_dirs_);
 }
 
+// -----------------------------------------------------------------------------
+// Clears any cached flat and sprite textures that are any of [textures] (sorted
+// OpenGL texture ids), eg. after the textures were loaded in the background
+// -----------------------------------------------------------------------------
+void MapRenderer2D::refreshTextures(const vector<unsigned>& textures)
+{
+	auto uses = [&textures](unsigned texture) {
+		return texture && std::binary_search(textures.begin(), textures.end(), texture);
+	};
+
+	// Flats (also reset the sector polygon's texture so that its texture
+	// coordinates are recalculated for the loaded texture size)
+	for (unsigned a = 0; a < tex_flats_.size() && a < map_->nSectors(); a++)
+		if (uses(tex_flats_[a]))
+		{
+			tex_flats_[a] = 0;
+			map_->sector(a)->polygon()->setTexture(0);
+		}
+
+	// Thing sprites
+	for (auto& sprite : thing_sprites_)
+		if (uses(sprite))
+			sprite = 0;
+}
+
 // -----------------------------------------------------------------------------
 // Returns [radius] scaled such that it stays the same size on screen at all
 // zoom levels
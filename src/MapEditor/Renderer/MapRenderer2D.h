@@ -32,6 +32,7 @@ public:
 	void renderVertexSelection(const ItemSelection& selection, float fade = 1.0f) const;
 
 	// Lines
+	uint8_t lineClass(const MapLine* line, bool ignore_filter = false) const;
 	ColRGBA lineColour(MapLine* line, bool ignore_filter = false) const;
 	void    renderLines(bool show_direction, float alpha = 1.0f);
 	void    renderLinesVBO(bool show_direction, float alpha);
@@ -50,6 +51,14 @@ public:
 		SquareSprite,
 		FramedSprite,
 	};
+	unsigned roundThingIcon(const Game::ThingType& type, double angle, bool& rotate) const;
+	unsigned squareThingIcon(
+		const Game::ThingType& type,
+		double                 angle,
+		bool                   showicon,
+		bool                   framed,
+		int&                   tc_start) const;
+
 	bool setupThingOverlay() const;
 	void renderThingOverlay(double x, double y, double radius, bool point) const;
 	void renderRoundThing(
@@ -79,6 +88,9 @@ public:
 		bool                   framed   = false) const;
 	void renderThings(float alpha = 1.0f, bool force_dir = false);
 	void renderThingsImmediate(float alpha);
+	void renderThingsVBO(float alpha);
+	void renderSquareThingSprites(float alpha);
+	void renderSpriteBatch();
 	void renderThingHilight(int index, float fade) const;
 	void renderThingSelection(const ItemSelection& selection, float fade = 1.0f) const;
 	void renderTaggedThings(vector<MapThing*>& things, float fade) const;
@@ -108,7 +120,10 @@ public:
 	// VBOs
 	void updateVerticesVBO();
 	void updateLinesVBO(bool show_direction, float base_alpha);
+	bool lineColoursChanged() const;
+	void updateLineColours(float base_alpha);
 	void updateFlatsVBO();
+	void updateThingsVBO(float alpha);
 
 	// Misc
 	void setScale(double scale)
@@ -118,6 +133,7 @@ public:
 	}
 	void   updateVisibility(Vec2d view_tl, Vec2d view_br);
 	void   forceUpdate(float line_alpha = 1.0f);
+	void   refreshTextures(const vector<unsigned>& textures);
 	double scaledRadius(int radius) const;
 	bool   visOK() const;
 	void   clearTextureCache() { tex_flats_.clear(); }
@@ -128,11 +144,11 @@ private:
 	long vertices_updated_ = 0;
 	long lines_updated_    = 0;
 	long flats_updated_    = 0;
+	long things_updated_   = 0;
 
 	// VBOs etc
-	unsigned vbo_vertices_ = 0;
-	unsigned vbo_lines_    = 0;
-	unsigned vbo_flats_    = 0;
+	unsigned vbo_flats_  = 0;
+	unsigned vbo_things_ = 0;
 
 	// Display lists
 	unsigned list_vertices_ = 0;
@@ -147,8 +163,6 @@ private:
 		VIS_BELOW = 8,
 		VIS_SMALL = 16,
 	};
-	vector<uint8_t> vis_v_;
-	vector<uint8_t> vis_l_;
 	vector<uint8_t> vis_t_;
 	vector<uint8_t> vis_s_;
 
@@ -163,6 +177,12 @@ private:
 		GLVert v1, v2;   // The line itself
 		GLVert dv1, dv2; // Direction tab
 	};
+	struct GLSpriteVert
+	{
+		float x, y;
+		float tx, ty;
+		float r, g, b, a;
+	};
 
 	// Other
 	bool     lines_dirs_     = false;
@@ -178,6 +198,82 @@ private:
 	vector<unsigned> thing_sprites_;
 	long             thing_sprites_updated_ = 0;
 
+	// Line/vertex VBO tiles
+	struct VBOTile
+	{
+		vector<unsigned> items;   // Line/vertex indices
+		vector<uint8_t>  classes; // Line colour classes
+		unsigned         vbo        = 0;
+		unsigned         vbo_colour = 0;
+		bool             dirty      = false;
+		Vec2d            min;
+		Vec2d            max;
+
+		void resetBounds()
+		{
+			min = { 1e12, 1e12 };
+			max = { -1e12, -1e12 };
+		}
+		void extend(double x, double y)
+		{
+			min.x = std::min(min.x, x);
+			min.y = std::min(min.y, y);
+			max.x = std::max(max.x, x);
+			max.y = std::max(max.y, y);
+		}
+	};
+	vector<VBOTile>  vertex_tiles_;
+	vector<unsigned> vertex_tile_index_; // Tile each vertex is in
+	vector<VBOTile>  line_tiles_;
+	vector<unsigned> line_tile_index_; // Tile each line is in
+
+	// Vertex/line list structure versions the tiles were built from
+	unsigned vertex_tiles_version_ = 0;
+	unsigned line_tiles_version_   = 0;
+
+	float            lines_alpha_ = 1.0f;
+	ColRGBA          line_class_colours_[16];
+	Vec2d            view_tl_     = { -1e12, -1e12 };
+	Vec2d            view_br_     = { 1e12, 1e12 };
+
+	// Batched rendering
+	vector<std::pair<unsigned, unsigned>> flat_draw_list_; // (texture, sector index)
+	bool                                  batch_sprites_     = false;
+	vector<GLSpriteVert>                  sprite_batch_;          // Quads on the current atlas page
+	unsigned                              sprite_batch_page_ = 0; // Atlas page texture of the batched quads
+
+	// Things VBO
+	struct ThingsVBORange
+	{
+		unsigned texture = 0;
+		unsigned first   = 0;
+		unsigned count   = 0;
+	};
+	struct ThingsVBOState
+	{
+		float alpha        = -1.0f;
+		int   drawtype     = -1;
+		bool  angles       = false;
+		float shadow       = 0.0f;
+		float arrow_alpha  = 0.0f;
+		bool  arrow_colour = false;
+		bool  zeth_icons   = false;
+
+		bool operator==(const ThingsVBOState& rhs) const
+		{
+			return alpha == rhs.alpha && drawtype == rhs.drawtype && angles == rhs.angles && shadow == rhs.shadow
+				   && arrow_alpha == rhs.arrow_alpha && arrow_colour == rhs.arrow_colour
+				   && zeth_icons == rhs.zeth_icons;
+		}
+	};
+	vector<ThingsVBORange> things_vbo_ranges_;
+	ThingsVBORange         things_vbo_arrows_;
+	ThingsVBOState         things_vbo_state_;
+	vector<uint8_t>        things_vbo_filtered_;
+	bool                   things_vbo_scaled_ = false; // True if any thing icons depend on the view scale
+	double                 things_vbo_scale_  = 0.;
+	vector<unsigned>       things_simple_; // Things with no icon texture (drawn immediately)
+
 	// Thing paths
 	enum class PathType
 	{
@@ -194,4 +290,15 @@ private:
 	};
 	vector<ThingPath> thing_paths_;
 	long              thing_paths_updated_ = 0;
+	// Line/vertex VBO tiles
+	void buildVBOTiles(
+		vector<VBOTile>&                      tiles,
+		vector<unsigned>&                     tile_index,
+		unsigned                              count,
+		const std::function<Vec2d(unsigned)>& position) const;
+	void clearVBOTiles(vector<VBOTile>& tiles) const;
+	void writeVertexTile(VBOTile& tile) const;
+	void writeLineTile(VBOTile& tile, bool show_direction) const;
+	void writeLineTileColours(VBOTile& tile, bool show_direction) const;
+	bool tileVisible(const VBOTile& tile) const;
 };
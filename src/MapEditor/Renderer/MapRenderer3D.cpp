@@ -70,6 +70,12 @@ CVAR(Bool, mlook_invert_y, false, CVar::Flag::Save)
 CVAR(Float, camera_3d_sensitivity_x, 1.0f, CVar::Flag::Save)
 CVAR(Float, camera_3d_sensitivity_y, 1.0f, CVar::Flag::Save)
 CVAR(Int, render_fov, 90, CVar::Flag::Save)
+namespace
+{
+// Max number of times a sector is re-checked with a wider view range during
+// portal visibility checks before it is given the full view range
+constexpr int MAX_SECTOR_VIS_PASSES = 4;
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -81,6 +87,74 @@ EXTERN_CVAR(Bool, flats_use_vbo)
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if there is any vertical gap between the front and back sectors
+// of two-sided [line] (ie. it isn't a closed door or similar)
+// -----------------------------------------------------------------------------
+bool portalOpen(MapLine* line)
+{
+	auto front = line->frontSector();
+	auto back  = line->backSector();
+	for (auto& point : { line->start(), line->end() })
+	{
+		double bottom = std::max(front->floor().plane.heightAt(point), back->floor().plane.heightAt(point));
+		double top    = std::min(front->ceiling().plane.heightAt(point), back->ceiling().plane.heightAt(point));
+		if (top > bottom)
+			return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Clips the view angle range [left]-[right] (in radians, relative to
+// [direction] from [cam]) to the range covered by [portal].
+// Returns false if the portal is entirely outside the view range
+// -----------------------------------------------------------------------------
+bool clipViewToPortal(Vec2d cam, Vec2d direction, const Seg2d& portal, float& left, float& right)
+{
+	auto angle_to = [&](Vec2d point) {
+		auto vec = point - cam;
+		return (float)atan2(direction.cross(vec), direction.dot(vec));
+	};
+	float a1 = angle_to(portal.start());
+	float a2 = angle_to(portal.end());
+	float lo = std::min(a1, a2);
+	float hi = std::max(a1, a2);
+
+	// Check if the portal spans the area behind the camera, ie. the ranges
+	// [hi,PI] and [-PI,lo]. The view range is always less than 180 degrees
+	// so it can only overlap one of them
+	if (hi - lo > MathStuff::PI)
+	{
+		if (hi < right)
+		{
+			left = std::max(left, hi);
+			return true;
+		}
+		if (lo > left)
+		{
+			right = std::min(right, lo);
+			return true;
+		}
+
+		return false;
+	}
+
+	left  = std::max(left, lo);
+	right = std::min(right, hi);
+	return left <= right;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // MapRenderer3D Class Functions
@@ -163,6 +237,10 @@ void MapRenderer3D::refresh()
 		glDeleteBuffers(1, &vbo_ceilings_);
 		vbo_floors_ = vbo_ceilings_ = 0;
 	}
+	clearWallsVBO();
+
+	// Clear hilight ray cast structure
+	hilight_bvh_.clear();
 
 	floors_.clear();
 	ceilings_.clear();
@@ -208,6 +286,40 @@ void MapRenderer3D::refreshTextures()
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Marks any lines, flats and things using any of [textures] (sorted OpenGL
+// texture ids) for updating, eg. after the textures were loaded in the
+// background
+// -----------------------------------------------------------------------------
+void MapRenderer3D::refreshTextures(const vector<unsigned>& textures)
+{
+	auto uses = [&textures](unsigned texture) {
+		return texture && std::binary_search(textures.begin(), textures.end(), texture);
+	};
+
+	// Refresh lines
+	for (auto& line : lines_)
+		for (auto& quad : line.quads)
+			if (uses(quad.texture))
+			{
+				line.updated_time = 0;
+				break;
+			}
+
+	// Refresh flats (sectors are updated when their floor is out of date)
+	for (unsigned a = 0; a < floors_.size() && a < ceilings_.size(); a++)
+		if (uses(floors_[a].texture) || uses(ceilings_[a].texture))
+		{
+			floors_[a].updated_time   = 0;
+			ceilings_[a].updated_time = 0;
+		}
+
+	// Refresh things
+	for (auto& thing : things_)
+		if (uses(thing.sprite))
+			thing.updated_time = 0;
+}
+
 // -----------------------------------------------------------------------------
 // Clears all cached rendering data
 // -----------------------------------------------------------------------------
@@ -502,10 +614,10 @@ void MapRenderer3D::setupView(int width, int height)
 }
 
 // -----------------------------------------------------------------------------
-// Sets the OpenGL colour for rendering an object using [colour] and [light]
+// Returns the colour multiplier to use for rendering an object at [light]
 // level
 // -----------------------------------------------------------------------------
-void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
+float MapRenderer3D::lightMultiplier(uint8_t light) const
 {
 	// Force 255 light in fullbright mode
 	if (fullbright_)
@@ -518,7 +630,16 @@ void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
 	// If we have a non-coloured light, darken it a bit to
 	// closer resemble the software renderer light level
 	float mult = (float)light / 255.0f;
-	mult *= (mult * 1.3f);
+	return mult * (mult * 1.3f);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the OpenGL colour for rendering an object using [colour] and [light]
+// level
+// -----------------------------------------------------------------------------
+void MapRenderer3D::setLight(ColRGBA& colour, uint8_t light, float alpha) const
+{
+	float mult = lightMultiplier(light);
 	glColor4f(colour.fr() * mult, colour.fg() * mult, colour.fb() * mult, colour.fa() * alpha);
 }
 
@@ -604,15 +725,19 @@ void MapRenderer3D::renderMap()
 
 	// Create lines array if empty
 	if (lines_.size() != map_->nLines())
+	{
+		for (unsigned a = map_->nLines(); a < lines_.size(); a++)
+			freeWallQuads(lines_[a]);
 		lines_.resize(map_->nLines());
+	}
 
 	// Create things array if empty
 	if (things_.size() != map_->nThings())
 		things_.resize(map_->nThings());
 
-	// Quick distance vis check
+	// Determine visible sectors and lines
 	sf::Clock clock;
-	quickVisDiscard();
+	checkVisibleSectors();
 
 	// Build lists of quads and flats to render
 	checkVisibleFlats();
@@ -943,7 +1068,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	// Update floor
 	bool  mix_tex_flats      = Game::configuration().featureSupported(Game::Feature::MixTexFlats);
 	auto  sector             = map_->sector(index);
-	auto& ftex               = MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats);
+	auto& ftex               = MapEditor::textureManager().flat(sector->floor().texture, mix_tex_flats, true);
 	floors_[index].sector    = sector;
 	floors_[index].texture   = ftex.gl_id;
 	floors_[index].scale     = ftex.scale;
@@ -966,7 +1091,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	}
 
 	// Update ceiling
-	auto& ctex                 = MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats);
+	auto& ctex                 = MapEditor::textureManager().flat(sector->ceiling().texture, mix_tex_flats, true);
 	ceilings_[index].sector    = sector;
 	ceilings_[index].texture   = ctex.gl_id;
 	ceilings_[index].scale     = ctex.scale;
@@ -991,6 +1116,11 @@ void MapRenderer3D::updateSector(unsigned index)
 	// Finish up
 	floors_[index].updated_time   = App::runTimer();
 	ceilings_[index].updated_time = App::runTimer();
+	if (index < hilight_n_sectors_)
+	{
+		hilight_bvh_.update(hilight_n_lines_ + index, flatHilightBox(index, false));
+		hilight_bvh_.update(hilight_n_lines_ + hilight_n_sectors_ + index, flatHilightBox(index, true));
+	}
 	if (OpenGL::vboSupport())
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1304,6 +1434,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		return;
 
 	// Clear current line data
+	freeWallQuads(lines_[index]);
 	lines_[index].quads.clear();
 
 	// Skip invalid line
@@ -1378,7 +1509,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = MapEditor::textureManager().texture(line->s1()->texMiddle(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s1()->texMiddle(), mixed, true);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1408,6 +1539,10 @@ void MapRenderer3D::updateLine(unsigned index)
 
 		// Add middle quad and finish
 		lines_[index].quads.push_back(quad);
+		if (OpenGL::vboSupport())
+			writeWallQuads(index);
+		if (index < hilight_n_lines_)
+			hilight_bvh_.update(index, lineHilightBox(index));
 		lines_[index].updated_time = App::runTimer();
 		return;
 	}
@@ -1481,7 +1616,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = MapEditor::textureManager().texture(line->s1()->texLower(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s1()->texLower(), mixed, true);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1529,7 +1664,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		Quad quad;
 
 		// Get texture
-		auto& tex    = MapEditor::textureManager().texture(line->s1()->texMiddle(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s1()->texMiddle(), mixed, true);
 		quad.texture = tex.gl_id;
 
 		// Determine offsets
@@ -1637,7 +1772,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = MapEditor::textureManager().texture(line->s1()->texUpper(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s1()->texUpper(), mixed, true);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1696,7 +1831,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = MapEditor::textureManager().texture(line->s2()->texLower(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s2()->texLower(), mixed, true);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1745,7 +1880,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		Quad quad;
 
 		// Get texture
-		auto& tex    = MapEditor::textureManager().texture(midtex2, mixed);
+		auto& tex    = MapEditor::textureManager().texture(midtex2, mixed, true);
 		quad.texture = tex.gl_id;
 
 		// Determine offsets
@@ -1854,7 +1989,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		auto& tex    = MapEditor::textureManager().texture(line->s2()->texUpper(), mixed);
+		auto& tex    = MapEditor::textureManager().texture(line->s2()->texUpper(), mixed, true);
 		quad.texture = tex.gl_id;
 		sx           = tex.scale.x;
 		sy           = tex.scale.y;
@@ -1891,6 +2026,14 @@ void MapRenderer3D::updateLine(unsigned index)
 		lines_[index].quads.push_back(quad);
 	}
 
+	// Write quads to walls VBO
+	if (OpenGL::vboSupport())
+		writeWallQuads(index);
+
+	// Update hilight box
+	if (index < hilight_n_lines_)
+		hilight_bvh_.update(index, lineHilightBox(index));
+
 	// Finished
 	lines_[index].updated_time = App::runTimer();
 }
@@ -1956,41 +2099,53 @@ void MapRenderer3D::renderWalls()
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
 
-	// Render all visible quads, ordered by texture
-	unsigned a        = 0;
-	unsigned tex_last = 0;
-	while (n_quads_ > 0)
+	// Sort visible quads into transparent, VBO (batched by bucket) and the rest
+	bool     use_vbo = OpenGL::vboSupport();
+	unsigned n_other = 0;
+	for (unsigned a = 0; a < n_quads_; a++)
 	{
-		tex_last = 0;
-		a        = 0;
-		while (a < n_quads_)
+		auto quad = quads_[a];
+
+		// Check alpha
+		if (quad->colour.a < 255)
 		{
-			// Check alpha
-			if (quads_[a]->colour.a < 255)
-			{
-				quads_transparent_.push_back(quads_[a]);
-				quads_[a] = quads_[n_quads_ - 1];
-				n_quads_--;
-				continue;
-			}
+			quads_transparent_.push_back(quad);
+			continue;
+		}
 
-			// Check texture
-			if (!tex_last && quads_[a]->texture)
-			{
-				tex_last = quads_[a]->texture;
-				OpenGL::Texture::bind(quads_[a]->texture);
-			}
-			if (quads_[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
+		// Opaque quads are rendered from the VBO unless they are fading out or
+		// use additive rendering
+		if (use_vbo && quad->vbo_slot >= 0 && quad->alpha >= 1.0f && !(quad->flags & TRANSADD))
+		{
+			auto& indices = wall_buckets_[quad->bucket].indices;
+			auto  first   = quad->vbo_slot * 4;
+			indices.push_back(first);
+			indices.push_back(first + 1);
+			indices.push_back(first + 2);
+			indices.push_back(first + 3);
+			continue;
+		}
 
-			// Render quad
-			renderQuad(quads_[a], quads_[a]->alpha);
-			quads_[a] = quads_[n_quads_ - 1];
-			n_quads_--;
+		quads_[n_other++] = quad;
+	}
+	n_quads_ = 0;
+
+	// Render batched quads
+	if (use_vbo)
+		renderWallsVBO();
+
+	// Render any other quads, ordered by texture
+	std::sort(quads_, quads_ + n_other, [](Quad* left, Quad* right) { return left->texture < right->texture; });
+	unsigned tex_last = 0;
+	for (unsigned a = 0; a < n_other; a++)
+	{
+		if (quads_[a]->texture && quads_[a]->texture != tex_last)
+		{
+			tex_last = quads_[a]->texture;
+			OpenGL::Texture::bind(tex_last);
 		}
+
+		renderQuad(quads_[a], quads_[a]->alpha);
 	}
 
 	glDisable(GL_TEXTURE_2D);
@@ -2135,7 +2290,8 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 								.sprite(
 									things_[index].type->sprite(),
 									things_[index].type->translation(),
-									things_[index].type->palette())
+									things_[index].type->palette(),
+									true)
 								.gl_id;
 	if (!things_[index].sprite)
 	{
@@ -2193,6 +2349,10 @@ void MapRenderer3D::updateThing(unsigned index, MapThing* thing)
 	// Adjust height by sprite Y offset if needed
 	things_[index].z += MapEditor::textureManager().verticalOffset(things_[index].type->sprite());
 
+	// Update hilight box
+	if (index < hilight_n_things_)
+		hilight_bvh_.update(hilight_n_lines_ + hilight_n_sectors_ * 2 + index, thingHilightBox(index));
+
 	things_[index].updated_time = App::runTimer();
 }
 
@@ -2591,10 +2751,343 @@ void MapRenderer3D::updateFlatsVBO()
 }
 
 // -----------------------------------------------------------------------------
-// (Re)builds the walls Vertex Buffer Object
-// (or would, if it were used for wall rendering)
+// Uploads any modified wall quad data to the walls Vertex Buffer Object,
+// (re)creating it if needed
+// -----------------------------------------------------------------------------
+void MapRenderer3D::updateWallsVBO()
+{
+	// Quad colours need rewriting if light settings have changed
+	if (fullbright_ != wall_fullbright_ || render_3d_brightness != wall_brightness_)
+	{
+		wall_fullbright_ = fullbright_;
+		wall_brightness_ = render_3d_brightness;
+		for (auto& line : lines_)
+			for (auto& quad : line.quads)
+				if (quad.vbo_slot >= 0)
+					writeWallQuad(quad);
+	}
+
+	// Create VBO if needed
+	if (vbo_walls_ == 0)
+		glGenBuffers(1, &vbo_walls_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_walls_);
+
+	if (wall_vertices_.size() > wall_vbo_size_)
+	{
+		// Not enough space, reallocate (with some room to grow) and write all
+		wall_vbo_size_ = std::max<unsigned>(wall_vertices_.size() * 3 / 2, 4096);
+		glBufferData(GL_ARRAY_BUFFER, wall_vbo_size_ * sizeof(WallVertex), nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, wall_vertices_.size() * sizeof(WallVertex), wall_vertices_.data());
+	}
+	else if (wall_dirty_begin_ < wall_dirty_end_)
+	{
+		// Write modified range only
+		glBufferSubData(
+			GL_ARRAY_BUFFER,
+			wall_dirty_begin_ * sizeof(WallVertex),
+			(wall_dirty_end_ - wall_dirty_begin_) * sizeof(WallVertex),
+			wall_vertices_.data() + wall_dirty_begin_);
+	}
+
+	wall_dirty_begin_ = wall_dirty_end_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Clears the walls Vertex Buffer Object and all wall quad data written to it.
+// All lines will be updated again next time they are visible
+// -----------------------------------------------------------------------------
+void MapRenderer3D::clearWallsVBO()
+{
+	if (vbo_walls_ != 0)
+	{
+		glDeleteBuffers(1, &vbo_walls_);
+		vbo_walls_ = 0;
+	}
+
+	wall_vertices_.clear();
+	wall_free_slots_.clear();
+	wall_buckets_.clear();
+	wall_bucket_ids_.clear();
+	wall_vbo_size_    = 0;
+	wall_dirty_begin_ = wall_dirty_end_ = 0;
+
+	for (auto& line : lines_)
+	{
+		line.quads.clear();
+		line.updated_time = 0;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Writes all quads for line [index] to the walls VBO data, allocating a slot
+// and render bucket for each
+// -----------------------------------------------------------------------------
+void MapRenderer3D::writeWallQuads(unsigned index)
+{
+	for (auto& quad : lines_[index].quads)
+	{
+		// Get a free slot
+		if (wall_free_slots_.empty())
+		{
+			quad.vbo_slot = wall_vertices_.size() / 4;
+			wall_vertices_.resize(wall_vertices_.size() + 4);
+		}
+		else
+		{
+			quad.vbo_slot = wall_free_slots_.back();
+			wall_free_slots_.pop_back();
+		}
+
+		// Get render bucket, quads can only be batched together if they have the
+		// same texture, fog and special rendering options
+		uint8_t       flags = quad.flags & (SKY | MIDTEX);
+		WallBucketKey key{ quad.texture,
+						   flags,
+						   (uint32_t)quad.fogcolour.r << 24 | (uint32_t)quad.fogcolour.g << 16
+							   | (uint32_t)quad.fogcolour.b << 8 | quad.light };
+		auto          bucket = wall_bucket_ids_.find(key);
+		if (bucket == wall_bucket_ids_.end())
+		{
+			WallBucket new_bucket;
+			new_bucket.texture   = quad.texture;
+			new_bucket.flags     = flags;
+			new_bucket.fogcolour = quad.fogcolour;
+			new_bucket.light     = quad.light;
+			wall_buckets_.push_back(new_bucket);
+			bucket = wall_bucket_ids_.emplace(key, wall_buckets_.size() - 1).first;
+		}
+		quad.bucket = bucket->second;
+
+		writeWallQuad(quad);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Writes [quad]'s vertices to its slot in the walls VBO data
+// -----------------------------------------------------------------------------
+void MapRenderer3D::writeWallQuad(const Quad& quad)
+{
+	// Determine colour
+	float   mult = lightMultiplier(quad.light);
+	uint8_t r    = MathStuff::clamp(quad.colour.r * mult, 0, 255);
+	uint8_t g    = MathStuff::clamp(quad.colour.g * mult, 0, 255);
+	uint8_t b    = MathStuff::clamp(quad.colour.b * mult, 0, 255);
+
+	// Write vertices
+	unsigned first = quad.vbo_slot * 4;
+	for (unsigned a = 0; a < 4; a++)
+	{
+		auto& vertex = wall_vertices_[first + a];
+		vertex.x     = quad.points[a].x;
+		vertex.y     = quad.points[a].y;
+		vertex.z     = quad.points[a].z;
+		vertex.tx    = quad.points[a].tx;
+		vertex.ty    = quad.points[a].ty;
+		vertex.r     = r;
+		vertex.g     = g;
+		vertex.b     = b;
+		vertex.a     = quad.colour.a;
+	}
+
+	// Extend modified range
+	if (wall_dirty_begin_ >= wall_dirty_end_)
+	{
+		wall_dirty_begin_ = first;
+		wall_dirty_end_   = first + 4;
+	}
+	else
+	{
+		wall_dirty_begin_ = std::min(wall_dirty_begin_, first);
+		wall_dirty_end_   = std::max(wall_dirty_end_, first + 4);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Frees the walls VBO slots used by all quads in [line]
+// -----------------------------------------------------------------------------
+void MapRenderer3D::freeWallQuads(Line& line)
+{
+	for (auto& quad : line.quads)
+	{
+		if (quad.vbo_slot >= 0)
+			wall_free_slots_.push_back(quad.vbo_slot);
+		quad.vbo_slot = -1;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Renders all wall quads currently added to render buckets from the walls VBO,
+// with one draw call per bucket
+// -----------------------------------------------------------------------------
+void MapRenderer3D::renderWallsVBO()
+{
+	updateWallsVBO();
+
+	// Setup VBO pointers
+	glVertexPointer(3, GL_FLOAT, sizeof(WallVertex), nullptr);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(WallVertex), (char*)nullptr + offsetof(WallVertex, tx));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(WallVertex), (char*)nullptr + offsetof(WallVertex, r));
+	glEnableClientState(GL_COLOR_ARRAY);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	for (auto& bucket : wall_buckets_)
+	{
+		if (bucket.indices.empty())
+			continue;
+
+		// Setup special rendering options
+		bool sky = bucket.flags & SKY && render_3d_sky;
+		if (sky)
+		{
+			// Sky walls are invisible but still write to the depth buffer
+			glDisable(GL_ALPHA_TEST);
+			glDisableClientState(GL_COLOR_ARRAY);
+			glColor4f(0.0f, 0.0f, 0.0f, 0.0f);
+		}
+		else if (bucket.flags & MIDTEX)
+			glAlphaFunc(GL_GREATER, 0.9f);
+
+		// Render
+		OpenGL::Texture::bind(bucket.texture, false);
+		setFog(bucket.fogcolour, bucket.light);
+		glDrawElements(GL_QUADS, bucket.indices.size(), GL_UNSIGNED_INT, bucket.indices.data());
+		bucket.indices.clear();
+
+		// Reset settings
+		if (sky)
+		{
+			glEnable(GL_ALPHA_TEST);
+			glEnableClientState(GL_COLOR_ARRAY);
+		}
+		else if (bucket.flags & MIDTEX)
+			glAlphaFunc(GL_GREATER, 0.0f);
+	}
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// -----------------------------------------------------------------------------
+// Determines visible sectors and lines by traversing two-sided lines (portals)
+// outwards from the sector the camera is in, narrowing the view angle range
+// to each portal passed through. Only sectors reachable from the camera within
+// the view and render distance are processed.
+// Falls back to quickVisDiscard if the camera isn't within a sector
 // -----------------------------------------------------------------------------
-void MapRenderer3D::updateWallsVBO() const {}
+void MapRenderer3D::checkVisibleSectors()
+{
+	// Reset visibility from last check (everything if sectors have changed)
+	if (dist_sectors_.size() != map_->nSectors() || vis_sectors_info_.size() != map_->nSectors())
+	{
+		dist_sectors_.assign(map_->nSectors(), -1.0f);
+		vis_sectors_info_.assign(map_->nSectors(), {});
+		for (auto& line : lines_)
+			line.visible = false;
+	}
+	else
+	{
+		for (auto index : vis_sectors_)
+		{
+			dist_sectors_[index]     = -1.0f;
+			vis_sectors_info_[index] = {};
+		}
+		for (auto index : vis_lines_)
+			if (index < lines_.size())
+				lines_[index].visible = false;
+	}
+	vis_sectors_.clear();
+	vis_lines_.clear();
+
+	// Get sector the camera is in
+	auto cam    = cam_position_.get2d();
+	auto sector = map_->sectors().atPos(cam);
+	if (!sector)
+	{
+		quickVisDiscard();
+		return;
+	}
+
+	// Determine initial view range. When looking up or down steeply the view
+	// covers a much wider area around the camera, so don't clip to portals
+	float view_range = MathStuff::degToRad(render_fov) * 0.5 + fabs(cam_pitch_) + 0.1;
+	bool  clip       = view_range < MathStuff::PI * 0.5;
+
+	// Traverse portals from the camera sector
+	vis_stack_.clear();
+	vis_stack_.push_back({ sector, -view_range, view_range, 0.0f });
+	while (!vis_stack_.empty())
+	{
+		auto view = vis_stack_.back();
+		vis_stack_.pop_back();
+
+		auto  index = view.sector->index();
+		auto& info  = vis_sectors_info_[index];
+		if (info.passes == 0)
+		{
+			// First time reaching this sector
+			vis_sectors_.push_back(index);
+			dist_sectors_[index] = view.dist;
+			info.left            = view.left;
+			info.right           = view.right;
+		}
+		else
+		{
+			// Skip if already checked with a view range covering this one
+			if (view.left >= info.left && view.right <= info.right)
+				continue;
+
+			// Check again with the combined view range, or the full range if
+			// the sector has been reached many times (eg. through lots of small
+			// portals)
+			if (info.passes >= MAX_SECTOR_VIS_PASSES)
+			{
+				info.left  = -view_range;
+				info.right = view_range;
+			}
+			else
+			{
+				info.left  = std::min(info.left, view.left);
+				info.right = std::max(info.right, view.right);
+			}
+			view.left            = info.left;
+			view.right           = info.right;
+			dist_sectors_[index] = std::min(dist_sectors_[index], view.dist);
+		}
+		info.passes++;
+
+		for (auto side : view.sector->connectedSides())
+		{
+			// Set line visible
+			auto line = side->parentLine();
+			if (!lines_[line->index()].visible)
+			{
+				lines_[line->index()].visible = true;
+				vis_lines_.push_back(line->index());
+			}
+
+			// Check for a portal to another sector
+			auto other = side == line->s1() ? line->backSector() : line->frontSector();
+			if (!other || other == view.sector)
+				continue;
+
+			// Check distance
+			double dist = MathStuff::distanceToLine(cam, line->seg());
+			if (render_max_dist > 0 && dist > render_max_dist)
+				continue;
+
+			// Can't see through closed portals
+			if (!portalOpen(line))
+				continue;
+
+			// Clip view range to portal (unless the camera is right at it)
+			PortalView next{ other, view.left, view.right, (float)std::max<double>(dist, view.dist) };
+			if (clip && dist > 1.0 && !clipViewToPortal(cam, cam_direction_, line->seg(), next.left, next.right))
+				continue;
+
+			vis_stack_.push_back(next);
+		}
+	}
+}
 
 // -----------------------------------------------------------------------------
 // Runs a quick check of all sector bounding boxes against the current view to
@@ -2666,6 +3159,16 @@ void MapRenderer3D::quickVisDiscard()
 		else
 			lines_[map_->side(a)->parentLine()->index()].visible = true;
 	}
+
+	// Build visible sector/line lists
+	vis_sectors_.clear();
+	vis_lines_.clear();
+	for (unsigned a = 0; a < map_->nSectors(); a++)
+		if (dist_sectors_[a] >= 0)
+			vis_sectors_.push_back(a);
+	for (unsigned a = 0; a < lines_.size(); a++)
+		if (lines_[a].visible)
+			vis_lines_.push_back(a);
 }
 
 // -----------------------------------------------------------------------------
@@ -2699,14 +3202,10 @@ void MapRenderer3D::checkVisibleQuads()
 	unsigned updates = 0;
 	bool     update  = false;
 	Seg2d    strafe(cam_position_.get2d(), (cam_position_ + cam_strafe_).get2d());
-	for (unsigned a = 0; a < lines_.size(); a++)
+	for (auto a : vis_lines_)
 	{
 		line = map_->line(a);
 
-		// Skip if not visible
-		if (!lines_[a].visible)
-			continue;
-
 		// Check side of camera
 		if (cam_pitch_ > -0.9 && cam_pitch_ < 0.9)
 		{
@@ -2781,7 +3280,7 @@ void MapRenderer3D::checkVisibleFlats()
 	n_flats_ = 0;
 	float alpha;
 	auto  cam = cam_position_.get2d();
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	for (auto a : vis_sectors_)
 	{
 		sector = map_->sector(a);
 
@@ -2818,7 +3317,7 @@ void MapRenderer3D::checkVisibleFlats()
 		// Add floor flat
 		flats_[n_flats_++] = &(floors_[a]);
 	}
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	for (auto a : vis_sectors_)
 	{
 		// Skip if invisible
 		if (dist_sectors_[a] < 0)
@@ -2837,176 +3336,295 @@ MapEditor::Item MapRenderer3D::determineHilight()
 	// Init
 	double          min_dist = 9999999;
 	MapEditor::Item current;
-	Seg2d           strafe(cam_position_.get2d(), (cam_position_ + cam_strafe_).get2d());
 
 	// Check for required map structures
 	if (!map_ || lines_.size() != map_->nLines() || floors_.size() != map_->nSectors()
 		|| things_.size() != map_->nThings())
 		return current;
 
-	// Check lines
-	double height, dist;
-	for (unsigned a = 0; a < map_->nLines(); a++)
-	{
-		// Ignore if not visible
-		if (!lines_[a].visible)
-			continue;
-
-		auto line = map_->line(a);
-
-		// Find (2d) distance to line
-		dist = MathStuff::distanceRayLine(
-			cam_position_.get2d(), (cam_position_ + cam_dir3d_).get2d(), line->start(), line->end());
+	// Cast view ray, checking everything it passes near from front to back
+	updateHilightBVH();
+	auto hit_func = [&](unsigned id, double max_dist) {
+		if (id < hilight_n_lines_)
+			return wallHilightDist(id, max_dist, current);
+		id -= hilight_n_lines_;
+		if (id < hilight_n_sectors_)
+			return flatHilightDist(id, false, max_dist, current);
+		id -= hilight_n_sectors_;
+		if (id < hilight_n_sectors_)
+			return flatHilightDist(id, true, max_dist, current);
+		id -= hilight_n_sectors_;
+		return thingHilightDist(id, max_dist, current);
+	};
+	hilight_bvh_.cast(cam_position_, cam_dir3d_, hit_func, min_dist);
 
-		// Ignore if no intersection or something was closer
-		if (dist < 0 || dist >= min_dist)
-			continue;
+	// Update item distance
+	if (min_dist >= 9999999 || min_dist < 0)
+		item_dist_ = -1;
+	else
+		item_dist_ = MathStuff::round(min_dist);
 
-		// Find quad intersect if any
-		auto intersection = cam_position_ + cam_dir3d_ * dist;
-		for (auto& quad : lines_[a].quads)
-		{
-			// Check side of camera
-			if (MathStuff::lineSide(
-					cam_position_.get2d(),
-					Seg2d(quad.points[0].x, quad.points[0].y, quad.points[2].x, quad.points[2].y))
-				< 0)
-				continue;
+	return current;
+}
 
-			// Check intersection height
-			// Need to handle slopes by finding the floor and ceiling height of
-			// the quad at the intersection point
-			Vec2d  seg_left           = Vec2d(quad.points[1].x, quad.points[1].y);
-			Vec2d  seg_right          = Vec2d(quad.points[2].x, quad.points[2].y);
-			double dist_along_segment = (intersection.get2d() - seg_left).magnitude()
-										/ (seg_right - seg_left).magnitude();
-			double top    = quad.points[0].z + (quad.points[3].z - quad.points[0].z) * dist_along_segment;
-			double bottom = quad.points[1].z + (quad.points[2].z - quad.points[1].z) * dist_along_segment;
-			if (bottom <= intersection.z && intersection.z <= top)
-			{
-				// Determine selected item from quad flags
+// -----------------------------------------------------------------------------
+// (Re)builds the hilight ray cast structure if the number of lines, sectors or
+// things in the map has changed. Otherwise items are updated individually as
+// their cached rendering data is updated
+// -----------------------------------------------------------------------------
+void MapRenderer3D::updateHilightBVH()
+{
+	if (hilight_bvh_.size() > 0 && hilight_n_lines_ == map_->nLines() && hilight_n_sectors_ == map_->nSectors()
+		&& hilight_n_things_ == map_->nThings())
+		return;
 
-				// Side index
-				if (quad.flags & BACK)
-					current.index = line->s2Index();
-				else
-					current.index = line->s1Index();
+	hilight_n_lines_   = map_->nLines();
+	hilight_n_sectors_ = map_->nSectors();
+	hilight_n_things_  = map_->nThings();
+
+	vector<RayCastBVH::Box> boxes;
+	boxes.reserve(hilight_n_lines_ + hilight_n_sectors_ * 2 + hilight_n_things_);
+	for (unsigned a = 0; a < hilight_n_lines_; a++)
+		boxes.push_back(lineHilightBox(a));
+	for (unsigned a = 0; a < hilight_n_sectors_; a++)
+		boxes.push_back(flatHilightBox(a, false));
+	for (unsigned a = 0; a < hilight_n_sectors_; a++)
+		boxes.push_back(flatHilightBox(a, true));
+	for (unsigned a = 0; a < hilight_n_things_; a++)
+		boxes.push_back(thingHilightBox(a));
+
+	hilight_bvh_.build(std::move(boxes));
+}
 
-				// Side part
-				if (quad.flags & UPPER)
-					current.type = MapEditor::ItemType::WallTop;
-				else if (quad.flags & LOWER)
-					current.type = MapEditor::ItemType::WallBottom;
-				else
-					current.type = MapEditor::ItemType::WallMiddle;
+// -----------------------------------------------------------------------------
+// Returns the hilight ray cast box for line [index], around its wall quads if
+// it has any or otherwise its sectors' floor-to-ceiling height range
+// -----------------------------------------------------------------------------
+RayCastBVH::Box MapRenderer3D::lineHilightBox(unsigned index) const
+{
+	RayCastBVH::Box box;
 
-				min_dist = dist;
-			}
-		}
+	if (index < lines_.size() && !lines_[index].quads.empty())
+	{
+		for (auto& quad : lines_[index].quads)
+			for (auto& point : quad.points)
+				box.extend(Vec3f(point.x, point.y, point.z));
 	}
-
-	// Check sectors
-	for (unsigned a = 0; a < map_->nSectors(); a++)
+	else
 	{
-		// Ignore if not visible
-		if (dist_sectors_[a] < 0)
-			continue;
-
-		// Check distance to floor plane
-		dist = MathStuff::distanceRayPlane(cam_position_, cam_dir3d_, floors_[a].plane);
-		if (dist >= 0 && dist < min_dist)
+		auto line = map_->line(index);
+		for (auto sector : { line->frontSector(), line->backSector() })
 		{
-			// Check if on the correct side of the plane
-			if (cam_position_.z > floors_[a].plane.heightAt(cam_position_.x, cam_position_.y))
-			{
-				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
-				{
-					current.index = a;
-					current.type  = MapEditor::ItemType::Floor;
-					min_dist      = dist;
-				}
-			}
-		}
+			if (!sector)
+				continue;
 
-		// Check distance to ceiling plane
-		dist = MathStuff::distanceRayPlane(cam_position_, cam_dir3d_, ceilings_[a].plane);
-		if (dist >= 0 && dist < min_dist)
-		{
-			// Check if on the correct side of the plane
-			if (cam_position_.z < ceilings_[a].plane.heightAt(cam_position_.x, cam_position_.y))
+			for (auto& point : { line->start(), line->end() })
 			{
-				// Check if intersection is within sector
-				if (map_->sector(a)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
-				{
-					current.index = a;
-					current.type  = MapEditor::ItemType::Ceiling;
-					min_dist      = dist;
-				}
+				box.extend(Vec3f(point.x, point.y, sector->floor().plane.heightAt(point)));
+				box.extend(Vec3f(point.x, point.y, sector->ceiling().plane.heightAt(point)));
 			}
 		}
 	}
 
-	// Update item distance
-	if (min_dist >= 9999999 || min_dist < 0)
-		item_dist_ = -1;
-	else
-		item_dist_ = MathStuff::round(min_dist);
+	box.pad(1.0f);
+	return box;
+}
 
-	// Check things (if visible)
-	if (render_3d_things == 0)
-		return current;
-	double halfwidth, theight;
-	for (unsigned a = 0; a < map_->nThings(); a++)
+// -----------------------------------------------------------------------------
+// Returns the hilight ray cast box for the floor (or [ceiling]) of sector
+// [index]
+// -----------------------------------------------------------------------------
+RayCastBVH::Box MapRenderer3D::flatHilightBox(unsigned index, bool ceiling) const
+{
+	auto sector = map_->sector(index);
+	auto bbox   = sector->boundingBox();
+
+	// Use the cached plane if the flat has been updated
+	auto& flat  = ceiling ? ceilings_ : floors_;
+	auto  plane = ceiling ? sector->ceiling().plane : sector->floor().plane;
+	if (index < flat.size() && flat[index].updated_time > 0)
+		plane = flat[index].plane;
+
+	// Planes are linear so the height range over the bbox is at its corners
+	RayCastBVH::Box box;
+	for (auto& point : { bbox.min, bbox.max, Vec2d(bbox.min.x, bbox.max.y), Vec2d(bbox.max.x, bbox.min.y) })
+		box.extend(Vec3f(point.x, point.y, plane.heightAt(point)));
+
+	box.pad(1.0f);
+	return box;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the hilight ray cast box for thing [index], around its sprite from
+// any view angle (or just its position if the sprite isn't loaded yet)
+// -----------------------------------------------------------------------------
+RayCastBVH::Box MapRenderer3D::thingHilightBox(unsigned index) const
+{
+	RayCastBVH::Box box;
+	auto            thing = map_->thing(index);
+
+	if (index >= things_.size() || !things_[index].sprite)
 	{
-		// Ignore if no sprite
-		if (!things_[a].sprite)
-			continue;
+		box.extend(Vec3f(thing->xPos(), thing->yPos(), 0.0f));
+		return box;
+	}
 
-		// Ignore if not visible
-		auto thing = map_->thing(a);
-		if (MathStuff::lineSide(thing->position(), strafe) > 0)
-			continue;
+	// Get sprite size (allowing for scaling either way)
+	auto&  tex_info  = OpenGL::Texture::info(things_[index].sprite);
+	double halfwidth = tex_info.size.x * std::max(1.0f, things_[index].type->scaleX()) * 0.5;
+	double theight   = tex_info.size.y * std::max(1.0f, things_[index].type->scaleY());
+	if (things_[index].flags & ICON)
+	{
+		halfwidth = render_thing_icon_size * 0.5;
+		theight   = render_thing_icon_size;
+	}
 
-		// Ignore if not shown
-		if (!things_[a].type->decoration() && render_3d_things == 2)
-			continue;
+	box.extend(Vec3f(thing->xPos() - halfwidth, thing->yPos() - halfwidth, things_[index].z));
+	box.extend(Vec3f(thing->xPos() + halfwidth, thing->yPos() + halfwidth, things_[index].z + theight));
+	box.pad(1.0f);
+	return box;
+}
 
-		// Find distance to thing sprite
-		auto& tex_info = OpenGL::Texture::info(things_[a].sprite);
-		halfwidth      = tex_info.size.x * 0.5;
-		if (things_[a].flags & ICON)
-			halfwidth = render_thing_icon_size * 0.5;
-		dist = MathStuff::distanceRayLine(
-			cam_position_.get2d(),
-			(cam_position_ + cam_dir3d_).get2d(),
-			thing->position() - cam_strafe_.get2d() * halfwidth,
-			thing->position() + cam_strafe_.get2d() * halfwidth);
-
-		// Ignore if no intersection or something was closer
-		if (dist < 0 || dist >= min_dist)
+// -----------------------------------------------------------------------------
+// Returns the distance along the view vector that it hits a wall quad of line
+// [index], or -1 if it doesn't hit one closer than [max_dist].
+// If it does, [item] is set to the wall hit
+// -----------------------------------------------------------------------------
+double MapRenderer3D::wallHilightDist(unsigned index, double max_dist, MapEditor::Item& item) const
+{
+	auto line = map_->line(index);
+
+	// Find (2d) distance to line
+	double dist = MathStuff::distanceRayLine(
+		cam_position_.get2d(), (cam_position_ + cam_dir3d_).get2d(), line->start(), line->end());
+
+	// Ignore if no intersection or something was closer
+	if (dist < 0 || dist >= max_dist)
+		return -1;
+
+	// Find quad intersect if any
+	double hit          = -1;
+	auto   intersection = cam_position_ + cam_dir3d_ * dist;
+	for (auto& quad : lines_[index].quads)
+	{
+		// Check side of camera
+		if (MathStuff::lineSide(
+				cam_position_.get2d(), Seg2d(quad.points[0].x, quad.points[0].y, quad.points[2].x, quad.points[2].y))
+			< 0)
 			continue;
 
 		// Check intersection height
-		theight = tex_info.size.y;
-		height  = cam_position_.z + cam_dir3d_.z * dist;
-		if (things_[a].flags & ICON)
-			theight = render_thing_icon_size;
-		if (height >= things_[a].z && height <= things_[a].z + theight)
-		{
-			current.index = a;
-			current.type  = MapEditor::ItemType::Thing;
-			min_dist      = dist;
+		// Need to handle slopes by finding the floor and ceiling height of
+		// the quad at the intersection point
+		Vec2d  seg_left           = Vec2d(quad.points[1].x, quad.points[1].y);
+		Vec2d  seg_right          = Vec2d(quad.points[2].x, quad.points[2].y);
+		double dist_along_segment = (intersection.get2d() - seg_left).magnitude()
+									/ (seg_right - seg_left).magnitude();
+		double top    = quad.points[0].z + (quad.points[3].z - quad.points[0].z) * dist_along_segment;
+		double bottom = quad.points[1].z + (quad.points[2].z - quad.points[1].z) * dist_along_segment;
+		if (bottom <= intersection.z && intersection.z <= top)
+		{
+			// Determine selected item from quad flags
+
+			// Side index
+			if (quad.flags & BACK)
+				item.index = line->s2Index();
+			else
+				item.index = line->s1Index();
+
+			// Side part
+			if (quad.flags & UPPER)
+				item.type = MapEditor::ItemType::WallTop;
+			else if (quad.flags & LOWER)
+				item.type = MapEditor::ItemType::WallBottom;
+			else
+				item.type = MapEditor::ItemType::WallMiddle;
+
+			hit = dist;
 		}
 	}
 
-	// Update item distance
-	if (min_dist >= 9999999 || min_dist < 0)
-		item_dist_ = -1;
-	else
-		item_dist_ = MathStuff::round(min_dist);
+	return hit;
+}
 
-	return current;
+// -----------------------------------------------------------------------------
+// Returns the distance along the view vector that it hits the floor (or
+// [ceiling]) of sector [index], or -1 if it doesn't hit it closer than
+// [max_dist]. If it does, [item] is set to the flat
+// -----------------------------------------------------------------------------
+double MapRenderer3D::flatHilightDist(unsigned index, bool ceiling, double max_dist, MapEditor::Item& item) const
+{
+	// Ignore if not rendered yet
+	auto& flat = ceiling ? ceilings_[index] : floors_[index];
+	if (flat.updated_time == 0)
+		return -1;
+
+	// Check distance to plane
+	double dist = MathStuff::distanceRayPlane(cam_position_, cam_dir3d_, flat.plane);
+	if (dist < 0 || dist >= max_dist)
+		return -1;
+
+	// Check if on the correct side of the plane
+	double height = flat.plane.heightAt(cam_position_.x, cam_position_.y);
+	if (ceiling ? cam_position_.z >= height : cam_position_.z <= height)
+		return -1;
+
+	// Check if intersection is within sector
+	if (!map_->sector(index)->containsPoint((cam_position_ + cam_dir3d_ * dist).get2d()))
+		return -1;
+
+	item.index = index;
+	item.type  = ceiling ? MapEditor::ItemType::Ceiling : MapEditor::ItemType::Floor;
+	return dist;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the distance along the view vector that it hits the sprite of thing
+// [index], or -1 if it doesn't hit it closer than [max_dist].
+// If it does, [item] is set to the thing
+// -----------------------------------------------------------------------------
+double MapRenderer3D::thingHilightDist(unsigned index, double max_dist, MapEditor::Item& item) const
+{
+	// Ignore if things aren't shown or no sprite
+	if (render_3d_things == 0 || !things_[index].sprite)
+		return -1;
+
+	// Ignore if not visible
+	auto  thing = map_->thing(index);
+	Seg2d strafe(cam_position_.get2d(), (cam_position_ + cam_strafe_).get2d());
+	if (MathStuff::lineSide(thing->position(), strafe) > 0)
+		return -1;
+
+	// Ignore if not shown
+	if (!things_[index].type->decoration() && render_3d_things == 2)
+		return -1;
+
+	// Find distance to thing sprite
+	auto&  tex_info  = OpenGL::Texture::info(things_[index].sprite);
+	double halfwidth = tex_info.size.x * 0.5;
+	if (things_[index].flags & ICON)
+		halfwidth = render_thing_icon_size * 0.5;
+	double dist = MathStuff::distanceRayLine(
+		cam_position_.get2d(),
+		(cam_position_ + cam_dir3d_).get2d(),
+		thing->position() - cam_strafe_.get2d() * halfwidth,
+		thing->position() + cam_strafe_.get2d() * halfwidth);
+
+	// Ignore if no intersection or something was closer
+	if (dist < 0 || dist >= max_dist)
+		return -1;
+
+	// Check intersection height
+	double theight = tex_info.size.y;
+	double height  = cam_position_.z + cam_dir3d_.z * dist;
+	if (things_[index].flags & ICON)
+		theight = render_thing_icon_size;
+	if (height < things_[index].z || height > things_[index].z + theight)
+		return -1;
+
+	item.index = index;
+	item.type  = MapEditor::ItemType::Thing;
+	return dist;
 }
 
 // -----------------------------------------------------------------------------
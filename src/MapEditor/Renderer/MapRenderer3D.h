@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MapEditor/Edit/Edit3D.h"
+#include "RayCastBVH.h"
 #include "SLADEMap/SLADEMap.h"
 
 class ItemSelection;
@@ -47,10 +48,12 @@ public:
 		GLVertex points[4] = { {}, {}, {}, {} };
 		ColRGBA  colour;
 		ColRGBA  fogcolour;
-		uint8_t  light   = 0;
-		unsigned texture = 0;
-		uint8_t  flags   = 0;
-		float    alpha   = 1.f;
+		uint8_t  light    = 0;
+		unsigned texture  = 0;
+		uint8_t  flags    = 0;
+		float    alpha    = 1.f;
+		int      vbo_slot = -1;
+		unsigned bucket   = 0;
 
 		Quad() : colour{ 255, 255, 255, 255, 0 } {}
 	};
@@ -58,7 +61,7 @@ public:
 	{
 		vector<Quad> quads;
 		long         updated_time = 0;
-		bool         visible      = true;
+		bool         visible      = false;
 		MapLine*     line         = nullptr;
 	};
 	struct Thing
@@ -99,6 +102,7 @@ public:
 	bool init();
 	void refresh();
 	void refreshTextures();
+	void refreshTextures(const vector<unsigned>& textures);
 	void clearData();
 	void buildSkyCircle();
 
@@ -122,11 +126,12 @@ public:
 	Vec2d  camDirection() const { return cam_direction_; }
 
 	// -- Rendering --
-	void setupView(int width, int height);
-	void setLight(ColRGBA& colour, uint8_t light, float alpha = 1.0f) const;
-	void setFog(ColRGBA& fogcol, uint8_t light);
-	void renderMap();
-	void renderSkySlice(
+	void  setupView(int width, int height);
+	float lightMultiplier(uint8_t light) const;
+	void  setLight(ColRGBA& colour, uint8_t light, float alpha = 1.0f) const;
+	void  setFog(ColRGBA& fogcol, uint8_t light);
+	void  renderMap();
+	void  renderSkySlice(
 		float top,
 		float bottom,
 		float atop,
@@ -134,7 +139,7 @@ public:
 		float size,
 		float tx = 0.125f,
 		float ty = 2.0f) const;
-	void renderSky();
+	void  renderSky();
 
 	// Flats
 	void updateFlatTexCoords(unsigned index, bool floor);
@@ -169,9 +174,15 @@ public:
 
 	// VBO stuff
 	void updateFlatsVBO();
-	void updateWallsVBO() const;
+	void updateWallsVBO();
+	void clearWallsVBO();
+	void writeWallQuads(unsigned index);
+	void writeWallQuad(const Quad& quad);
+	void freeWallQuads(Line& line);
+	void renderWallsVBO();
 
 	// Visibility checking
+	void  checkVisibleSectors();
 	void  quickVisDiscard();
 	float calcDistFade(double distance, double max = -1) const;
 	void  checkVisibleQuads();
@@ -180,6 +191,13 @@ public:
 	// Hilight
 	MapEditor::Item determineHilight();
 	void            renderHilight(MapEditor::Item hilight, float alpha = 1.0f);
+	void            updateHilightBVH();
+	RayCastBVH::Box lineHilightBox(unsigned index) const;
+	RayCastBVH::Box flatHilightBox(unsigned index, bool ceiling) const;
+	RayCastBVH::Box thingHilightBox(unsigned index) const;
+	double          wallHilightDist(unsigned index, double max_dist, MapEditor::Item& item) const;
+	double          flatHilightDist(unsigned index, bool ceiling, double max_dist, MapEditor::Item& item) const;
+	double          thingHilightDist(unsigned index, double max_dist, MapEditor::Item& item) const;
 
 private:
 	SLADEMap* map_;
@@ -193,8 +211,32 @@ private:
 	ColRGBA   fog_colour_last_;
 	float     fog_depth_last_ = 0.f;
 
+	// Hilight ray cast structure, items are all lines, then all floors, then all
+	// ceilings, then all things
+	RayCastBVH hilight_bvh_;
+	unsigned   hilight_n_lines_   = 0;
+	unsigned   hilight_n_sectors_ = 0;
+	unsigned   hilight_n_things_  = 0;
+
 	// Visibility
-	vector<float> dist_sectors_;
+	struct SectorVis
+	{
+		float left   = 0.f; // Widest view angle range the sector was checked with
+		float right  = 0.f;
+		int   passes = 0;
+	};
+	struct PortalView
+	{
+		MapSector* sector;
+		float      left;
+		float      right;
+		float      dist;
+	};
+	vector<float>      dist_sectors_;
+	vector<SectorVis>  vis_sectors_info_;
+	vector<unsigned>   vis_sectors_;
+	vector<unsigned>   vis_lines_;
+	vector<PortalView> vis_stack_;
 
 	// Camera
 	Vec3d  cam_position_;
@@ -220,6 +262,35 @@ private:
 	unsigned vbo_ceilings_ = 0;
 	unsigned vbo_walls_    = 0;
 
+	// Walls VBO data, each quad is written to its own 'slot' of 4 vertices.
+	// Opaque quads are grouped into buckets by texture and other render state,
+	// and each bucket is drawn with a single call
+	struct WallVertex
+	{
+		float   x = 0.f, y = 0.f, z = 0.f;
+		float   tx = 0.f, ty = 0.f;
+		uint8_t r = 255, g = 255, b = 255, a = 255;
+	};
+	struct WallBucket
+	{
+		unsigned         texture = 0;
+		uint8_t          flags   = 0;
+		ColRGBA          fogcolour;
+		uint8_t          light = 0;
+		vector<unsigned> indices;
+	};
+	typedef std::tuple<unsigned, uint8_t, uint32_t> WallBucketKey;
+
+	vector<WallVertex>                wall_vertices_;
+	vector<unsigned>                  wall_free_slots_;
+	vector<WallBucket>                wall_buckets_;
+	std::map<WallBucketKey, unsigned> wall_bucket_ids_;
+	unsigned                          wall_vbo_size_    = 0;
+	unsigned                          wall_dirty_begin_ = 0;
+	unsigned                          wall_dirty_end_   = 0;
+	bool                              wall_fullbright_  = false;
+	double                            wall_brightness_  = 1.;
+
 	// Sky
 	struct GLVertexEx
 	{
@@ -0,0 +1,344 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    RayCastBVH.cpp
+// Description: A bounding volume hierarchy of 3d boxes, used to quickly find
+//              the closest object along a ray (eg. for 3d mode hilighting).
+//              Items are identified by their index in the list of boxes given
+//              to build, and the actual intersection test for each item is
+//              done by a callback. Item boxes can be updated without a full
+//              rebuild, in which case the hierarchy is refitted on the next
+//              cast
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "RayCastBVH.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr unsigned MAX_LEAF_ITEMS = 4;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// RayCastBVH::Box Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Extends the box to contain [point]
+// -----------------------------------------------------------------------------
+void RayCastBVH::Box::extend(const Vec3f& point)
+{
+	if (!valid())
+	{
+		min = point;
+		max = point;
+		return;
+	}
+
+	min.set(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+	max.set(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+}
+
+// -----------------------------------------------------------------------------
+// Extends the box to contain [box]
+// -----------------------------------------------------------------------------
+void RayCastBVH::Box::extend(const Box& box)
+{
+	if (!box.valid())
+		return;
+
+	extend(box.min);
+	extend(box.max);
+}
+
+// -----------------------------------------------------------------------------
+// Grows the box by [amount] in all directions
+// -----------------------------------------------------------------------------
+void RayCastBVH::Box::pad(float amount)
+{
+	if (!valid())
+		return;
+
+	min.set(min.x - amount, min.y - amount, min.z - amount);
+	max.set(max.x + amount, max.y + amount, max.z + amount);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// RayCastBVH Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Clears all items and nodes
+// -----------------------------------------------------------------------------
+void RayCastBVH::clear()
+{
+	boxes_.clear();
+	nodes_.clear();
+	order_.clear();
+	refit_   = false;
+	updates_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// (Re)builds the hierarchy from [boxes]. Items with invalid (empty) boxes are
+// never hit until they are given a valid box via update
+// -----------------------------------------------------------------------------
+void RayCastBVH::build(vector<Box> boxes)
+{
+	boxes_ = std::move(boxes);
+	nodes_.clear();
+	order_.resize(boxes_.size());
+	for (unsigned a = 0; a < boxes_.size(); a++)
+		order_[a] = a;
+	refit_   = false;
+	updates_ = 0;
+
+	if (boxes_.empty())
+		return;
+
+	nodes_.reserve(boxes_.size() * 2 / MAX_LEAF_ITEMS + 1);
+	nodes_.emplace_back();
+	buildNode(0, 0, boxes_.size());
+}
+
+// -----------------------------------------------------------------------------
+// Sets the box for item [id]
+// -----------------------------------------------------------------------------
+void RayCastBVH::update(unsigned id, const Box& box)
+{
+	if (id >= boxes_.size())
+		return;
+
+	boxes_[id] = box;
+	refit_     = true;
+	updates_++;
+}
+
+// -----------------------------------------------------------------------------
+// Casts a ray from [origin] along [dir], calling [hit_func] for each item
+// whose box is hit closer than the closest hit so far (which starts at
+// [dist]). [hit_func] should return the distance along the ray it hits the
+// item (anything >= the max_dist given means no hit).
+// Items are checked roughly front-to-back so most can be skipped. Returns the
+// id of the closest item hit (or -1 if none), with its distance in [dist]
+// -----------------------------------------------------------------------------
+int RayCastBVH::cast(Vec3d origin, Vec3d dir, const HitFunc& hit_func, double& dist)
+{
+	// Rebuild if the boxes have changed a lot since the last build, otherwise
+	// just refit if needed
+	if (updates_ > boxes_.size() / 2 + 64)
+		build(std::move(boxes_));
+	else if (refit_)
+		refit();
+
+	if (nodes_.empty())
+		return -1;
+
+	Vec3d inv_dir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+	int   hit_id = -1;
+
+	stack_.clear();
+	stack_.push_back(0);
+	while (!stack_.empty())
+	{
+		auto& node = nodes_[stack_.back()];
+		stack_.pop_back();
+
+		if (rayEntry(node.box, origin, inv_dir, dist) >= dist)
+			continue;
+
+		// Leaf, check items
+		if (node.count > 0)
+		{
+			for (unsigned a = node.first; a < node.first + node.count; a++)
+			{
+				auto id = order_[a];
+				if (rayEntry(boxes_[id], origin, inv_dir, dist) >= dist)
+					continue;
+
+				double hit = hit_func(id, dist);
+				if (hit >= 0 && hit < dist)
+				{
+					dist   = hit;
+					hit_id = id;
+				}
+			}
+
+			continue;
+		}
+
+		// Internal, check the nearest child first
+		double near_left  = rayEntry(nodes_[node.first].box, origin, inv_dir, dist);
+		double near_right = rayEntry(nodes_[node.first + 1].box, origin, inv_dir, dist);
+		if (near_left < near_right)
+		{
+			stack_.push_back(node.first + 1);
+			stack_.push_back(node.first);
+		}
+		else
+		{
+			stack_.push_back(node.first);
+			stack_.push_back(node.first + 1);
+		}
+	}
+
+	return hit_id;
+}
+
+// -----------------------------------------------------------------------------
+// Builds node [index] containing [count] items in order_ from [first],
+// splitting it at the median along its longest axis
+// -----------------------------------------------------------------------------
+void RayCastBVH::buildNode(unsigned index, unsigned first, unsigned count)
+{
+	// Get bounds of item boxes and their centres
+	Box bounds, centres;
+	for (unsigned a = first; a < first + count; a++)
+	{
+		auto& box = boxes_[order_[a]];
+		bounds.extend(box);
+		if (box.valid())
+			centres.extend(
+				Vec3f((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f));
+	}
+	nodes_[index].box = bounds;
+
+	// Make a leaf if there are few enough items (or they can't be split)
+	if (count <= MAX_LEAF_ITEMS || !centres.valid())
+	{
+		nodes_[index].first = first;
+		nodes_[index].count = count;
+		return;
+	}
+
+	// Split at the median along the longest axis
+	float ex   = centres.max.x - centres.min.x;
+	float ey   = centres.max.y - centres.min.y;
+	float ez   = centres.max.z - centres.min.z;
+	int   axis = ex >= ey && ex >= ez ? 0 : (ey >= ez ? 1 : 2);
+
+	// (Invalid boxes go at the end)
+	auto key = [this, axis](unsigned id) {
+		auto& box = boxes_[id];
+		if (!box.valid())
+			return std::numeric_limits<float>::max();
+		if (axis == 0)
+			return box.min.x + box.max.x;
+		if (axis == 1)
+			return box.min.y + box.max.y;
+		return box.min.z + box.max.z;
+	};
+
+	unsigned half = count / 2;
+	std::nth_element(
+		order_.begin() + first,
+		order_.begin() + first + half,
+		order_.begin() + first + count,
+		[&key](unsigned left, unsigned right) { return key(left) < key(right); });
+
+	// Build children (stored after the parent so refitting can go backwards)
+	unsigned child      = nodes_.size();
+	nodes_[index].first = child;
+	nodes_[index].count = 0;
+	nodes_.emplace_back();
+	nodes_.emplace_back();
+	buildNode(child, first, half);
+	buildNode(child + 1, first + half, count - half);
+}
+
+// -----------------------------------------------------------------------------
+// Recalculates all node boxes from the current item boxes
+// -----------------------------------------------------------------------------
+void RayCastBVH::refit()
+{
+	for (int a = (int)nodes_.size() - 1; a >= 0; a--)
+	{
+		auto& node = nodes_[a];
+		node.box   = {};
+		if (node.count > 0)
+		{
+			for (unsigned i = node.first; i < node.first + node.count; i++)
+				node.box.extend(boxes_[order_[i]]);
+		}
+		else
+		{
+			node.box.extend(nodes_[node.first].box);
+			node.box.extend(nodes_[node.first + 1].box);
+		}
+	}
+
+	refit_ = false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the distance along the ray from [origin] (with inverse direction
+// [inv_dir]) that it enters [box], or [max_dist] if it doesn't hit the box
+// closer than that
+// -----------------------------------------------------------------------------
+double RayCastBVH::rayEntry(const Box& box, const Vec3d& origin, const Vec3d& inv_dir, double max_dist) const
+{
+	if (!box.valid())
+		return max_dist;
+
+	double t_min = 0;
+	double t_max = max_dist;
+
+	// Clips t_min/t_max to a pair of planes on one axis
+	auto slab = [&](double o, double inv, float b_min, float b_max) {
+		// Ray parallel to slab
+		if (std::isinf(inv))
+			return o >= b_min && o <= b_max;
+
+		double t1 = (b_min - o) * inv;
+		double t2 = (b_max - o) * inv;
+		if (t1 > t2)
+			std::swap(t1, t2);
+		t_min = std::max(t_min, t1);
+		t_max = std::min(t_max, t2);
+		return t_min <= t_max;
+	};
+
+	if (slab(origin.x, inv_dir.x, box.min.x, box.max.x) && slab(origin.y, inv_dir.y, box.min.y, box.max.y)
+		&& slab(origin.z, inv_dir.z, box.min.z, box.max.z))
+		return t_min;
+
+	return max_dist;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+
+class RayCastBVH
+{
+public:
+	struct Box
+	{
+		Vec3f min{ 1.f, 1.f, 1.f };
+		Vec3f max{ -1.f, -1.f, -1.f };
+
+		bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		void extend(const Vec3f& point);
+		void extend(const Box& box);
+		void pad(float amount);
+	};
+	typedef std::function<double(unsigned id, double max_dist)> HitFunc;
+
+	RayCastBVH()  = default;
+	~RayCastBVH() = default;
+
+	unsigned size() const { return boxes_.size(); }
+
+	void clear();
+	void build(vector<Box> boxes);
+	void update(unsigned id, const Box& box);
+	int  cast(Vec3d origin, Vec3d dir, const HitFunc& hit_func, double& dist);
+
+private:
+	struct Node
+	{
+		Box      box;
+		unsigned first = 0; // First child node index (internal) or first item in order_ (leaf)
+		unsigned count = 0; // Number of items (0 for internal nodes)
+	};
+
+	vector<Box>      boxes_;
+	vector<Node>     nodes_;
+	vector<unsigned> order_;
+	vector<unsigned> stack_;
+	bool             refit_   = false;
+	unsigned         updates_ = 0;
+
+	void   buildNode(unsigned index, unsigned first, unsigned count);
+	void   refit();
+	double rayEntry(const Box& box, const Vec3d& origin, const Vec3d& inv_dir, double max_dist) const;
+};
@@ -38,6 +38,7 @@
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/MapTextureManager.h"
 #include "OpenGL/Drawing.h"
 #include "OpenGL/OpenGL.h"
 #include "Overlays/MCOverlay.h"
@@ -1221,6 +1222,15 @@ void Renderer::drawMap3d()
 // -----------------------------------------------------------------------------
 void Renderer::draw()
 {
+	// Upload any textures loaded in the background since the last frame, and
+	// refresh anything drawn with them
+	vector<unsigned> uploaded;
+	if (MapEditor::textureManager().uploadLoaded(uploaded))
+	{
+		renderer_2d_.refreshTextures(uploaded);
+		renderer_3d_.refreshTextures(uploaded);
+	}
+
 	// Setup the viewport
 	glViewport(0, 0, view_.size().x, view_.size().y);
 
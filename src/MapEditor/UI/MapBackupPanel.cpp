@@ -31,9 +31,9 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapBackupPanel.h"
-#include "App.h"
-#include "Archive/Formats/WadArchive.h"
-#include "Archive/Formats/ZipArchive.h"
+#include "Archive/Archive.h"
+#include "MapEditor/MapBackupManager.h"
+#include "MapEditor/MapEditor.h"
 #include "UI/Canvas/MapPreviewCanvas.h"
 #include "UI/Lists/ListView.h"
 #include "UI/WxUtils.h"
@@ -49,7 +49,7 @@
 // -----------------------------------------------------------------------------
 // MapBackupPanel class constructor
 // -----------------------------------------------------------------------------
-MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }, archive_backups_{ new ZipArchive() }
+MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }
 {
 	// Setup Sizer
 	auto sizer = new wxBoxSizer(wxHORIZONTAL);
@@ -68,20 +68,16 @@ MapBackupPanel::MapBackupPanel(wxWindow* parent) : wxPanel{ parent, -1 }, archiv
 }
 
 // -----------------------------------------------------------------------------
-// Opens the map backup file for [map_name] in [archive_name] and populates the
-// list
+// Gets the list of map backups for [map_name] in [archive_name] and populates
+// the list
 // -----------------------------------------------------------------------------
 bool MapBackupPanel::loadBackups(wxString archive_name, const wxString& map_name)
 {
-	// Open backup file
-	archive_name.Replace(".", "_");
-	auto backup_file = App::path("backups", App::Dir::User) + "/" + archive_name.ToStdString() + "_backup.zip";
-	if (!archive_backups_->open(backup_file))
-		return false;
-
-	// Get backup dir for map
-	dir_current_ = archive_backups_->dirAtPath(map_name.ToStdString());
-	if (dir_current_ == archive_backups_->rootDir().get() || !dir_current_)
+	// Get backups for map
+	archive_name_ = archive_name.ToStdString();
+	map_name_     = map_name.ToStdString();
+	backups_      = MapEditor::backupManager().backupTimestamps(archive_name_, map_name_);
+	if (backups_.empty())
 		return false;
 
 	// Populate backups list
@@ -90,9 +86,9 @@ bool MapBackupPanel::loadBackups(wxString archive_name, const wxString& map_name
 	list_backups_->AppendColumn("Time");
 
 	int index = 0;
-	for (int a = dir_current_->numSubdirs() - 1; a >= 0; a--)
+	for (int a = (int)backups_.size() - 1; a >= 0; a--)
 	{
-		wxString      timestamp = dir_current_->subdirAt(a)->name();
+		wxString      timestamp = backups_[a];
 		wxArrayString cols;
 
 		// Date
@@ -126,10 +122,9 @@ void MapBackupPanel::updateMapPreview()
 	int selection = (list_backups_->GetItemCount() - 1) - list_backups_->selectedItems()[0];
 
 	// Load map data to temporary wad
-	archive_mapdata_ = std::make_unique<WadArchive>();
-	auto dir         = dir_current_->subdirAt(selection);
-	for (unsigned a = 0; a < dir->numEntries(); a++)
-		archive_mapdata_->addEntry(std::make_shared<ArchiveEntry>(*dir->entryAt(a)), "");
+	archive_mapdata_ = MapEditor::backupManager().backupMapData(archive_name_, map_name_, backups_[selection]);
+	if (!archive_mapdata_)
+		return;
 
 	// Open map preview
 	auto maps = archive_mapdata_->detectMaps();
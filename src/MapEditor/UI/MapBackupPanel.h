@@ -2,8 +2,6 @@
 
 class MapPreviewCanvas;
 class Archive;
-class ZipArchive;
-class ArchiveDir;
 class ListView;
 
 class MapBackupPanel : public wxPanel
@@ -18,9 +16,10 @@ public:
 	void updateMapPreview();
 
 private:
-	MapPreviewCanvas*      canvas_map_   = nullptr;
-	ListView*              list_backups_ = nullptr;
-	unique_ptr<ZipArchive> archive_backups_;
-	unique_ptr<Archive>    archive_mapdata_;
-	ArchiveDir*            dir_current_ = nullptr;
+	MapPreviewCanvas*   canvas_map_   = nullptr;
+	ListView*           list_backups_ = nullptr;
+	unique_ptr<Archive> archive_mapdata_;
+	string              archive_name_;
+	string              map_name_;
+	vector<string>      backups_;
 };
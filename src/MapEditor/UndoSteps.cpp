@@ -39,182 +39,73 @@ bool PropertyChangeUS::doRedo()
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
-	auto map = UndoRedo::currentMap();
-	map->mapData().putObjectIdList(MapObject::Type::Vertex, vertices_);
-	map->mapData().putObjectIdList(MapObject::Type::Line, lines_);
-	map->mapData().putObjectIdList(MapObject::Type::Side, sides_);
-	map->mapData().putObjectIdList(MapObject::Type::Sector, sectors_);
-	map->mapData().putObjectIdList(MapObject::Type::Thing, things_);
+	UndoRedo::currentMap()->mapData().beginListChangeRecord();
 }
 
-void MapObjectCreateDeleteUS::swapLists()
+void MapObjectCreateDeleteUS::applyChanges(bool undo)
 {
-	// Backup
-	vector<unsigned> vertices;
-	vector<unsigned> lines;
-	vector<unsigned> sides;
-	vector<unsigned> sectors;
-	vector<unsigned> things;
-	auto             map = UndoRedo::currentMap();
-	if (isValid(vertices_))
-		map->mapData().putObjectIdList(MapObject::Type::Vertex, vertices);
-	if (isValid(lines_))
-		map->mapData().putObjectIdList(MapObject::Type::Line, lines);
-	if (isValid(sides_))
-		map->mapData().putObjectIdList(MapObject::Type::Side, sides);
-	if (isValid(sectors_))
-		map->mapData().putObjectIdList(MapObject::Type::Sector, sectors);
-	if (isValid(things_))
-		map->mapData().putObjectIdList(MapObject::Type::Thing, things);
+	auto  map  = UndoRedo::currentMap();
+	auto& data = map->mapData();
 
-	// Restore
-	if (isValid(vertices_))
+	if (!vertices_.empty())
 	{
-		map->restoreObjectIdList(MapObject::Type::Vertex, vertices_);
-		vertices_ = vertices;
+		data.applyListChanges(MapObject::Type::Vertex, vertices_, undo);
 		map->updateGeometryInfo(0);
 	}
-	if (isValid(lines_))
+	if (!lines_.empty())
 	{
-		map->restoreObjectIdList(MapObject::Type::Line, lines_);
-		lines_ = lines;
+		data.applyListChanges(MapObject::Type::Line, lines_, undo);
 		map->updateGeometryInfo(0);
 	}
-	if (isValid(sides_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Side, sides_);
-		sides_ = sides;
-	}
-	if (isValid(sectors_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Sector, sectors_);
-		sectors_ = sectors;
-	}
-	if (isValid(things_))
-	{
-		map->restoreObjectIdList(MapObject::Type::Thing, things_);
-		things_ = things;
-	}
+	if (!sides_.empty())
+		data.applyListChanges(MapObject::Type::Side, sides_, undo);
+	if (!sectors_.empty())
+		data.applyListChanges(MapObject::Type::Sector, sectors_, undo);
+	if (!things_.empty())
+		data.applyListChanges(MapObject::Type::Thing, things_, undo);
 }
 
 bool MapObjectCreateDeleteUS::doUndo()
 {
-	swapLists();
+	applyChanges(true);
 	return true;
 }
 
 bool MapObjectCreateDeleteUS::doRedo()
 {
-	swapLists();
+	applyChanges(false);
 	return true;
 }
 
 void MapObjectCreateDeleteUS::checkChanges()
 {
-	auto map = UndoRedo::currentMap();
+	auto& data = UndoRedo::currentMap()->mapData();
 
-	// Check vertices changed
-	bool vertices_changed = false;
-	if (map->nVertices() != vertices_.size())
-		vertices_changed = true;
-	else
-		for (unsigned a = 0; a < map->nVertices(); a++)
-			if (map->vertex(a)->objId() != vertices_[a])
-			{
-				vertices_changed = true;
-				break;
-			}
-	if (!vertices_changed)
-	{
-		// No change, clear
-		vertices_.clear();
-		vertices_.push_back(0);
+	data.putListChanges(MapObject::Type::Vertex, vertices_);
+	if (vertices_.empty())
 		Log::info(3, "MapObjectCreateDeleteUS: No vertices added/deleted");
-	}
 
-	// Check lines changed
-	bool lines_changed = false;
-	if (map->nLines() != lines_.size())
-		lines_changed = true;
-	else
-		for (unsigned a = 0; a < map->nLines(); a++)
-			if (map->line(a)->objId() != lines_[a])
-			{
-				lines_changed = true;
-				break;
-			}
-	if (!lines_changed)
-	{
-		// No change, clear
-		lines_.clear();
-		lines_.push_back(0);
+	data.putListChanges(MapObject::Type::Line, lines_);
+	if (lines_.empty())
 		Log::info(3, "MapObjectCreateDeleteUS: No lines added/deleted");
-	}
 
-	// Check sides changed
-	bool sides_changed = false;
-	if (map->nSides() != sides_.size())
-		sides_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSides(); a++)
-			if (map->side(a)->objId() != sides_[a])
-			{
-				sides_changed = true;
-				break;
-			}
-	if (!sides_changed)
-	{
-		// No change, clear
-		sides_.clear();
-		sides_.push_back(0);
+	data.putListChanges(MapObject::Type::Side, sides_);
+	if (sides_.empty())
 		Log::info(3, "MapObjectCreateDeleteUS: No sides added/deleted");
-	}
 
-	// Check sectors changed
-	bool sectors_changed = false;
-	if (map->nSectors() != sectors_.size())
-		sectors_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSectors(); a++)
-			if (map->sector(a)->objId() != sectors_[a])
-			{
-				sectors_changed = true;
-				break;
-			}
-	if (!sectors_changed)
-	{
-		// No change, clear
-		sectors_.clear();
-		sectors_.push_back(0);
+	data.putListChanges(MapObject::Type::Sector, sectors_);
+	if (sectors_.empty())
 		Log::info(3, "MapObjectCreateDeleteUS: No sectors added/deleted");
-	}
 
-	// Check things changed
-	bool things_changed = false;
-	if (map->nThings() != things_.size())
-		things_changed = true;
-	else
-		for (unsigned a = 0; a < map->nThings(); a++)
-			if (map->thing(a)->objId() != things_[a])
-			{
-				things_changed = true;
-				break;
-			}
-	if (!things_changed)
-	{
-		// No change, clear
-		things_.clear();
-		things_.push_back(0);
+	data.putListChanges(MapObject::Type::Thing, things_);
+	if (things_.empty())
 		Log::info(3, "MapObjectCreateDeleteUS: No things added/deleted");
-	}
 }
 
 bool MapObjectCreateDeleteUS::isOk()
 {
 	// Check for any changes at all
-	return !(
-		vertices_.size() == 1 && vertices_[0] == 0 && lines_.size() == 1 && lines_[0] == 0 && sides_.size() == 1
-		&& sides_[0] == 0 && sectors_.size() == 1 && sectors_[0] == 0 && things_.size() == 1 && things_[0] == 0);
+	return !(vertices_.empty() && lines_.empty() && sides_.empty() && sectors_.empty() && things_.empty());
 }
 
 
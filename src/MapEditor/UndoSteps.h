@@ -2,6 +2,7 @@
 
 #include "General/UndoRedo.h"
 #include "SLADEMap/MapObject/MapObject.h"
+#include "SLADEMap/MapObjectList/MapObjectList.h"
 
 namespace MapEditor
 {
@@ -27,19 +28,18 @@ public:
 	MapObjectCreateDeleteUS();
 	~MapObjectCreateDeleteUS() = default;
 
-	bool isValid(vector<unsigned>& list) const { return !(list.size() == 1 && list[0] == 0); }
-	void swapLists();
+	void applyChanges(bool undo);
 	bool doUndo() override;
 	bool doRedo() override;
 	void checkChanges();
 	bool isOk() override;
 
 private:
-	vector<unsigned> vertices_;
-	vector<unsigned> lines_;
-	vector<unsigned> sides_;
-	vector<unsigned> sectors_;
-	vector<unsigned> things_;
+	MapObjectListChanges vertices_;
+	MapObjectListChanges lines_;
+	MapObjectListChanges sides_;
+	MapObjectListChanges sectors_;
+	MapObjectListChanges things_;
 };
 
 // UndoStep for when multiple MapObjects have properties changed
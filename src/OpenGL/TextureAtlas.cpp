@@ -0,0 +1,268 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureAtlas.cpp
+// Description: Packs small images into shared OpenGL texture 'pages', so that
+//              many of them can be drawn without switching textures. Each
+//              image added is identified by a key (eg. the id of its own
+//              standalone OpenGL texture) and given a region on a page
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureAtlas.h"
+#include "Graphics/SImage/SImage.h"
+#include "OpenGL.h"
+
+using namespace OpenGL;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Empty space around each region, so neighbouring images don't bleed into
+// each other when filtered
+constexpr int REGION_PADDING = 1;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureAtlas Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// TextureAtlas class constructor.
+// Pages are [page_size] square, and only images up to [max_size] in either
+// dimension are added
+// -----------------------------------------------------------------------------
+TextureAtlas::TextureAtlas(int page_size, int max_size) : page_size_{ page_size }, max_size_{ max_size } {}
+
+// -----------------------------------------------------------------------------
+// Returns the region for [key], or nullptr if it isn't in the atlas
+// -----------------------------------------------------------------------------
+const TextureAtlas::Region* TextureAtlas::region(unsigned key) const
+{
+	auto i = regions_.find(key);
+	return i != regions_.end() ? &i->second.region : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [image] (using [pal] if necessary) to the atlas as [key], replacing any
+// existing region for it. Returns the new region, or nullptr if the image is
+// too big (or empty) or couldn't be added
+// -----------------------------------------------------------------------------
+const TextureAtlas::Region* TextureAtlas::add(unsigned key, const SImage& image, Palette* pal)
+{
+	remove(key);
+
+	// Check image size
+	int width  = image.width();
+	int height = image.height();
+	if (width <= 0 || height <= 0 || width > max_size_ || height > max_size_)
+		return nullptr;
+
+	// Check OpenGL is initialised
+	if (!isInitialised())
+		return nullptr;
+
+	// Get image data
+	MemChunk rgba;
+	if (!image.putRGBAData(rgba, pal))
+		return nullptr;
+
+	// Find space on an existing page
+	Slot     slot;
+	unsigned page_index = 0;
+	while (page_index < pages_.size() && !allocate(pages_[page_index], width, height, slot))
+		++page_index;
+
+	// Otherwise add a new page
+	if (page_index == pages_.size())
+	{
+		page_size_ = std::min<int>(page_size_, maxTextureSize());
+
+		Page new_page;
+		new_page.gl_id = Texture::create(filter_, false);
+		vector<uint8_t> blank(page_size_ * page_size_ * 4, 0);
+		if (!Texture::loadData(new_page.gl_id, blank.data(), page_size_, page_size_))
+		{
+			Texture::clear(new_page.gl_id);
+			return nullptr;
+		}
+
+		pages_.push_back(new_page);
+		if (!allocate(pages_.back(), width, height, slot))
+			return nullptr;
+	}
+
+	auto& page = pages_[page_index];
+	Texture::bind(page.gl_id);
+
+	// Clear the slot first if it was freed by a bigger image, so that none of
+	// the previous image is left around the new one
+	if (slot.size.x != width + REGION_PADDING * 2 || slot.size.y != height + REGION_PADDING * 2)
+	{
+		vector<uint8_t> blank(slot.size.x * slot.size.y * 4, 0);
+		glTexSubImage2D(
+			GL_TEXTURE_2D, 0, slot.pos.x, slot.pos.y, slot.size.x, slot.size.y, GL_RGBA, GL_UNSIGNED_BYTE, blank.data());
+	}
+
+	// Upload image data to the page
+	Vec2i pos = { slot.pos.x + REGION_PADDING, slot.pos.y + REGION_PADDING };
+	glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+	// Add region
+	auto& entry      = regions_[key];
+	entry.page_index = page_index;
+	entry.slot       = slot;
+	page.n_regions++;
+
+	auto& region  = entry.region;
+	region.page   = page.gl_id;
+	region.tex_tl = { (float)pos.x / page_size_, (float)pos.y / page_size_ };
+	region.tex_br = { (float)(pos.x + width) / page_size_, (float)(pos.y + height) / page_size_ };
+	region.size   = { width, height };
+
+	return &region;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the region for [key] from the atlas, freeing its space for reuse
+// -----------------------------------------------------------------------------
+void TextureAtlas::remove(unsigned key)
+{
+	auto i = regions_.find(key);
+	if (i == regions_.end())
+		return;
+
+	auto& page = pages_[i->second.page_index];
+	auto  slot = i->second.slot;
+	regions_.erase(i);
+
+	// Reset the page once it's empty, so all of it can be reused
+	if (--page.n_regions == 0)
+	{
+		page.row_x = 0;
+		page.row_y = 0;
+		page.row_h = 0;
+		page.free_slots.clear();
+	}
+
+	// Give the space back to the current row if the slot was at the end of it
+	else if (slot.pos.y == page.row_y && slot.pos.x + slot.size.x == page.row_x)
+		page.row_x = slot.pos.x;
+
+	// Otherwise keep the slot for images that fit in it
+	else
+		page.free_slots.push_back(slot);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the texture filter to use for atlas pages. The atlas is cleared if the
+// filter changes. Mipmapped filters aren't supported (since regions would
+// bleed into each other at lower mip levels) so are replaced by their
+// non-mipmapped equivalent
+// -----------------------------------------------------------------------------
+void TextureAtlas::setFilter(TexFilter filter)
+{
+	if (filter == TexFilter::Mipmap || filter == TexFilter::LinearMipmap)
+		filter = TexFilter::Linear;
+	else if (filter == TexFilter::NearestMipmap)
+		filter = TexFilter::NearestLinearMin;
+
+	if (filter != filter_)
+	{
+		clear();
+		filter_ = filter;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes all regions and pages
+// -----------------------------------------------------------------------------
+void TextureAtlas::clear()
+{
+	for (auto& page : pages_)
+		Texture::clear(page.gl_id);
+
+	pages_.clear();
+	regions_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Finds space for an image of [width]x[height] on [page], writing the slot
+// (including padding) it will occupy to [slot]. The smallest freed slot that
+// fits is reused if possible, otherwise regions are packed in rows ('shelves')
+// from top to bottom. Returns false if there isn't enough space left on the
+// page (in which case the page is unchanged)
+// -----------------------------------------------------------------------------
+bool TextureAtlas::allocate(Page& page, int width, int height, Slot& slot) const
+{
+	width += REGION_PADDING * 2;
+	height += REGION_PADDING * 2;
+
+	// Check freed slots
+	auto best = page.free_slots.end();
+	for (auto i = page.free_slots.begin(); i != page.free_slots.end(); ++i)
+		if (i->size.x >= width && i->size.y >= height
+			&& (best == page.free_slots.end() || i->size.x * i->size.y < best->size.x * best->size.y))
+			best = i;
+	if (best != page.free_slots.end())
+	{
+		slot = *best;
+		page.free_slots.erase(best);
+		return true;
+	}
+
+	// Start a new row if the image doesn't fit on the current one
+	int row_x = page.row_x;
+	int row_y = page.row_y;
+	int row_h = page.row_h;
+	if (row_x + width > page_size_)
+	{
+		row_y += row_h;
+		row_x = 0;
+		row_h = 0;
+	}
+
+	// Check there is enough vertical space
+	if (row_y + height > page_size_)
+		return false;
+
+	slot.pos   = { row_x, row_y };
+	slot.size  = { width, height };
+	page.row_x = row_x + width;
+	page.row_y = row_y;
+	page.row_h = std::max(row_h, height);
+
+	return true;
+}
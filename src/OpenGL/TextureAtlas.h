@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GLTexture.h"
+#include <unordered_map>
+
+namespace OpenGL
+{
+class TextureAtlas
+{
+public:
+	struct Region
+	{
+		unsigned page = 0; // OpenGL texture id of the page the region is on
+		Vec2f    tex_tl;   // Top-left texture coordinates
+		Vec2f    tex_br;   // Bottom-right texture coordinates
+		Vec2i    size;
+	};
+
+	TextureAtlas(int page_size = 1024, int max_size = 256);
+	~TextureAtlas() { clear(); }
+
+	TexFilter     filter() const { return filter_; }
+	unsigned      nPages() const { return pages_.size(); }
+	const Region* region(unsigned key) const;
+
+	const Region* add(unsigned key, const SImage& image, Palette* pal = nullptr);
+	void          remove(unsigned key);
+	void          setFilter(TexFilter filter);
+	void          clear();
+
+private:
+	struct Slot
+	{
+		Vec2i pos; // Top-left of the slot (including padding)
+		Vec2i size;
+	};
+	struct Page
+	{
+		unsigned     gl_id     = 0;
+		int          row_x     = 0; // Next free position in the current row
+		int          row_y     = 0; // Top of the current row
+		int          row_h     = 0; // Height of the current row
+		unsigned     n_regions = 0;
+		vector<Slot> free_slots; // Space freed by removed regions
+	};
+	struct Entry
+	{
+		Region   region;
+		unsigned page_index = 0;
+		Slot     slot;
+	};
+
+	int                                 page_size_;
+	int                                 max_size_;
+	TexFilter                           filter_ = TexFilter::NearestLinearMin;
+	vector<Page>                        pages_;
+	std::unordered_map<unsigned, Entry> regions_;
+
+	bool allocate(Page& page, int width, int height, Slot& slot) const;
+};
+} // namespace OpenGL
@@ -386,7 +386,10 @@ void MapLine::setIntProperty(string_view key, int value)
 
 	// Id
 	else if (key == PROP_ID)
+	{
 		id_ = value;
+		updateIdIndex();
+	}
 
 	// Flags
 	else if (key == PROP_FLAGS)
@@ -394,15 +397,30 @@ void MapLine::setIntProperty(string_view key, int value)
 
 	// Args
 	else if (key == PROP_ARG0)
+	{
 		args_[0] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG1)
+	{
 		args_[1] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG2)
+	{
 		args_[2] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG3)
+	{
 		args_[3] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG4)
+	{
 		args_[4] = value;
+		updateIdIndex();
+	}
 
 	// Line property
 	else
@@ -533,6 +551,7 @@ void MapLine::setId(int id)
 {
 	setModified();
 	id_ = id;
+	updateIdIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -571,6 +590,7 @@ void MapLine::setArg(unsigned index, int value)
 	{
 		setModified();
 		args_[index] = value;
+		updateIdIndex();
 	}
 }
 
@@ -845,6 +865,19 @@ void MapLine::resetInternals()
 		s2->resetPolygon();
 		s2->resetBBox();
 	}
+
+	// Update spatial index
+	if (parent_map_)
+		parent_map_->lines().updateSpatialIndex(this);
+}
+
+// -----------------------------------------------------------------------------
+// Updates the line in the map's id indices, after its id or args were changed
+// -----------------------------------------------------------------------------
+void MapLine::updateIdIndex()
+{
+	if (parent_map_)
+		parent_map_->lines().updateIdIndex(this);
 }
 
 // -----------------------------------------------------------------------------
@@ -948,6 +981,7 @@ void MapLine::readBackup(Backup* backup)
 	args_[2] = backup->props_internal[PROP_ARG2];
 	args_[3] = backup->props_internal[PROP_ARG3];
 	args_[4] = backup->props_internal[PROP_ARG4];
+	updateIdIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -976,6 +1010,7 @@ void MapLine::copy(MapObject* c)
 	args_[2] = l->args_[2];
 	args_[3] = l->args_[3];
 	args_[4] = l->args_[4];
+	updateIdIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -136,4 +136,6 @@ private:
 	double ca_     = 0.; // Used for intersection calculations
 	double sa_     = 0.; // ^^
 	Vec2d  front_vec_;
+
+	void updateIdIndex();
 };
@@ -131,6 +131,7 @@ void MapSector::copy(MapObject* obj)
 	id_              = sector->id_;
 	floor_.plane.set(0, 0, 1, sector->floor_.height);
 	ceiling_.plane.set(0, 0, 1, sector->ceiling_.height);
+	updateIdIndex();
 
 	// Update texture counts (increment new)
 	if (parent_map_)
@@ -151,6 +152,15 @@ void MapSector::setGeometryUpdated()
 	geometry_updated_ = App::runTimer();
 }
 
+// -----------------------------------------------------------------------------
+// Updates the sector in the map's tag index, after its tag was changed
+// -----------------------------------------------------------------------------
+void MapSector::updateIdIndex()
+{
+	if (parent_map_)
+		parent_map_->sectors().updateIdIndex(this);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the value of the string property matching [key]
 // -----------------------------------------------------------------------------
@@ -235,7 +245,10 @@ void MapSector::setIntProperty(string_view key, int value)
 	else if (key == PROP_SPECIAL)
 		special_ = value;
 	else if (key == PROP_ID)
+	{
 		id_ = value;
+		updateIdIndex();
+	}
 	else
 		MapObject::setIntProperty(key, value);
 }
@@ -331,6 +344,7 @@ void MapSector::setTag(int tag)
 {
 	setModified();
 	id_ = tag;
+	updateIdIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -353,6 +367,18 @@ Vec2d MapSector::getPoint(Point point)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Resets the sector's bounding box, so that it is recalculated when next needed
+// -----------------------------------------------------------------------------
+void MapSector::resetBBox()
+{
+	bbox_.reset();
+
+	// Update spatial index
+	if (parent_map_)
+		parent_map_->sectors().updateSpatialIndex(this);
+}
+
 // -----------------------------------------------------------------------------
 // Calculates the sector's bounding box
 // -----------------------------------------------------------------------------
@@ -827,7 +853,7 @@ void MapSector::connectSide(MapSide* side)
 	setModified();
 	connected_sides_.push_back(side);
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
@@ -847,7 +873,7 @@ void MapSector::disconnectSide(MapSide* side)
 	}
 
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
@@ -883,6 +909,7 @@ void MapSector::readBackup(Backup* backup)
 	light_   = backup->props_internal[PROP_LIGHTLEVEL].intValue();
 	special_ = backup->props_internal[PROP_SPECIAL].intValue();
 	id_      = backup->props_internal[PROP_ID].intValue();
+	updateIdIndex();
 
 	// Update texture counts (increment new)
 	parent_map_->sectors().updateTexUsage(floor_.texture, 1);
@@ -890,7 +917,7 @@ void MapSector::readBackup(Backup* backup)
 
 	// Update geometry info
 	poly_needsupdate_ = true;
-	bbox_.reset();
+	resetBBox();
 	setGeometryUpdated();
 }
 
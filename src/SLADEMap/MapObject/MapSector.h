@@ -81,7 +81,7 @@ public:
 	template<SurfaceType p> void  setPlane(const Plane& plane);
 
 	Vec2d             getPoint(Point point) override;
-	void              resetBBox() { bbox_.reset(); }
+	void              resetBBox();
 	BBox              boundingBox();
 	vector<MapSide*>& connectedSides() { return connected_sides_; }
 	void              resetPolygon() { poly_needsupdate_ = true; }
@@ -134,6 +134,7 @@ private:
 	Vec2d            text_point_;
 
 	void setGeometryUpdated();
+	void updateIdIndex();
 };
 
 // Note: these MUST be inline, or the linker will complain
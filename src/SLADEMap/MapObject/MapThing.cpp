@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "MapThing.h"
+#include "SLADEMap/SLADEMap.h"
 #include "Utility/Parser.h"
 
 
@@ -170,9 +171,15 @@ void MapThing::setIntProperty(string_view key, int value)
 	if (key == PROP_TYPE)
 		type_ = value;
 	else if (key == PROP_X)
+	{
 		position_.x = value;
+		updateSpatialIndex();
+	}
 	else if (key == PROP_Y)
+	{
 		position_.y = value;
+		updateSpatialIndex();
+	}
 	else if (key == PROP_Z)
 		z_ = value;
 	else if (key == PROP_ANGLE)
@@ -180,17 +187,35 @@ void MapThing::setIntProperty(string_view key, int value)
 	else if (key == PROP_FLAGS)
 		flags_ = value;
 	else if (key == PROP_ARG0)
+	{
 		args_[0] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG1)
+	{
 		args_[1] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG2)
+	{
 		args_[2] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG3)
+	{
 		args_[3] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ARG4)
+	{
 		args_[4] = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_ID)
+	{
 		id_ = value;
+		updateIdIndex();
+	}
 	else if (key == PROP_SPECIAL)
 		special_ = value;
 	else
@@ -206,9 +231,15 @@ void MapThing::setFloatProperty(string_view key, double value)
 	setModified();
 
 	if (key == PROP_X)
+	{
 		position_.x = value;
+		updateSpatialIndex();
+	}
 	else if (key == PROP_Y)
+	{
 		position_.y = value;
+		updateSpatialIndex();
+	}
 	else if (key == PROP_Z)
 		z_ = value;
 	else
@@ -235,6 +266,8 @@ void MapThing::copy(MapObject* c)
 	special_    = thing->special_;
 	for (unsigned i = 0; i < 5; ++i)
 		args_[i] = thing->args_[i];
+	updateSpatialIndex();
+	updateIdIndex();
 
 	// Other properties
 	MapObject::copy(c);
@@ -249,6 +282,7 @@ void MapThing::move(Vec2d pos, bool modify)
 	if (modify)
 		setModified();
 	position_ = pos;
+	updateSpatialIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -324,6 +358,7 @@ void MapThing::setId(int id)
 {
 	setModified();
 	id_ = id;
+	updateIdIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -362,6 +397,7 @@ void MapThing::setArg(unsigned index, int value)
 	{
 		setModified();
 		args_[index] = value;
+		updateIdIndex();
 	}
 }
 
@@ -412,6 +448,27 @@ void MapThing::readBackup(Backup* backup)
 	args_[4]    = backup->props_internal[PROP_ARG4].intValue();
 	id_         = backup->props_internal[PROP_ID].intValue();
 	special_    = backup->props_internal[PROP_SPECIAL].intValue();
+
+	updateSpatialIndex();
+	updateIdIndex();
+}
+
+// -----------------------------------------------------------------------------
+// Updates the thing in the map's spatial index, after its position was changed
+// -----------------------------------------------------------------------------
+void MapThing::updateSpatialIndex()
+{
+	if (parent_map_)
+		parent_map_->things().updateSpatialIndex(this);
+}
+
+// -----------------------------------------------------------------------------
+// Updates the thing in the map's id indices, after its id or args were changed
+// -----------------------------------------------------------------------------
+void MapThing::updateIdIndex()
+{
+	if (parent_map_)
+		parent_map_->things().updateIdIndex(this);
 }
 
 // -----------------------------------------------------------------------------
@@ -91,4 +91,7 @@ private:
 	ArgSet args_    = {};
 	int    id_      = 0;
 	int    special_ = 0;
+
+	void updateSpatialIndex();
+	void updateIdIndex();
 };
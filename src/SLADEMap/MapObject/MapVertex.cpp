@@ -89,6 +89,7 @@ void MapVertex::move(double nx, double ny)
 	for (auto& connected_line : connected_lines_)
 		connected_line->resetInternals();
 
+	updateSpatialIndex();
 	parent_map_->setGeometryUpdated();
 }
 
@@ -140,6 +141,8 @@ void MapVertex::setIntProperty(string_view key, int value)
 	}
 	else
 		return MapObject::setIntProperty(key, value);
+
+	updateSpatialIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -156,6 +159,8 @@ void MapVertex::setFloatProperty(string_view key, double value)
 		position_.y = value;
 	else
 		return MapObject::setFloatProperty(key, value);
+
+	updateSpatialIndex();
 }
 
 // -----------------------------------------------------------------------------
@@ -221,6 +226,22 @@ void MapVertex::readBackup(Backup* backup)
 	// Position
 	position_.x = backup->props_internal[PROP_X].floatValue();
 	position_.y = backup->props_internal[PROP_Y].floatValue();
+
+	updateSpatialIndex();
+}
+
+// -----------------------------------------------------------------------------
+// Updates the vertex and its connected lines in the map's spatial indices,
+// after the vertex position was changed
+// -----------------------------------------------------------------------------
+void MapVertex::updateSpatialIndex()
+{
+	if (!parent_map_)
+		return;
+
+	parent_map_->vertices().updateSpatialIndex(this);
+	for (auto& connected_line : connected_lines_)
+		parent_map_->lines().updateSpatialIndex(connected_line);
 }
 
 // -----------------------------------------------------------------------------
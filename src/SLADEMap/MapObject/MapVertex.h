@@ -59,4 +59,6 @@ private:
 
 	// Internal info
 	vector<MapLine*> connected_lines_;
+
+	void updateSpatialIndex();
 };
@@ -67,117 +67,92 @@ void MapObjectCollection::removeMapObject(MapObject* object)
 }
 
 // -----------------------------------------------------------------------------
-// Adds all object ids of [type] currently in the map to [list]
+// Begins recording changes to all object lists, so that the objects created
+// and deleted can be retrieved afterwards via putListChanges
 // -----------------------------------------------------------------------------
-void MapObjectCollection::putObjectIdList(MapObject::Type type, vector<unsigned>& list) const
+void MapObjectCollection::beginListChangeRecord()
 {
-	if (type == MapObject::Type::Vertex)
-	{
-		for (auto& vertex : vertices_)
-			list.push_back(vertex->obj_id_);
-	}
-	else if (type == MapObject::Type::Line)
-	{
-		for (auto& line : lines_)
-			list.push_back(line->obj_id_);
-	}
-	else if (type == MapObject::Type::Side)
-	{
-		for (auto& side : sides_)
-			list.push_back(side->obj_id_);
-	}
-	else if (type == MapObject::Type::Sector)
-	{
-		for (auto& sector : sectors_)
-			list.push_back(sector->obj_id_);
-	}
-	else if (type == MapObject::Type::Thing)
+	vertices_.beginChangeRecord();
+	sides_.beginChangeRecord();
+	lines_.beginChangeRecord();
+	sectors_.beginChangeRecord();
+	things_.beginChangeRecord();
+}
+
+// -----------------------------------------------------------------------------
+// Ends recording changes to the [type] object list, and writes the changes
+// made since beginListChangeRecord was called to [changes]
+// -----------------------------------------------------------------------------
+void MapObjectCollection::putListChanges(MapObject::Type type, MapObjectListChanges& changes)
+{
+	switch (type)
 	{
-		for (auto& thing : things_)
-			list.push_back(thing->obj_id_);
+	case MapObject::Type::Vertex: vertices_.endChangeRecord(changes); break;
+	case MapObject::Type::Side: sides_.endChangeRecord(changes); break;
+	case MapObject::Type::Line: lines_.endChangeRecord(changes); break;
+	case MapObject::Type::Sector: sectors_.endChangeRecord(changes); break;
+	case MapObject::Type::Thing: things_.endChangeRecord(changes); break;
+	default: break;
 	}
 }
 
 // -----------------------------------------------------------------------------
-// Add all object ids in [list] to the map as [type], clearing any objects of
-// [type] currently in the map
+// Reverts (if [undo] is true) or re-applies the recorded [changes] to the
+// [type] object list
 // -----------------------------------------------------------------------------
-void MapObjectCollection::restoreObjectIdList(MapObject::Type type, vector<unsigned>& list)
+void MapObjectCollection::applyListChanges(MapObject::Type type, const MapObjectListChanges& changes, bool undo)
 {
-	if (type == MapObject::Type::Vertex)
+	switch (type)
 	{
-		// Clear
-		for (auto& vertex : vertices_)
-			objects_[vertex->obj_id_].in_map = false;
-		vertices_.clear();
-
-		// Restore
-		for (auto id : list)
-		{
-			objects_[id].in_map = true;
-			vertices_.add(dynamic_cast<MapVertex*>(objects_[id].object.get()));
-			vertices_.last()->index_ = vertices_.size() - 1;
-		}
+	case MapObject::Type::Vertex: applyListChanges(vertices_, changes, undo); break;
+	case MapObject::Type::Side: applyListChanges(sides_, changes, undo); break;
+	case MapObject::Type::Line: applyListChanges(lines_, changes, undo); break;
+	case MapObject::Type::Sector: applyListChanges(sectors_, changes, undo); break;
+	case MapObject::Type::Thing: applyListChanges(things_, changes, undo); break;
+	default: break;
 	}
-	else if (type == MapObject::Type::Line)
-	{
-		// Clear
-		for (auto& line : lines_)
-			objects_[line->obj_id_].in_map = false;
-		lines_.clear();
+}
 
-		// Restore
-		for (auto id : list)
-		{
-			objects_[id].in_map = true;
-			lines_.add(dynamic_cast<MapLine*>(objects_[id].object.get()));
-			lines_.back()->index_ = lines_.size() - 1;
-		}
-	}
-	else if (type == MapObject::Type::Side)
-	{
-		// Clear
-		for (auto& side : sides_)
-			objects_[side->obj_id_].in_map = false;
-		sides_.clear();
+// -----------------------------------------------------------------------------
+// Reverts (if [undo] is true) or re-applies the recorded [changes] to [list]
+// -----------------------------------------------------------------------------
+template<class T>
+void MapObjectCollection::applyListChanges(MapObjectList<T>& list, const MapObjectListChanges& changes, bool undo)
+{
+	unsigned size = undo ? changes.size_before : changes.size_after;
 
-		// Restore
-		for (auto id : list)
-		{
-			objects_[id].in_map = true;
-			sides_.add(dynamic_cast<MapSide*>(objects_[id].object.get()));
-			sides_.back()->index_ = sides_.size() - 1;
-		}
-	}
-	else if (type == MapObject::Type::Sector)
+	// Take out all objects at changed indices first, since an object can be
+	// moved from one index to another (removing an object from a list moves
+	// the last object into its place)
+	for (const auto& change : changes.changes)
 	{
-		// Clear
-		for (auto& sector : sectors_)
-			objects_[sector->obj_id_].in_map = false;
-		sectors_.clear();
-
-		// Restore
-		for (auto id : list)
-		{
-			objects_[id].in_map = true;
-			sectors_.add(dynamic_cast<MapSector*>(objects_[id].object.get()));
-			sectors_.back()->index_ = sectors_.size() - 1;
-		}
+		auto id = undo ? change.id_after : change.id_before;
+		if (id > 0)
+			objects_[id].in_map = false;
 	}
-	else if (type == MapObject::Type::Thing)
+	while (list.size() > size)
+		list.remove(list.size() - 1);
+	for (const auto& change : changes.changes)
+		if (change.index < list.size())
+			list.replace(change.index, nullptr);
+
+	// Put in the objects for the new state (changes are ordered by index, so
+	// any added to the end of the list are added in order)
+	for (const auto& change : changes.changes)
 	{
-		// Clear
-		for (auto& thing : things_)
-			objects_[thing->obj_id_].in_map = false;
-		things_.clear();
+		auto id = undo ? change.id_before : change.id_after;
+		if (id == 0)
+			continue;
 
-		// Restore
-		for (auto id : list)
+		auto object = dynamic_cast<T*>(objects_[id].object.get());
+		if (change.index < list.size())
+			list.replace(change.index, object);
+		else
 		{
-			objects_[id].in_map = true;
-			things_.add(dynamic_cast<MapThing*>(objects_[id].object.get()));
-			things_.back()->index_ = things_.size() - 1;
+			object->index_ = list.size();
+			list.add(object);
 		}
+		objects_[id].in_map = true;
 	}
 }
 
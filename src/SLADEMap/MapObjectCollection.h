@@ -31,8 +31,9 @@ public:
 	void       addMapObject(unique_ptr<MapObject> object);
 	void       removeMapObject(MapObject* object);
 	MapObject* getObjectById(unsigned id) const { return objects_[id].object.get(); }
-	void       putObjectIdList(MapObject::Type type, vector<unsigned>& list) const;
-	void       restoreObjectIdList(MapObject::Type type, vector<unsigned>& list);
+	void       beginListChangeRecord();
+	void       putListChanges(MapObject::Type type, MapObjectListChanges& changes);
+	void       applyListChanges(MapObject::Type type, const MapObjectListChanges& changes, bool undo);
 
 	void refreshIndices();
 	void clear();
@@ -95,4 +96,6 @@ private:
 	LineList                lines_;
 	SectorList              sectors_;
 	ThingList               things_;
+
+	template<class T> void applyListChanges(MapObjectList<T>& list, const MapObjectListChanges& changes, bool undo);
 };
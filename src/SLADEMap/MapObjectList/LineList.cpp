@@ -45,18 +45,127 @@
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// LineList class constructor
+// -----------------------------------------------------------------------------
+LineList::LineList() :
+	grid_{ 256., [](MapObject* object) {
+			  auto seg = static_cast<MapLine*>(object)->seg();
+			  BBox bbox;
+			  bbox.min = { seg.left(), seg.top() };
+			  bbox.max = { seg.right(), seg.bottom() };
+			  return bbox;
+		  } },
+	ids_{ [](MapObject* object, vector<int>& keys) { keys.push_back(static_cast<MapLine*>(object)->id()); } },
+	arg_ids_{ [](MapObject* object, vector<int>& keys) {
+		auto line = static_cast<MapLine*>(object);
+		for (auto arg : line->args())
+			if (arg != 0)
+				keys.push_back(arg);
+		if (line->arg(0) < 0)
+			keys.push_back(-line->arg(0));
+	} }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial/id indices)
+// -----------------------------------------------------------------------------
+void LineList::clear()
+{
+	grid_.clear();
+	ids_.clear();
+	arg_ids_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [line] to the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void LineList::add(MapLine* line)
+{
+	grid_.add(line);
+	ids_.add(line);
+	arg_ids_.add(line);
+	MapObjectList::add(line);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the line at [index] from the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void LineList::remove(unsigned index)
+{
+	if (index < count_)
+	{
+		grid_.remove(objects_[index]);
+		ids_.remove(objects_[index]);
+		arg_ids_.remove(objects_[index]);
+	}
+
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last line from the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void LineList::removeLast()
+{
+	grid_.remove(objects_.back());
+	ids_.remove(objects_.back());
+	arg_ids_.remove(objects_.back());
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Replaces the line at [index] with [line], updating the spatial/id indices
+// -----------------------------------------------------------------------------
+void LineList::replace(unsigned index, MapLine* line)
+{
+	if (objects_[index])
+	{
+		grid_.remove(objects_[index]);
+		ids_.remove(objects_[index]);
+		arg_ids_.remove(objects_[index]);
+	}
+	if (line)
+	{
+		grid_.add(line);
+		ids_.add(line);
+		arg_ids_.add(line);
+	}
+
+	MapObjectList::replace(index, line);
+}
+
+// -----------------------------------------------------------------------------
+// Marks [line] as needing to be re-indexed in the id indices (should be called
+// when its id or args change)
+// -----------------------------------------------------------------------------
+void LineList::updateIdIndex(MapLine* line) const
+{
+	ids_.update(line);
+	arg_ids_.update(line);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the line closest to the point, or null if none is found.
 // Ignores lines further away than [mindist]
 // -----------------------------------------------------------------------------
 MapLine* LineList::nearest(Vec2d point, double min) const
 {
+	// Get lines within [min] of the point
+	vector<MapObject*> candidates;
+	if (!grid_.query(point, min, candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
 	// Go through lines
 	double   dist;
 	double   min_dist = min;
 	MapLine* nearest  = nullptr;
-	for (const auto& line : objects_)
+	for (auto object : candidates)
 	{
+		auto line = static_cast<MapLine*>(object);
+
 		// Check with line bounding box first (since we have a minimum distance)
 		auto bbox = line->seg();
 		bbox.expand(min, min);
@@ -102,9 +211,16 @@ vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
 	vector<Vec2d> intersect_points;
 	Vec2d         intersection;
 
+	// Get lines within the cutting line's bounding box
+	vector<MapObject*> candidates;
+	if (!grid_.query(cutter.left(), cutter.top(), cutter.right(), cutter.bottom(), candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
 	// Go through map lines
-	for (const auto& line : objects_)
+	for (auto object : candidates)
 	{
+		auto line = static_cast<MapLine*>(object);
+
 		// Check for intersection
 		intersection = cutter.start();
 		if (MathStuff::linesIntersect(cutter, line->seg(), intersection))
@@ -159,11 +275,8 @@ vector<Vec2d> LineList::cutPoints(const Seg2d& cutter) const
 // -----------------------------------------------------------------------------
 MapLine* LineList::firstWithId(int id) const
 {
-	for (auto& line : objects_)
-		if (line->id() == id)
-			return line;
-
-	return nullptr;
+	auto& lines = ids_.objects(id);
+	return lines.empty() ? nullptr : static_cast<MapLine*>(lines[0]);
 }
 
 // -----------------------------------------------------------------------------
@@ -171,9 +284,8 @@ MapLine* LineList::firstWithId(int id) const
 // -----------------------------------------------------------------------------
 void LineList::putAllWithId(int id, vector<MapLine*>& list) const
 {
-	for (auto& line : objects_)
-		if (line->id() == id)
-			list.push_back(line);
+	for (auto object : ids_.objects(id))
+		list.push_back(static_cast<MapLine*>(object));
 }
 
 // -----------------------------------------------------------------------------
@@ -194,11 +306,17 @@ void LineList::putAllTaggingWithId(int id, int type, vector<MapLine*>& list) con
 {
 	using Game::TagType;
 
-	// Find lines with special affecting matching id
+	// Nothing can match id 0
+	if (id == 0)
+		return;
+
+	// Find lines with special affecting matching id (only lines with an arg
+	// matching the id need to be checked)
 	int tag, arg2, arg3, arg4, arg5;
-	for (auto& line : objects_)
+	for (auto object : arg_ids_.objects(id))
 	{
-		int special = line->special();
+		auto line    = static_cast<MapLine*>(object);
+		int  special = line->special();
 		if (special)
 		{
 			tag       = line->arg(0);
@@ -295,16 +413,7 @@ int LineList::firstFreeId(MapFormat format) const
 
 	// UDMF (id property)
 	if (format == MapFormat::UDMF)
-	{
-		for (unsigned a = 0; a < count_; a++)
-		{
-			if (objects_[a]->id() == id)
-			{
-				id++;
-				a = 0;
-			}
-		}
-	}
+		id = ids_.firstFreeKey();
 
 	// Hexen (special 121 arg0)
 	else if (format == MapFormat::Hexen)
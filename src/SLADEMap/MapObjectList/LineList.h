@@ -1,12 +1,23 @@
 #pragma once
 
 #include "General/Defs.h"
+#include "MapObjectGrid.h"
+#include "MapObjectIdIndex.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapLine.h"
 
 class LineList : public MapObjectList<MapLine>
 {
 public:
+	LineList();
+
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapLine* line) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+	void replace(unsigned index, MapLine* line) override;
+
 	MapLine*         nearest(Vec2d point, double min = 64) const;
 	MapLine*         withVertices(MapVertex* v1, MapVertex* v2, bool reverse = true) const;
 	vector<Vec2d>    cutPoints(const Seg2d& cutter) const;
@@ -15,4 +26,12 @@ public:
 	vector<MapLine*> allWithId(int id) const;
 	void             putAllTaggingWithId(int id, int type, vector<MapLine*>& list) const;
 	int              firstFreeId(MapFormat format) const;
+
+	void updateSpatialIndex(MapLine* line) const { grid_.update(line); }
+	void updateIdIndex(MapLine* line) const;
+
+private:
+	mutable MapObjectGrid    grid_;
+	mutable MapObjectIdIndex ids_;
+	mutable MapObjectIdIndex arg_ids_;
 };
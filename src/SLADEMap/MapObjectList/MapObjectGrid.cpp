@@ -0,0 +1,260 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapObjectGrid.cpp
+// Description: A uniform grid spatial index of map objects, used to speed up
+//              position-based queries on map object lists (nearest object,
+//              object at point etc.). Objects are re-binned lazily: adding or
+//              updating an object only marks it dirty, and its bounds are
+//              recalculated on the next query
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapObjectGrid.h"
+#include "SLADEMap/MapObject/MapObject.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+constexpr int MAX_CELL_COORD   = 1 << 20; // Cell coordinates are clamped to this range
+constexpr int MAX_OBJECT_CELLS = 64;      // Objects covering more cells than this are kept in a separate list
+constexpr int MAX_QUERY_CELLS  = 1024;    // Queries covering more cells than this aren't done via the grid
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapObjectGrid Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapObjectGrid class constructor
+// -----------------------------------------------------------------------------
+MapObjectGrid::MapObjectGrid(double cell_size, BoundsFunc bounds_func) :
+	cell_size_{ cell_size },
+	bounds_func_{ std::move(bounds_func) }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Removes all objects from the grid
+// -----------------------------------------------------------------------------
+void MapObjectGrid::clear()
+{
+	entries_.clear();
+	cells_.clear();
+	large_.clear();
+	dirty_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to the grid. Its bounds are determined on the next query
+// -----------------------------------------------------------------------------
+void MapObjectGrid::add(MapObject* object)
+{
+	auto& entry = entries_[object];
+	if (!entry.dirty)
+	{
+		entry.dirty = true;
+		dirty_.push_back(object);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from the grid
+// -----------------------------------------------------------------------------
+void MapObjectGrid::remove(MapObject* object)
+{
+	auto i = entries_.find(object);
+	if (i == entries_.end())
+		return;
+
+	unlink(object, i->second);
+	entries_.erase(i);
+}
+
+// -----------------------------------------------------------------------------
+// Marks [object] as needing its bounds re-checked (eg. after it was moved).
+// Does nothing if the object isn't in the grid
+// -----------------------------------------------------------------------------
+void MapObjectGrid::update(MapObject* object)
+{
+	auto i = entries_.find(object);
+	if (i == entries_.end() || i->second.dirty)
+		return;
+
+	i->second.dirty = true;
+	dirty_.push_back(object);
+}
+
+// -----------------------------------------------------------------------------
+// Adds all objects in grid cells overlapping the area [x1,y1]-[x2,y2] to
+// [objects], sorted by index with no duplicates. The results may include
+// objects outside the area, so callers still need to check them.
+// Returns false if the area is too large to be worth querying via the grid, in
+// which case the caller should check all objects instead
+// -----------------------------------------------------------------------------
+bool MapObjectGrid::query(double x1, double y1, double x2, double y2, vector<MapObject*>& objects)
+{
+	int cx1 = cellCoord(std::min(x1, x2));
+	int cy1 = cellCoord(std::min(y1, y2));
+	int cx2 = cellCoord(std::max(x1, x2));
+	int cy2 = cellCoord(std::max(y1, y2));
+	if ((int64_t)(cx2 - cx1 + 1) * (cy2 - cy1 + 1) > MAX_QUERY_CELLS)
+		return false;
+
+	flush();
+
+	objects.clear();
+	objects.insert(objects.end(), large_.begin(), large_.end());
+	for (int y = cy1; y <= cy2; y++)
+		for (int x = cx1; x <= cx2; x++)
+		{
+			auto cell = cells_.find(cellKey(x, y));
+			if (cell != cells_.end())
+				objects.insert(objects.end(), cell->second.begin(), cell->second.end());
+		}
+
+	std::sort(objects.begin(), objects.end(), [](MapObject* left, MapObject* right) {
+		return left->index() < right->index();
+	});
+	objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Same as above, for the square area within [radius] of [point]
+// -----------------------------------------------------------------------------
+bool MapObjectGrid::query(Vec2d point, double radius, vector<MapObject*>& objects)
+{
+	return query(point.x - radius, point.y - radius, point.x + radius, point.y + radius, objects);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the grid cell coordinate containing [pos]
+// -----------------------------------------------------------------------------
+int MapObjectGrid::cellCoord(double pos) const
+{
+	double cell = std::floor(pos / cell_size_);
+	if (!(cell > -MAX_CELL_COORD)) // Also catches NaN
+		return -MAX_CELL_COORD;
+	if (cell > MAX_CELL_COORD)
+		return MAX_CELL_COORD;
+
+	return (int)cell;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to the grid cells covered by its current bounds
+// -----------------------------------------------------------------------------
+void MapObjectGrid::link(MapObject* object, Entry& entry)
+{
+	auto bbox = bounds_func_(object);
+	entry.x1  = cellCoord(bbox.min.x);
+	entry.y1  = cellCoord(bbox.min.y);
+	entry.x2  = cellCoord(bbox.max.x);
+	entry.y2  = cellCoord(bbox.max.y);
+
+	// Objects covering a lot of cells go in the 'large' list which is always
+	// included in query results
+	entry.large = (int64_t)(entry.x2 - entry.x1 + 1) * (entry.y2 - entry.y1 + 1) > MAX_OBJECT_CELLS;
+	if (entry.large)
+		large_.push_back(object);
+	else
+	{
+		for (int y = entry.y1; y <= entry.y2; y++)
+			for (int x = entry.x1; x <= entry.x2; x++)
+				cells_[cellKey(x, y)].push_back(object);
+	}
+
+	entry.in_cells = true;
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from the grid cells it was last added to
+// -----------------------------------------------------------------------------
+void MapObjectGrid::unlink(MapObject* object, Entry& entry)
+{
+	if (!entry.in_cells)
+		return;
+
+	auto remove_from = [object](vector<MapObject*>& list) {
+		auto i = std::find(list.begin(), list.end(), object);
+		if (i != list.end())
+		{
+			*i = list.back();
+			list.pop_back();
+		}
+	};
+
+	if (entry.large)
+		remove_from(large_);
+	else
+	{
+		for (int y = entry.y1; y <= entry.y2; y++)
+			for (int x = entry.x1; x <= entry.x2; x++)
+			{
+				auto cell = cells_.find(cellKey(x, y));
+				if (cell == cells_.end())
+					continue;
+
+				remove_from(cell->second);
+				if (cell->second.empty())
+					cells_.erase(cell);
+			}
+	}
+
+	entry.in_cells = false;
+}
+
+// -----------------------------------------------------------------------------
+// Re-bins all objects that were added or updated since the last query
+// -----------------------------------------------------------------------------
+void MapObjectGrid::flush()
+{
+	for (auto object : dirty_)
+	{
+		// Skip if removed since being marked dirty
+		auto i = entries_.find(object);
+		if (i == entries_.end() || !i->second.dirty)
+			continue;
+
+		unlink(object, i->second);
+		link(object, i->second);
+		i->second.dirty = false;
+	}
+
+	dirty_.clear();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+class MapObject;
+
+class MapObjectGrid
+{
+public:
+	typedef std::function<BBox(MapObject*)> BoundsFunc;
+
+	MapObjectGrid(double cell_size, BoundsFunc bounds_func);
+	~MapObjectGrid() = default;
+
+	void clear();
+	void add(MapObject* object);
+	void remove(MapObject* object);
+	void update(MapObject* object);
+
+	bool query(double x1, double y1, double x2, double y2, vector<MapObject*>& objects);
+	bool query(Vec2d point, double radius, vector<MapObject*>& objects);
+
+private:
+	struct Entry
+	{
+		int  x1, y1, x2, y2;
+		bool in_cells = false;
+		bool large    = false;
+		bool dirty    = false;
+	};
+
+	double                                            cell_size_;
+	BoundsFunc                                        bounds_func_;
+	std::unordered_map<MapObject*, Entry>             entries_;
+	std::unordered_map<uint64_t, vector<MapObject*>> cells_;
+	vector<MapObject*>                                large_;
+	vector<MapObject*>                                dirty_;
+
+	int      cellCoord(double pos) const;
+	uint64_t cellKey(int x, int y) const { return (uint64_t)(uint32_t)x << 32 | (uint32_t)y; }
+	void     link(MapObject* object, Entry& entry);
+	void     unlink(MapObject* object, Entry& entry);
+	void     flush();
+};
@@ -0,0 +1,215 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapObjectIdIndex.cpp
+// Description: An index of map objects by integer keys (ids, tags, args etc.),
+//              used to speed up id-based queries on map object lists. Like
+//              MapObjectGrid, objects are re-indexed lazily: adding or updating
+//              an object only marks it dirty, and its keys are recalculated on
+//              the next query
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapObjectIdIndex.h"
+#include "SLADEMap/MapObject/MapObject.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// MapObjectIdIndex Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MapObjectIdIndex class constructor
+// -----------------------------------------------------------------------------
+MapObjectIdIndex::MapObjectIdIndex(KeysFunc keys_func) : keys_func_{ std::move(keys_func) } {}
+
+// -----------------------------------------------------------------------------
+// Removes all objects from the index
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::clear()
+{
+	entries_.clear();
+	buckets_.clear();
+	dirty_.clear();
+	first_free_       = 1;
+	first_free_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to the index. Its keys are determined on the next query
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::add(MapObject* object)
+{
+	auto& entry = entries_[object];
+	if (!entry.dirty)
+	{
+		entry.dirty = true;
+		dirty_.push_back(object);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from the index
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::remove(MapObject* object)
+{
+	auto i = entries_.find(object);
+	if (i == entries_.end())
+		return;
+
+	unlink(object, i->second);
+	entries_.erase(i);
+}
+
+// -----------------------------------------------------------------------------
+// Marks [object] as needing its keys re-checked (eg. after its id changed).
+// Does nothing if the object isn't in the index
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::update(MapObject* object)
+{
+	auto i = entries_.find(object);
+	if (i == entries_.end() || i->second.dirty)
+		return;
+
+	i->second.dirty = true;
+	dirty_.push_back(object);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all objects with [key], sorted by index
+// -----------------------------------------------------------------------------
+const vector<MapObject*>& MapObjectIdIndex::objects(int key)
+{
+	static vector<MapObject*> no_objects;
+
+	flush();
+
+	auto bucket = buckets_.find(key);
+	if (bucket == buckets_.end())
+		return no_objects;
+
+	// Objects can be added out of order, and removing an object from a map
+	// object list changes the index of another, so sort here if needed
+	auto by_index = [](MapObject* left, MapObject* right) { return left->index() < right->index(); };
+	if (!std::is_sorted(bucket->second.begin(), bucket->second.end(), by_index))
+		std::sort(bucket->second.begin(), bucket->second.end(), by_index);
+
+	return bucket->second;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the lowest key (from 1 up) that no objects have
+// -----------------------------------------------------------------------------
+int MapObjectIdIndex::firstFreeKey()
+{
+	flush();
+
+	if (!first_free_valid_)
+	{
+		first_free_ = 1;
+		for (auto i = buckets_.lower_bound(1); i != buckets_.end() && i->first == first_free_; ++i)
+			++first_free_;
+
+		first_free_valid_ = true;
+	}
+
+	return first_free_;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [object] to the buckets for its current keys
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::link(MapObject* object, Entry& entry)
+{
+	entry.keys.clear();
+	keys_func_(object, entry.keys);
+	std::sort(entry.keys.begin(), entry.keys.end());
+	entry.keys.erase(std::unique(entry.keys.begin(), entry.keys.end()), entry.keys.end());
+
+	for (auto key : entry.keys)
+	{
+		auto& bucket = buckets_[key];
+		if (bucket.empty() && key == first_free_)
+			first_free_valid_ = false;
+
+		bucket.push_back(object);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Removes [object] from the buckets for the keys it was last added with
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::unlink(MapObject* object, Entry& entry)
+{
+	for (auto key : entry.keys)
+	{
+		auto bucket = buckets_.find(key);
+		if (bucket == buckets_.end())
+			continue;
+
+		auto& list = bucket->second;
+		auto  i    = std::find(list.begin(), list.end(), object);
+		if (i != list.end())
+		{
+			*i = list.back();
+			list.pop_back();
+		}
+
+		// Key is now unused
+		if (list.empty())
+		{
+			buckets_.erase(bucket);
+			if (first_free_valid_ && key >= 1 && key < first_free_)
+				first_free_ = key;
+		}
+	}
+
+	entry.keys.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Re-indexes all objects that were added or updated since the last query
+// -----------------------------------------------------------------------------
+void MapObjectIdIndex::flush()
+{
+	for (auto object : dirty_)
+	{
+		// Skip if removed since being marked dirty
+		auto i = entries_.find(object);
+		if (i == entries_.end() || !i->second.dirty)
+			continue;
+
+		unlink(object, i->second);
+		link(object, i->second);
+		i->second.dirty = false;
+	}
+
+	dirty_.clear();
+}
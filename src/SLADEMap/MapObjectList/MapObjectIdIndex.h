@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+class MapObject;
+
+class MapObjectIdIndex
+{
+public:
+	typedef std::function<void(MapObject*, vector<int>&)> KeysFunc;
+
+	MapObjectIdIndex(KeysFunc keys_func);
+	~MapObjectIdIndex() = default;
+
+	void clear();
+	void add(MapObject* object);
+	void remove(MapObject* object);
+	void update(MapObject* object);
+
+	const vector<MapObject*>& objects(int key);
+	int                       firstFreeKey();
+
+private:
+	struct Entry
+	{
+		vector<int> keys;
+		bool        dirty = false;
+	};
+
+	KeysFunc                              keys_func_;
+	std::unordered_map<MapObject*, Entry> entries_;
+	std::map<int, vector<MapObject*>>     buckets_;
+	vector<MapObject*>                    dirty_;
+	int                                   first_free_       = 1;
+	bool                                  first_free_valid_ = true;
+
+	void link(MapObject* object, Entry& entry);
+	void unlink(MapObject* object, Entry& entry);
+	void flush();
+};
@@ -2,6 +2,24 @@
 
 class MapObject;
 
+// Changes made to a map object list while recording (see beginChangeRecord),
+// as the object ids at each changed index before and after
+struct MapObjectListChanges
+{
+	struct Change
+	{
+		unsigned index;
+		unsigned id_before; // 0 = no object
+		unsigned id_after;  // ^^
+	};
+
+	unsigned       size_before = 0;
+	unsigned       size_after  = 0;
+	vector<Change> changes;
+
+	bool empty() const { return changes.empty(); }
+};
+
 template<class T> class MapObjectList
 {
 public:
@@ -22,8 +40,12 @@ public:
 	T*             at(unsigned index) const { return index < count_ ? objects_[index] : nullptr; }
 	virtual void   clear()
 	{
+		for (unsigned index = 0; index < count_; ++index)
+			recordChange(index);
+
 		objects_.clear();
 		count_ = 0;
+		++structure_version_;
 	}
 	T*   back() { return objects_.back(); }
 	bool empty() const { return count_ == 0; }
@@ -36,25 +58,70 @@ public:
 	// Modification
 	virtual void add(T* object)
 	{
+		recordChange(count_);
 		objects_.push_back(object);
 		++count_;
+		++structure_version_;
 	}
 	virtual void remove(unsigned index)
 	{
 		if (index < count_)
 		{
+			recordChange(index);
+			recordChange(count_ - 1);
 			objects_[index] = objects_.back();
 			objects_[index]->setIndex(index);
 			objects_.pop_back();
 			--count_;
+			++structure_version_;
 		}
 	}
 	virtual void removeLast()
 	{
+		recordChange(count_ - 1);
 		objects_.pop_back();
 		--count_;
+		++structure_version_;
+	}
+
+	// Sets the object at [index] to [object], which can be null temporarily
+	// while swapping objects around (eg. when undoing)
+	virtual void replace(unsigned index, T* object)
+	{
+		recordChange(index);
+		objects_[index] = object;
+		if (object)
+			object->setIndex(index);
+		++structure_version_;
 	}
 
+	// Change recording (used for undo/redo)
+	void beginChangeRecord()
+	{
+		recording_   = true;
+		record_size_ = count_;
+		record_ids_.clear();
+	}
+	void endChangeRecord(MapObjectListChanges& changes)
+	{
+		changes.size_before = record_size_;
+		changes.size_after  = count_;
+		changes.changes.clear();
+		for (const auto& record : record_ids_)
+		{
+			unsigned id_after = record.first < count_ ? objects_[record.first]->objId() : 0;
+			if (id_after != record.second)
+				changes.changes.push_back({ record.first, record.second, id_after });
+		}
+
+		recording_ = false;
+		record_ids_.clear();
+	}
+
+	// Incremented whenever objects are added, removed or moved to a different
+	// index, which doesn't change the modified time of the objects themselves
+	unsigned structureVersion() const { return structure_version_; }
+
 	// Misc
 	void putModifiedObjects(long since, vector<MapObject*>& modified_objects) const
 	{
@@ -74,4 +141,17 @@ public:
 protected:
 	vector<T*> objects_;
 	unsigned   count_ = 0;
+
+	// Records the id of the object originally at [index] (if recording)
+	void recordChange(unsigned index)
+	{
+		if (recording_ && record_ids_.find(index) == record_ids_.end())
+			record_ids_[index] = index < count_ && objects_[index] ? objects_[index]->objId() : 0;
+	}
+
+private:
+	bool                         recording_         = false;
+	unsigned                     record_size_       = 0;
+	std::map<unsigned, unsigned> record_ids_;
+	unsigned                     structure_version_ = 0;
 };
@@ -45,11 +45,22 @@
 
 
 // -----------------------------------------------------------------------------
-// Clears the list (and texture usage)
+// SectorList class constructor
+// -----------------------------------------------------------------------------
+SectorList::SectorList() :
+	grid_{ 512., [](MapObject* object) { return static_cast<MapSector*>(object)->boundingBox(); } },
+	ids_{ [](MapObject* object, vector<int>& keys) { keys.push_back(static_cast<MapSector*>(object)->tag()); } }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Clears the list (and texture usage, spatial/id indices)
 // -----------------------------------------------------------------------------
 void SectorList::clear()
 {
 	usage_tex_.clear();
+	grid_.clear();
+	ids_.clear();
 	MapObjectList::clear();
 }
 
@@ -62,6 +73,8 @@ void SectorList::add(MapSector* sector)
 	usage_tex_[StrUtil::upper(sector->floor().texture)] += 1;
 	usage_tex_[StrUtil::upper(sector->ceiling().texture)] += 1;
 
+	grid_.add(sector);
+	ids_.add(sector);
 	MapObjectList::add(sector);
 }
 
@@ -77,17 +90,60 @@ void SectorList::remove(unsigned index)
 	usage_tex_[StrUtil::upper(objects_[index]->floor().texture)] -= 1;
 	usage_tex_[StrUtil::upper(objects_[index]->ceiling().texture)] -= 1;
 
+	grid_.remove(objects_[index]);
+	ids_.remove(objects_[index]);
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Removes the last sector from the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void SectorList::removeLast()
+{
+	grid_.remove(objects_.back());
+	ids_.remove(objects_.back());
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Replaces the sector at [index] with [sector], updating texture usage and the
+// spatial/id indices
+// -----------------------------------------------------------------------------
+void SectorList::replace(unsigned index, MapSector* sector)
+{
+	if (auto old = objects_[index])
+	{
+		usage_tex_[StrUtil::upper(old->floor().texture)] -= 1;
+		usage_tex_[StrUtil::upper(old->ceiling().texture)] -= 1;
+		grid_.remove(old);
+		ids_.remove(old);
+	}
+	if (sector)
+	{
+		usage_tex_[StrUtil::upper(sector->floor().texture)] += 1;
+		usage_tex_[StrUtil::upper(sector->ceiling().texture)] += 1;
+		grid_.add(sector);
+		ids_.add(sector);
+	}
+
+	MapObjectList::replace(index, sector);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the sector at the given [point], or null if not within a sector
 // -----------------------------------------------------------------------------
 MapSector* SectorList::atPos(Vec2d point) const
 {
+	// Get sectors near the point
+	vector<MapObject*> candidates;
+	if (!grid_.query(point, 0, candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
 	// Go through sectors
-	for (const auto& sector : objects_)
+	for (auto object : candidates)
 	{
+		auto sector = static_cast<MapSector*>(object);
+
 		// Check if point is within sector
 		if (sector->containsPoint(point))
 			return sector;
@@ -156,9 +212,8 @@ void SectorList::initBBoxes()
 // -----------------------------------------------------------------------------
 void SectorList::putAllWithId(int id, vector<MapSector*>& list) const
 {
-	for (auto& sector : objects_)
-		if (sector->tag() == id)
-			list.push_back(sector);
+	for (auto object : ids_.objects(id))
+		list.push_back(static_cast<MapSector*>(object));
 }
 
 // -----------------------------------------------------------------------------
@@ -176,11 +231,8 @@ vector<MapSector*> SectorList::allWithId(int id) const
 // -----------------------------------------------------------------------------
 MapSector* SectorList::firstWithId(int id) const
 {
-	for (auto& sector : objects_)
-		if (sector->tag() == id)
-			return sector;
-
-	return nullptr;
+	auto& sectors = ids_.objects(id);
+	return sectors.empty() ? nullptr : static_cast<MapSector*>(sectors[0]);
 }
 
 // -----------------------------------------------------------------------------
@@ -188,17 +240,7 @@ MapSector* SectorList::firstWithId(int id) const
 // -----------------------------------------------------------------------------
 int SectorList::firstFreeId() const
 {
-	int id = 1;
-	for (unsigned i = 0; i < count_; ++i)
-	{
-		if (objects_[i]->tag() == id)
-		{
-			id++;
-			i = 0;
-		}
-	}
-
-	return id;
+	return ids_.firstFreeKey();
 }
 
 // -----------------------------------------------------------------------------
@@ -1,15 +1,21 @@
 #pragma once
 
+#include "MapObjectGrid.h"
+#include "MapObjectIdIndex.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapSector.h"
 
 class SectorList : public MapObjectList<MapSector>
 {
 public:
+	SectorList();
+
 	// MapObjectList overrides
 	void clear() override;
 	void add(MapSector* sector) override;
 	void remove(unsigned index) override;
+	void removeLast() override;
+	void replace(unsigned index, MapSector* sector) override;
 
 	MapSector*         atPos(Vec2d point) const;
 	BBox               allSectorBounds() const;
@@ -24,6 +30,11 @@ public:
 	void updateTexUsage(string_view tex, int adjust) const;
 	int  texUsageCount(string_view tex) const;
 
+	void updateSpatialIndex(MapSector* sector) const { grid_.update(sector); }
+	void updateIdIndex(MapSector* sector) const { ids_.update(sector); }
+
 private:
 	mutable std::map<string, int> usage_tex_;
+	mutable MapObjectGrid         grid_;
+	mutable MapObjectIdIndex      ids_;
 };
@@ -81,6 +81,27 @@ void SideList::remove(unsigned index)
 	MapObjectList::remove(index);
 }
 
+// -----------------------------------------------------------------------------
+// Replaces the side at [index] with [side] and updates texture usage
+// -----------------------------------------------------------------------------
+void SideList::replace(unsigned index, MapSide* side)
+{
+	if (auto old = objects_[index])
+	{
+		usage_tex_[StrUtil::upper(old->tex_upper_)] -= 1;
+		usage_tex_[StrUtil::upper(old->tex_middle_)] -= 1;
+		usage_tex_[StrUtil::upper(old->tex_lower_)] -= 1;
+	}
+	if (side)
+	{
+		usage_tex_[StrUtil::upper(side->tex_upper_)] += 1;
+		usage_tex_[StrUtil::upper(side->tex_middle_)] += 1;
+		usage_tex_[StrUtil::upper(side->tex_lower_)] += 1;
+	}
+
+	MapObjectList::replace(index, side);
+}
+
 // -----------------------------------------------------------------------------
 // Adjusts the usage count of [tex] by [adjust]
 // -----------------------------------------------------------------------------
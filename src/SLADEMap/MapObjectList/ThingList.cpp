@@ -45,18 +45,132 @@
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// ThingList class constructor
+// -----------------------------------------------------------------------------
+ThingList::ThingList() :
+	grid_{ 128., [](MapObject* object) {
+			  auto pos = static_cast<MapThing*>(object)->position();
+			  BBox bbox;
+			  bbox.min = pos;
+			  bbox.max = pos;
+			  return bbox;
+		  } },
+	ids_{ [](MapObject* object, vector<int>& keys) { keys.push_back(static_cast<MapThing*>(object)->id()); } },
+	arg_ids_{ [](MapObject* object, vector<int>& keys) {
+		// Patrol/interpolation things are matched on their own id
+		auto thing = static_cast<MapThing*>(object);
+		if (thing->id() != 0)
+			keys.push_back(thing->id());
+		for (auto arg : thing->args())
+			if (arg != 0)
+				keys.push_back(arg);
+		if (thing->arg(0) < 0)
+			keys.push_back(-thing->arg(0));
+	} }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial/id indices)
+// -----------------------------------------------------------------------------
+void ThingList::clear()
+{
+	grid_.clear();
+	ids_.clear();
+	arg_ids_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [thing] to the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void ThingList::add(MapThing* thing)
+{
+	grid_.add(thing);
+	ids_.add(thing);
+	arg_ids_.add(thing);
+	MapObjectList::add(thing);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the thing at [index] from the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void ThingList::remove(unsigned index)
+{
+	if (index < count_)
+	{
+		grid_.remove(objects_[index]);
+		ids_.remove(objects_[index]);
+		arg_ids_.remove(objects_[index]);
+	}
+
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last thing from the list and spatial/id indices
+// -----------------------------------------------------------------------------
+void ThingList::removeLast()
+{
+	grid_.remove(objects_.back());
+	ids_.remove(objects_.back());
+	arg_ids_.remove(objects_.back());
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Replaces the thing at [index] with [thing], updating the spatial/id indices
+// -----------------------------------------------------------------------------
+void ThingList::replace(unsigned index, MapThing* thing)
+{
+	if (objects_[index])
+	{
+		grid_.remove(objects_[index]);
+		ids_.remove(objects_[index]);
+		arg_ids_.remove(objects_[index]);
+	}
+	if (thing)
+	{
+		grid_.add(thing);
+		ids_.add(thing);
+		arg_ids_.add(thing);
+	}
+
+	MapObjectList::replace(index, thing);
+}
+
+// -----------------------------------------------------------------------------
+// Marks [thing] as needing to be re-indexed in the id indices (should be called
+// when its id or args change)
+// -----------------------------------------------------------------------------
+void ThingList::updateIdIndex(MapThing* thing) const
+{
+	ids_.update(thing);
+	arg_ids_.update(thing);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the thing closest to the point, or null if none found.
 // Igonres any thing further away than [min]
 // -----------------------------------------------------------------------------
 MapThing* ThingList::nearest(Vec2d point, double min) const
 {
+	// Only a thing within [min] can be returned, which will also be within
+	// [min * sqrt(2)] 'quick' distance, so get things near enough to that via
+	// the spatial index (or all things if the area is too big)
+	vector<MapObject*> candidates;
+	if (!grid_.query(point, min * 1.5, candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
 	// Go through things
 	double    dist;
 	double    min_dist = 999999999;
 	MapThing* nearest  = nullptr;
-	for (const auto& thing : objects_)
+	for (auto object : candidates)
 	{
+		auto thing = static_cast<MapThing*>(object);
+
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(thing->position());
 
@@ -88,11 +202,38 @@ vector<MapThing*> ThingList::multiNearest(Vec2d point) const
 {
 	vector<MapThing*> ret;
 
+	// Search the spatial index in increasingly large areas around [point] until
+	// a thing is found. Any thing outside the area will be further away than
+	// the area size, so once the nearest thing found is within that size (in
+	// 'quick' distance) it is the nearest overall
+	vector<MapObject*> candidates;
+	double             radius = 128.;
+	while (true)
+	{
+		if (!grid_.query(point, radius, candidates))
+		{
+			// Area too big, check all things
+			candidates.assign(objects_.begin(), objects_.end());
+			break;
+		}
+
+		double nearest_dist = 999999999;
+		for (auto object : candidates)
+			nearest_dist = std::min(nearest_dist, point.taxicabDistanceTo(static_cast<MapThing*>(object)->position()));
+
+		if (nearest_dist <= radius)
+			break;
+
+		radius *= 2;
+	}
+
 	// Go through things
 	double min_dist = 999999999;
 	double dist     = 0;
-	for (const auto& thing : objects_)
+	for (auto object : candidates)
 	{
+		auto thing = static_cast<MapThing*>(object);
+
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(thing->position());
 
@@ -131,9 +272,12 @@ BBox ThingList::allThingBounds() const
 // -----------------------------------------------------------------------------
 void ThingList::putAllWithId(int id, vector<MapThing*>& list, unsigned start, int type) const
 {
-	for (unsigned i = start; i < count_; ++i)
-		if (objects_[i]->id() == id && (type == 0 || objects_[i]->type() == type))
-			list.push_back(objects_[i]);
+	for (auto object : ids_.objects(id))
+	{
+		auto thing = static_cast<MapThing*>(object);
+		if (thing->index() >= start && (type == 0 || thing->type() == type))
+			list.push_back(thing);
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -153,18 +297,21 @@ vector<MapThing*> ThingList::allWithId(int id, unsigned start, int type) const
 // -----------------------------------------------------------------------------
 MapThing* ThingList::firstWithId(int id, unsigned start, int type, bool ignore_dragon) const
 {
-	for (unsigned i = start; i < count_; ++i)
-		if (objects_[i]->id() == id && (type == 0 || objects_[i]->type() == type))
+	for (auto object : ids_.objects(id))
+	{
+		auto thing = static_cast<MapThing*>(object);
+		if (thing->index() >= start && (type == 0 || thing->type() == type))
 		{
 			if (ignore_dragon)
 			{
-				auto& tt = Game::configuration().thingType(objects_[i]->type());
+				auto& tt = Game::configuration().thingType(thing->type());
 				if (tt.flags() & Game::ThingType::Flags::Dragon)
 					continue;
 			}
 
-			return objects_[i];
+			return thing;
 		}
+	}
 
 	return nullptr;
 }
@@ -191,10 +338,16 @@ void ThingList::putAllTaggingWithId(int id, int type, vector<MapThing*>& list, i
 {
 	using Game::TagType;
 
-	// Find things with special affecting matching id
+	// Nothing can match id 0
+	if (id == 0)
+		return;
+
+	// Find things with special affecting matching id (only things with an arg
+	// or id matching the id need to be checked)
 	int tag, arg2, arg3, arg4, arg5, tid;
-	for (auto& thing : objects_)
+	for (auto object : arg_ids_.objects(id))
 	{
+		auto  thing     = static_cast<MapThing*>(object);
 		auto& tt        = Game::configuration().thingType(thing->type());
 		auto  needs_tag = tt.needsTag();
 		if (needs_tag != TagType::None || (thing->special() && !(tt.flags() & Game::ThingType::Flags::Script)))
@@ -299,15 +452,5 @@ void ThingList::putAllTaggingWithId(int id, int type, vector<MapThing*>& list, i
 // -----------------------------------------------------------------------------
 int ThingList::firstFreeId() const
 {
-	int id = 1;
-	for (unsigned i = 0; i < count_; ++i)
-	{
-		if (objects_[i]->id() == id)
-		{
-			id++;
-			i = 0;
-		}
-	}
-
-	return id;
+	return ids_.firstFreeKey();
 }
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "MapObjectGrid.h"
+#include "MapObjectIdIndex.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapThing.h"
 
 class ThingList : public MapObjectList<MapThing>
 {
 public:
+	ThingList();
+
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapThing* thing) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+	void replace(unsigned index, MapThing* thing) override;
+
 	MapThing*         nearest(Vec2d point, double min = 64) const;
 	vector<MapThing*> multiNearest(Vec2d point) const;
 	BBox              allThingBounds() const;
@@ -15,4 +26,12 @@ public:
 	void              putAllPathed(vector<MapThing*>& list) const;
 	void              putAllTaggingWithId(int id, int type, vector<MapThing*>& list, int ttype) const;
 	int               firstFreeId() const;
+
+	void updateSpatialIndex(MapThing* thing) const { grid_.update(thing); }
+	void updateIdIndex(MapThing* thing) const;
+
+private:
+	mutable MapObjectGrid    grid_;
+	mutable MapObjectIdIndex ids_;
+	mutable MapObjectIdIndex arg_ids_;
 };
@@ -43,18 +43,92 @@
 // -----------------------------------------------------------------------------
 
 
+// -----------------------------------------------------------------------------
+// VertexList class constructor
+// -----------------------------------------------------------------------------
+VertexList::VertexList() :
+	grid_{ 128., [](MapObject* object) {
+			  auto pos = static_cast<MapVertex*>(object)->position();
+			  BBox bbox;
+			  bbox.min = pos;
+			  bbox.max = pos;
+			  return bbox;
+		  } }
+{
+}
+
+// -----------------------------------------------------------------------------
+// Clears the list (and spatial index)
+// -----------------------------------------------------------------------------
+void VertexList::clear()
+{
+	grid_.clear();
+	MapObjectList::clear();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [vertex] to the list and spatial index
+// -----------------------------------------------------------------------------
+void VertexList::add(MapVertex* vertex)
+{
+	grid_.add(vertex);
+	MapObjectList::add(vertex);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the vertex at [index] from the list and spatial index
+// -----------------------------------------------------------------------------
+void VertexList::remove(unsigned index)
+{
+	if (index < count_)
+		grid_.remove(objects_[index]);
+
+	MapObjectList::remove(index);
+}
+
+// -----------------------------------------------------------------------------
+// Removes the last vertex from the list and spatial index
+// -----------------------------------------------------------------------------
+void VertexList::removeLast()
+{
+	grid_.remove(objects_.back());
+	MapObjectList::removeLast();
+}
+
+// -----------------------------------------------------------------------------
+// Replaces the vertex at [index] with [vertex], updating the spatial index
+// -----------------------------------------------------------------------------
+void VertexList::replace(unsigned index, MapVertex* vertex)
+{
+	if (objects_[index])
+		grid_.remove(objects_[index]);
+	if (vertex)
+		grid_.add(vertex);
+
+	MapObjectList::replace(index, vertex);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the vertex closest to the point, or null if none found.
 // Igonres any vertices further away than [min]
 // -----------------------------------------------------------------------------
 MapVertex* VertexList::nearest(Vec2d point, double min) const
 {
+	// Only a vertex within [min] can be returned, which will also be within
+	// [min * sqrt(2)] 'quick' distance, so get vertices near enough to that via
+	// the spatial index (or all vertices if the area is too big)
+	vector<MapObject*> candidates;
+	if (!grid_.query(point, min * 1.5, candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
 	// Go through vertices
 	double     dist;
 	double     min_dist = 999999999;
 	MapVertex* nearest  = nullptr;
-	for (const auto& vertex : objects_)
+	for (auto object : candidates)
 	{
+		auto vertex = static_cast<MapVertex*>(object);
+
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicabDistanceTo(vertex->position());
 
@@ -83,9 +157,15 @@ MapVertex* VertexList::nearest(Vec2d point, double min) const
 // -----------------------------------------------------------------------------
 MapVertex* VertexList::vertexAt(double x, double y) const
 {
-	// Go through all vertices
-	for (auto& vertex : objects_)
+	// Get vertices near [x,y]
+	vector<MapObject*> candidates;
+	if (!grid_.query({ x, y }, 0, candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
+	// Go through them
+	for (auto object : candidates)
 	{
+		auto vertex = static_cast<MapVertex*>(object);
 		if (vertex->position_.x == x && vertex->position_.y == y)
 			return vertex;
 	}
@@ -99,12 +179,18 @@ MapVertex* VertexList::vertexAt(double x, double y) const
 // -----------------------------------------------------------------------------
 MapVertex* VertexList::firstCrossed(const Seg2d& line) const
 {
-	// Go through vertices
+	// Get vertices within the line's bounding box
+	vector<MapObject*> candidates;
+	if (!grid_.query(line.left(), line.top(), line.right(), line.bottom(), candidates))
+		candidates.assign(objects_.begin(), objects_.end());
+
+	// Go through them
 	MapVertex* cv       = nullptr;
 	double     min_dist = 999999;
-	for (const auto& vertex : objects_)
+	for (auto object : candidates)
 	{
-		auto point = vertex->position();
+		auto vertex = static_cast<MapVertex*>(object);
+		auto point  = vertex->position();
 
 		// Skip if outside line bbox
 		if (!line.contains(point))
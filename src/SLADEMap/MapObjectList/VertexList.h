@@ -1,12 +1,27 @@
 #pragma once
 
+#include "MapObjectGrid.h"
 #include "MapObjectList.h"
 #include "SLADEMap/MapObject/MapVertex.h"
 
 class VertexList : public MapObjectList<MapVertex>
 {
 public:
+	VertexList();
+
+	// MapObjectList overrides
+	void clear() override;
+	void add(MapVertex* vertex) override;
+	void remove(unsigned index) override;
+	void removeLast() override;
+	void replace(unsigned index, MapVertex* vertex) override;
+
 	MapVertex* nearest(Vec2d point, double min = 64) const;
 	MapVertex* vertexAt(double x, double y) const;
 	MapVertex* firstCrossed(const Seg2d& line) const;
+
+	void updateSpatialIndex(MapVertex* vertex) const { grid_.update(vertex); }
+
+private:
+	mutable MapObjectGrid grid_;
 };
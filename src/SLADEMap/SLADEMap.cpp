@@ -290,14 +290,11 @@ void SLADEMap::putThingsWithIdInSectorTag(int id, int tag, vector<MapThing*>& li
 		return;
 
 	// Find things with matching id contained in sector with matching tag
-	for (auto& thing : data_.things())
+	for (auto& thing : data_.things().allWithId(id))
 	{
-		if (thing->id() == id)
-		{
-			auto sector = data_.sectors().atPos(thing->position());
-			if (sector && sector->id_ == tag)
-				list.push_back(thing);
-		}
+		auto sector = data_.sectors().atPos(thing->position());
+		if (sector && sector->id_ == tag)
+			list.push_back(thing);
 	}
 }
 
@@ -539,7 +536,7 @@ MapVertex* SLADEMap::createVertex(Vec2d pos, double split_dist)
 	// Check if this vertex splits any lines (if needed)
 	if (split_dist >= 0)
 	{
-		auto lines = data_.lines();
+		auto lines = data_.lines().all();
 		for (auto line : lines)
 		{
 			// Skip line if it shares the vertex
@@ -674,6 +671,7 @@ void SLADEMap::mergeVertices(unsigned vertex1, unsigned vertex2)
 			line->vertex1_ = v1;
 			line->length_  = -1;
 			v1->connectLine(line);
+			data_.lines().updateSpatialIndex(line);
 		}
 
 		// Change second vertex if needed
@@ -683,6 +681,7 @@ void SLADEMap::mergeVertices(unsigned vertex1, unsigned vertex2)
 			line->vertex2_ = v1;
 			line->length_  = -1;
 			v1->connectLine(line);
+			data_.lines().updateSpatialIndex(line);
 		}
 
 		if (line->vertex1_ == v1 && line->vertex2_ == v1)
@@ -749,6 +748,7 @@ MapLine* SLADEMap::splitLine(MapLine* line, MapVertex* vertex)
 	line->vertex2_ = vertex;
 	vertex->connectLine(line);
 	line->length_ = -1;
+	data_.lines().updateSpatialIndex(line);
 
 	// Create and add new sides
 	MapSide* s1 = nullptr;
@@ -123,7 +123,6 @@ public:
 	// Misc. map data access
 	void rebuildConnectedLines() { data_.rebuildConnectedLines(); }
 	void rebuildConnectedSides() { data_.rebuildConnectedSides(); }
-	void restoreObjectIdList(MapObject::Type type, vector<unsigned>& list) { data_.restoreObjectIdList(type, list); }
 
 	// Convert
 	bool convertToHexen() const;
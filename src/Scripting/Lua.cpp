@@ -194,8 +194,8 @@ void Lua::showErrorDialog(wxWindow* parent, string_view title, string_view messa
 	// Get script log messages since the last script was started
 	auto   log = Log::since(script_start_time, Log::MessageType::Script);
 	string output;
-	for (auto msg : log)
-		output += msg->formattedMessageLine() + "\n";
+	for (const auto& msg : log)
+		output += msg.formattedMessageLine() + "\n";
 
 	ExtMessageDialog dlg(parent ? parent : current_window, WxUtils::strFromView(title));
 	dlg.setMessage(WxUtils::strFromView(message));
@@ -124,8 +124,8 @@ void ConsolePanel::update()
 	setupTextArea();
 
 	// Check if any new log messages were added since the last update
-	auto& log = Log::history();
-	if (log.size() <= next_message_index_)
+	auto log = Log::history(next_message_index_);
+	if (log.empty())
 	{
 		// None added, check again in 500ms
 		timer_update_.Start(500);
@@ -135,19 +135,19 @@ void ConsolePanel::update()
 	// Add new log messages to log text area
 	text_log_->SetEditable(true);
 	int line_no = next_message_index_ + 1;
-	for (auto a = next_message_index_; a < log.size(); ++a)
+	for (const auto& msg : log)
 	{
-		if (a > 0)
+		if (line_no > 1)
 			text_log_->AppendText("\n");
 
 		// Add message line + timestamp margin
-		text_log_->AppendText(log[a].message);
-		text_log_->MarginSetText(line_no, wxDateTime(log[a].timestamp).FormatISOTime());
+		text_log_->AppendText(msg.message);
+		text_log_->MarginSetText(line_no, wxDateTime(msg.timestamp).FormatISOTime());
 		text_log_->MarginSetStyle(line_no, wxSTC_STYLE_LINENUMBER);
 
 		// Set line colour depending on message type
 		text_log_->StartStyling(text_log_->GetLineEndPosition(line_no) - text_log_->GetLineLength(line_no), 0);
-		switch (log[a].type)
+		switch (msg.type)
 		{
 		case Log::MessageType::Error: text_log_->SetStyling(text_log_->GetLineLength(line_no), 200); break;
 		case Log::MessageType::Warning: text_log_->SetStyling(text_log_->GetLineLength(line_no), 201); break;
@@ -160,7 +160,7 @@ void ConsolePanel::update()
 	}
 	text_log_->SetEditable(false);
 
-	next_message_index_ = Log::history().size();
+	next_message_index_ += log.size();
 	text_log_->ScrollToEnd();
 
 	// Check again in 100ms
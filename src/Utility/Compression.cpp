@@ -155,6 +155,52 @@ bool Compression::zipDeflate(MemChunk& in, MemChunk& out, int level)
 	return Compression::genericDeflate(in, out, level, -MAX_WBITS, "ZipDeflate");
 }
 
+// -----------------------------------------------------------------------------
+// Inflates [in_size] bytes of zip (raw deflate) data from the current position
+// in [in] directly into [out], which must be exactly [out_size] bytes (the
+// known uncompressed size). The input is read in chunks, so large streams
+// (eg. from a file) don't need to be loaded into memory first.
+// Returns false if the stream is invalid or doesn't inflate to [out_size]
+// -----------------------------------------------------------------------------
+bool Compression::zipInflateStream(SeekableData& in, unsigned in_size, uint8_t* out, unsigned out_size)
+{
+	z_stream strm = {};
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+	{
+		Log::error("ZipInflateStream init error: {}", strm.msg ? strm.msg : "");
+		return false;
+	}
+
+	static const unsigned BUFFER_SIZE = 256 * 1024;
+	vector<uint8_t>       buffer(std::min(in_size, BUFFER_SIZE));
+	int                   ret = Z_OK;
+	strm.next_out             = out;
+	strm.avail_out            = out_size;
+	while (ret == Z_OK && in_size > 0)
+	{
+		// Read next chunk of input
+		unsigned count = std::min(in_size, BUFFER_SIZE);
+		if (!in.read(buffer.data(), count))
+			break;
+		in_size -= count;
+		strm.next_in  = buffer.data();
+		strm.avail_in = count;
+
+		// Inflate it
+		// (inflate returns Z_BUF_ERROR if no progress can be made, eg. if the
+		// inflated data would be larger than [out_size])
+		while (ret == Z_OK && strm.avail_in > 0)
+			ret = inflate(&strm, Z_NO_FLUSH);
+	}
+
+	bool ok = (ret == Z_STREAM_END || ret == Z_OK) && strm.total_out == out_size;
+	if (!ok)
+		Log::error("ZipInflateStream: Inflate error {}, got {} of {} bytes", ret, strm.total_out, out_size);
+
+	inflateEnd(&strm);
+	return ok;
+}
+
 // -----------------------------------------------------------------------------
 // Inflates the content of [in] as a gzip stream to [out].
 // GZip streams use a windowbits size of MAX_WBITS (15).
@@ -8,6 +8,7 @@ bool gzipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool gzipDeflate(MemChunk& in, MemChunk& out, int level = -1);
 bool zipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool zipDeflate(MemChunk& in, MemChunk& out, int level = -1);
+bool zipInflateStream(SeekableData& in, unsigned in_size, uint8_t* out, unsigned out_size);
 bool zlibInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 bool zlibDeflate(MemChunk& in, MemChunk& out, int level = -1);
 bool zipExplode(MemChunk& in, MemChunk& out, size_t size, int flags);
@@ -180,6 +180,25 @@ time_t FileUtil::fileModifiedTime(string_view path)
 	return static_cast<time_t>(fs::last_write_time(path).time_since_epoch().count());
 }
 
+// -----------------------------------------------------------------------------
+// Returns the size of the file at [path], or 0 if it doesn't exist
+// -----------------------------------------------------------------------------
+uint64_t FileUtil::fileSize(string_view path)
+{
+	std::error_code ec;
+	auto            size = fs::file_size(path, ec);
+	return ec ? 0 : size;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [path1] and [path2] refer to the same (existing) file
+// -----------------------------------------------------------------------------
+bool FileUtil::sameFile(string_view path1, string_view path2)
+{
+	std::error_code ec;
+	return fs::equivalent(path1, path2, ec);
+}
+
 
 
 // -----------------------------------------------------------------------------
@@ -13,6 +13,8 @@ bool           writeStringToFile(string& str, const string& path);
 bool           createDir(string_view path);
 vector<string> allFilesInDir(string_view path, bool include_subdirs = false, bool include_dir_paths = false);
 time_t         fileModifiedTime(string_view path);
+uint64_t       fileSize(string_view path);
+bool           sameFile(string_view path1, string_view path2);
 } // namespace FileUtil
 
 class SFile : public SeekableData
@@ -0,0 +1,165 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MappedFile.cpp
+// Description: MappedFile class - maps a file on disk into memory for reading.
+//              The mapping is copy-on-write, so any writes to the mapped data
+//              only affect this process' copy of the data, never the file
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MappedFile.h"
+#include "FileUtils.h"
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Maps the file at [path] into memory.
+// Returns false if the file couldn't be opened or mapped (empty files can't be
+// mapped)
+// -----------------------------------------------------------------------------
+bool MappedFile::open(const string& path)
+{
+	close();
+
+#ifdef __WXMSW__
+	// Open file (allowing writes so lumps can be appended to mapped wads, the
+	// mapping is copy-on-write and mapped data is never overwritten)
+	auto file = CreateFileW(
+		wxString::FromUTF8(path).wc_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	// Check size
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > 0xFFFFFFFF)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// Map it
+	auto mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	auto data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	file_handle_    = file;
+	mapping_handle_ = mapping;
+	size_           = static_cast<unsigned>(file_size.QuadPart);
+#else
+	// Open file
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	// Check size
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0 || file_stat.st_size > 0xFFFFFFFF)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// Map it (the file descriptor isn't needed once mapped)
+	auto data = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	size_ = static_cast<unsigned>(file_stat.st_size);
+#endif
+
+	data_ = static_cast<uint8_t*>(data);
+	path_ = path;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the mapped file is now smaller than the mapping.
+// This can happen if another program truncates or rewrites the file while it
+// is mapped (on POSIX systems at least, Windows doesn't allow it). Reading any
+// mapped page past the new end of the file then raises SIGBUS, so the mapping
+// must not be used for any data that hasn't already been copied from it
+// -----------------------------------------------------------------------------
+bool MappedFile::truncated() const
+{
+	return data_ && FileUtil::fileSize(path_) < size_;
+}
+
+// -----------------------------------------------------------------------------
+// Unmaps the file (if it is mapped)
+// -----------------------------------------------------------------------------
+void MappedFile::close()
+{
+	if (!data_)
+		return;
+
+#ifdef __WXMSW__
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_handle_);
+	CloseHandle(file_handle_);
+	mapping_handle_ = nullptr;
+	file_handle_    = nullptr;
+#else
+	munmap(data_, size_);
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+	path_.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	// Non-copyable
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool          isOpen() const { return data_ != nullptr; }
+	const string& path() const { return path_; }
+	uint8_t*      data() const { return data_; }
+	unsigned      size() const { return size_; }
+
+	bool open(const string& path);
+	void close();
+	bool truncated() const;
+
+private:
+	string   path_;
+	uint8_t* data_ = nullptr;
+	unsigned size_ = 0;
+
+#ifdef __WXMSW__
+	void* file_handle_    = nullptr;
+	void* mapping_handle_ = nullptr;
+#endif
+};
@@ -34,6 +34,15 @@
 #include "MemChunk.h"
 #include "FileUtils.h"
 #include "General/Misc.h"
+#include "MappedFile.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+thread_local int MemChunk::read_only_scopes_ = 0;
 
 
 // -----------------------------------------------------------------------------
@@ -70,7 +79,7 @@ MemChunk::MemChunk(const uint8_t* data, uint32_t size) : size_{ size }
 MemChunk::~MemChunk()
 {
 	// Free memory
-	delete[] data_;
+	freeData();
 }
 
 // -----------------------------------------------------------------------------
@@ -89,7 +98,7 @@ bool MemChunk::clear()
 {
 	if (hasData())
 	{
-		delete[] data_;
+		freeData();
 		data_    = nullptr;
 		size_    = 0;
 		cur_ptr_ = 0;
@@ -120,8 +129,8 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	// Preserve existing data if specified
 	if (preserve_data)
 	{
-		memcpy(ndata, data_, size_ * sizeof(uint8_t));
-		delete[] data_;
+		memcpy(ndata, data_, std::min(size_, new_size) * sizeof(uint8_t));
+		freeData();
 		data_ = ndata;
 	}
 	else
@@ -291,6 +300,52 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Sets the MemChunk data to [len] bytes of the memory-mapped [file], starting
+// at [offset]. The data is not copied, the MemChunk will just point to the
+// mapped data (and keep the mapping open) until it is modified via write,
+// reSize etc., at which point it will be copied (see detach)
+// -----------------------------------------------------------------------------
+bool MemChunk::importMapped(const shared_ptr<MappedFile>& file, uint32_t offset, uint32_t len)
+{
+	// Check file and range are valid
+	if (!file || !file->isOpen() || offset > file->size() || len > file->size() - offset)
+		return false;
+
+	// Clear current data if it exists
+	clear();
+
+	if (len > 0)
+	{
+		data_        = file->data() + offset;
+		size_        = len;
+		mapped_file_ = file;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// If the MemChunk data is a view into a mapped file (see importMapped), copies
+// it into memory owned by the MemChunk.
+// Returns false if the allocation failed
+// -----------------------------------------------------------------------------
+bool MemChunk::detach()
+{
+	if (!mapped_file_)
+		return true;
+
+	auto ndata = allocData(size_, false);
+	if (!ndata)
+		return false;
+
+	memcpy(ndata, data_, size_);
+	mapped_file_.reset();
+	data_ = ndata;
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Writes the MemChunk data to a new file of [filename], starting from [start]
 // to [start+size].
@@ -356,7 +411,7 @@ bool MemChunk::exportMemChunk(MemChunk& mc, uint32_t start, uint32_t size) const
 bool MemChunk::write(unsigned offset, const void* data, unsigned size, bool expand)
 {
 	// Check pointers
-	if (!data)
+	if (!data || !detach())
 		return false;
 
 	// If we're trying to write past the end of the memory chunk,
@@ -405,7 +460,7 @@ bool MemChunk::read(unsigned offset, void* buf, unsigned size) const
 bool MemChunk::write(const void* buffer, uint32_t count)
 {
 	// Check pointers
-	if (!buffer)
+	if (!buffer || !detach())
 		return false;
 
 	// If we're trying to write past the end of the memory chunk,
@@ -522,10 +577,10 @@ bool MemChunk::readMC(MemChunk& mc, uint32_t size)
 // Overwrites all data bytes with [val] (basically is memset).
 // Returns false if no data exists, true otherwise
 // -----------------------------------------------------------------------------
-bool MemChunk::fillData(uint8_t val) const
+bool MemChunk::fillData(uint8_t val)
 {
 	// Check data exists
-	if (!hasData())
+	if (!hasData() || !detach())
 		return false;
 
 	// Fill data with value
@@ -576,3 +631,15 @@ uint8_t* MemChunk::allocData(uint32_t size, bool set_data)
 
 	return ndata;
 }
+
+// -----------------------------------------------------------------------------
+// Frees the MemChunk data, or releases the mapped file if the data is a view
+// into one
+// -----------------------------------------------------------------------------
+void MemChunk::freeData()
+{
+	if (mapped_file_)
+		mapped_file_.reset();
+	else
+		delete[] data_;
+}
@@ -3,6 +3,7 @@
 #include "SeekableData.h"
 
 class SFile;
+class MappedFile;
 
 class MemChunk : public SeekableData
 {
@@ -12,11 +13,19 @@ public:
 	MemChunk(const uint8_t* data, uint32_t size);
 	~MemChunk();
 
-	uint8_t& operator[](int a) const { return data_[a]; }
+	// Non-const access to mapped data first copies it into owned memory (see
+	// detach), unless a ReadOnlyScope is active on the current thread
+	const uint8_t& operator[](int a) const { return data_[a]; }
+	uint8_t&       operator[](int a) { return data()[a]; }
 
 	// Accessors
 	const uint8_t* data() const { return data_; }
-	uint8_t*       data() { return data_; }
+	uint8_t*       data()
+	{
+		if (mapped_file_ && read_only_scopes_ == 0)
+			detach();
+		return data_;
+	}
 
 	// SeekableData
 	unsigned size() const override { return size_; }
@@ -28,6 +37,7 @@ public:
 	bool     write(const void* buffer, unsigned count) override;
 
 	bool hasData() const;
+	bool isMapped() const { return mapped_file_ != nullptr; }
 
 	bool clear();
 	bool reSize(uint32_t new_size, bool preserve_data = true);
@@ -38,6 +48,8 @@ public:
 	bool importFileStream(SFile& file, unsigned len = 0);
 	bool importMem(const uint8_t* start, uint32_t len);
 	bool importMem(const MemChunk& other) { return importMem(other.data_, other.size_); }
+	bool importMapped(const shared_ptr<MappedFile>& file, uint32_t offset, uint32_t len);
+	bool detach();
 
 	// Data export
 	bool exportFile(string_view filename, uint32_t start = 0, uint32_t size = 0) const;
@@ -56,7 +68,7 @@ public:
 	bool readMC(MemChunk& mc, uint32_t size);
 
 	// Misc
-	bool     fillData(uint8_t val) const;
+	bool     fillData(uint8_t val);
 	uint32_t crc() const;
 
 	// Platform-independent functions to read values in little (L##) or big (B##) endian
@@ -78,5 +90,26 @@ protected:
 	uint32_t cur_ptr_ = 0;
 	uint32_t size_    = 0;
 
+	// If set, data_ points into this mapped file rather than being owned by the MemChunk
+	shared_ptr<MappedFile> mapped_file_;
+
 	uint8_t* allocData(uint32_t size, bool set_data = true);
+	void     freeData();
+
+	static thread_local int read_only_scopes_;
+
+public:
+	// While one of these exists, non-const access to mapped data on the same
+	// thread won't copy it. For code that only reads data but takes non-const
+	// MemChunks (eg. EntryDataFormat::isThisFormat), so that it doesn't copy
+	// every mapped lump it looks at
+	class ReadOnlyScope
+	{
+	public:
+		ReadOnlyScope() { ++read_only_scopes_; }
+		~ReadOnlyScope() { --read_only_scopes_; }
+
+		ReadOnlyScope(const ReadOnlyScope&) = delete;
+		ReadOnlyScope& operator=(const ReadOnlyScope&) = delete;
+	};
 };
@@ -0,0 +1,138 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2019 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThreadPool.cpp
+// Description: Simple helpers for splitting independent work items across a
+//              number of worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThreadPool.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the number of worker threads to use for [requested] threads.
+// If [requested] is 0 or less, the number of hardware threads is used
+// -----------------------------------------------------------------------------
+unsigned ThreadPool::numThreads(int requested)
+{
+	if (requested > 0)
+		return requested;
+
+	auto hw_threads = std::thread::hardware_concurrency();
+	return hw_threads > 0 ? hw_threads : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Runs [func] once for each index from 0 to [count]-1, split across
+// [num_threads] worker threads. Indices are handed out in increasing order but
+// may complete in any order, so [func] must only touch data belonging to its
+// own index. Blocks until all indices have been processed, calling [progress]
+// (if given) on the calling thread every so often with the number of indices
+// completed so far.
+//
+// If only one thread is requested (or there is only one item) everything is
+// run on the calling thread instead
+// -----------------------------------------------------------------------------
+void ThreadPool::runParallel(
+	size_t                             count,
+	const std::function<void(size_t)>& func,
+	unsigned                           num_threads,
+	const std::function<void(size_t)>& progress)
+{
+	if (count == 0)
+		return;
+
+	// Run serially if there's no point spinning up threads
+	if (num_threads <= 1 || count == 1)
+	{
+		for (size_t a = 0; a < count; a++)
+		{
+			func(a);
+			if (progress && a % 64 == 0)
+				progress(a);
+		}
+		if (progress)
+			progress(count);
+		return;
+	}
+
+	if (num_threads > count)
+		num_threads = count;
+
+	std::atomic<size_t>     next_index{ 0 };
+	std::atomic<size_t>     num_done{ 0 };
+	std::mutex              mutex;
+	std::condition_variable cv_done;
+
+	// Start workers
+	vector<std::thread> workers;
+	workers.reserve(num_threads);
+	for (unsigned t = 0; t < num_threads; t++)
+	{
+		workers.emplace_back([&]() {
+			while (true)
+			{
+				auto index = next_index++;
+				if (index >= count)
+					break;
+
+				func(index);
+
+				if (++num_done == count)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					cv_done.notify_all();
+				}
+			}
+		});
+	}
+
+	// Wait for completion, reporting progress periodically
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (num_done < count)
+		{
+			cv_done.wait_for(lock, std::chrono::milliseconds(50), [&]() { return num_done >= count; });
+			if (progress)
+			{
+				lock.unlock();
+				progress(num_done);
+				lock.lock();
+			}
+		}
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+}
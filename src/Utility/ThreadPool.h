@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ThreadPool
+{
+unsigned numThreads(int requested = 0);
+
+void runParallel(
+	size_t                             count,
+	const std::function<void(size_t)>& func,
+	unsigned                           num_threads,
+	const std::function<void(size_t)>& progress = {});
+} // namespace ThreadPool